@@ -0,0 +1,180 @@
+/**
+  ******************************************************************************
+  * @file           : rollDb.hpp
+  * @brief          : rollTs C++ 便捷封装(仅头文件)
+  *
+  * - Backend：静态 Flash 策略类，提供 erase/write/read(及 lock/unlock)静态函数，
+  *            构造时填入 flash_ops_t，无需手写适配函数
+  *            静态调用：编译 rollTs.c 的编译单元在包含 rollTs.h 前把 ROLLTS_FLASH_* 宏定义为
+  *            Backend 静态函数，Flash 访问不经函数指针，Backend 为 inline 函数时可内联：
+  *              // rollts_flash.cpp，替代单独编译 core/rollTs.c
+  *              #include "board_flash.hpp"
+  *              #define ROLLTS_FLASH_ERASE(mgr, addr)             Flash::erase(addr)
+  *              #define ROLLTS_FLASH_WRITE(mgr, addr, data, len)  Flash::write(addr, data, len)
+  *              #define ROLLTS_FLASH_READ(mgr, addr, data, len)   Flash::read(addr, data, len)
+  *              #include "rollTs.c"
+  *            对比见 tools/rolldb_bench.cpp
+  * - Geometry：编译期 block 数，最小块数与地址范围由 static_assert 检查
+  * - Record：可平凡拷贝的定长记录类型，append/范围 for 按类型读写
+  *
+  * 使用示例：
+  *   struct Flash {
+  *       static int erase(uint32_t addr);
+  *       static int write(uint32_t addr, void *data, uint32_t len);
+  *       static int read(uint32_t addr, void *data, uint32_t len);
+  *       static void lock();      // RTOS_MUTEX_ENABLE 时需要
+  *       static void unlock();
+  *   };
+  *   struct Sample { uint32_t ts; int16_t temp; };
+  *   rolldb::Log<Flash, rolldb::Geometry<16>, Sample> log;
+  *   log.init();
+  *   log.append({now(), 215});
+  *   for (const auto &e : log) { use(e.seq, e.value); }
+  *
+  * @version        : 1.0.2
+  * @date           : 2025-12-10
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2025 ARSTUDIO.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+#ifndef ROLLDB_HPP
+#define ROLLDB_HPP
+
+#include <type_traits>
+#include "rollTs.h"
+
+namespace rolldb
+{
+
+/**
+ * 编译期几何参数
+ * block 大小固定为 SINGLE_BLOCK_SIZE，BlockNum 包含系统分区 block
+ */
+template <uint32_t BlockNum>
+struct Geometry
+{
+    static constexpr uint32_t block_size = SINGLE_BLOCK_SIZE;
+    static constexpr uint32_t block_num  = BlockNum;
+    static constexpr uint32_t size       = BlockNum * SINGLE_BLOCK_SIZE;
+
+    static_assert(BlockNum >= 5, "rollTs needs at least 5 blocks (sys + pre + head + backup + 1)");
+    static_assert((uint64_t)BlockNum * SINGLE_BLOCK_SIZE <= 0xFFFFFFFFull, "database exceeds 32-bit address space");
+};
+
+/**
+ * 读取到的一条记录
+ */
+template <class Record>
+struct Entry
+{
+    uint64_t                                seq;        // 全局序号
+    uint8_t                                 tag;
+    Record                                value;
+};
+
+/**
+ * 定长类型日志
+ */
+template <class Backend, class Geo, class Record>
+class Log
+{
+    static_assert(std::is_trivially_copyable<Record>::value, "Record must be trivially copyable");
+    static_assert(sizeof(Record) + sizeof(rollts_data_t) + sizeof(block_info_t) < Geo::block_size,
+                  "Record must fit in a single block");
+
+public:
+    typedef Entry<Record> value_type;
+
+    /**
+     * 从最旧到最新遍历(游标只读日志头，长度不等于 sizeof(Record) 的日志跳过)
+     */
+    class iterator
+    {
+    public:
+        iterator() : log_(nullptr) {}
+        explicit iterator(Log *log) : log_(log)
+        {
+            rollts_cursor_init(&cursor_);
+            advance();
+        }
+
+        const value_type &operator*() const { return entry_; }
+        const value_type *operator->() const { return &entry_; }
+        iterator &operator++()
+        {
+            advance();
+            return *this;
+        }
+        bool operator==(const iterator &other) const { return log_ == other.log_; }
+        bool operator!=(const iterator &other) const { return log_ != other.log_; }
+
+    private:
+        void advance()
+        {
+            rollts_record_info_t info;
+            while (rollts_cursor_next(&log_->mgr_, &cursor_, &info))
+            {
+                if (info.payload_len != sizeof(Record)
+                    || sizeof(Record) != rollts_read_record(&log_->mgr_, info.handle, 0,
+                                                            reinterpret_cast<uint8_t *>(&entry_.value), sizeof(Record)))
+                {
+                    continue;
+                }
+                entry_.seq = info.seq;
+                entry_.tag = info.tag;
+                return;
+            }
+            log_ = nullptr;
+        }
+
+        Log                                   *log_;
+        rollts_cursor_t                      cursor_;
+        value_type                            entry_;
+    };
+
+    Log()
+    {
+        memset(&mgr_, 0, sizeof(mgr_));
+        mgr_.flash_ops.erase_sector = &Backend::erase;
+        mgr_.flash_ops.write_data   = &Backend::write;
+        mgr_.flash_ops.read_data    = &Backend::read;
+#ifdef RTOS_MUTEX_ENABLE
+        mgr_.flash_ops.mutex_lock   = &Backend::lock;
+        mgr_.flash_ops.mutex_unlock = &Backend::unlock;
+#endif
+        mgr_.rollts_max_size        = Geo::size;
+    }
+    Log(const Log &) = delete;
+    Log &operator=(const Log &) = delete;
+
+    int      init()                                   { return rollts_init(&mgr_); }
+    bool     clear()                                  { return rollts_clear(&mgr_); }
+    bool     append(const Record &record, uint8_t tag = 0)
+    {
+        return rollts_add_tag(&mgr_, tag, const_cast<uint8_t *>(reinterpret_cast<const uint8_t *>(&record)),
+                              sizeof(Record));
+    }
+    int32_t  count()                                  { return rollts_get_total_record_number(&mgr_); }
+    uint64_t next_seq()                               { return rollts_next_seq(&mgr_); }
+
+    iterator begin()                                  { return iterator(this); }
+    iterator end()                                    { return iterator(); }
+
+    // 访问 C 接口(标签过滤、聚合、消费者等)
+    rollts_manager_t *native()                        { return &mgr_; }
+
+private:
+    rollts_manager_t                            mgr_;
+};
+
+} // namespace rolldb
+
+#endif // ROLLDB_HPP
@@ -20,8 +20,14 @@ extern "C" {
 
 // #define ROLLDB_LOG_DEBUG_ENABLE
 
+// 已开启等级的日志写入二进制跟踪缓冲(rollTrace.h)，不调用 ROLLDB_PRINTF
+// #define ROLLDB_LOG_TRACE_ENABLE
 
 
+#ifdef ROLLDB_LOG_TRACE_ENABLE
+#include "rollTrace.h"
+#endif
+
 #ifndef ROLLDB_PRINTF
 #define ROLLDB_PRINTF                     printf
 #endif
@@ -30,7 +36,9 @@ extern "C" {
 #undef  log_debug
 #endif
 
-#ifdef ROLLDB_LOG_DEBUG_ENABLE
+#if defined(ROLLDB_LOG_DEBUG_ENABLE) && defined(ROLLDB_LOG_TRACE_ENABLE)
+#define log_debug(...)                    ROLLTRACE_EMIT(ROLLTRACE_LEVEL_DEBUG, __VA_ARGS__)
+#elif defined(ROLLDB_LOG_DEBUG_ENABLE)
 #define log_debug(...)                    ROLLDB_PRINTF("ROLLDB[DEBUG]: "); ROLLDB_PRINTF(__VA_ARGS__);ROLLDB_PRINTF("\r\n")
 #else
 #define log_debug(...)
@@ -40,7 +48,9 @@ extern "C" {
 #ifdef  log_info
 #undef  log_info
 #endif
-#ifdef ROLLDB_LOG_INFO_ENABLE
+#if defined(ROLLDB_LOG_INFO_ENABLE) && defined(ROLLDB_LOG_TRACE_ENABLE)
+#define log_info(...)                     ROLLTRACE_EMIT(ROLLTRACE_LEVEL_INFO, __VA_ARGS__)
+#elif defined(ROLLDB_LOG_INFO_ENABLE)
 #define log_info(...)                     ROLLDB_PRINTF("ROLLDB[INFO]: ");  ROLLDB_PRINTF(__VA_ARGS__);ROLLDB_PRINTF("\r\n")
 #else
 #define log_info(...)
@@ -50,7 +60,9 @@ extern "C" {
 #ifdef  log_alt
 #undef  log_alt
 #endif
-#ifdef ROLLDB_LOG_ALT_ENABLE
+#if defined(ROLLDB_LOG_ALT_ENABLE) && defined(ROLLDB_LOG_TRACE_ENABLE)
+#define log_alt(...)                     ROLLTRACE_EMIT(ROLLTRACE_LEVEL_ALT, __VA_ARGS__)
+#elif defined(ROLLDB_LOG_ALT_ENABLE)
 #define log_alt(...)                     ROLLDB_PRINTF("ROLLDB[ALT]:(%s:%d) ", __func__, __LINE__);ROLLDB_PRINTF(__VA_ARGS__);ROLLDB_PRINTF("\r\n")
 #else
 #define log_alt(...)
@@ -61,7 +73,9 @@ extern "C" {
 #ifdef  log_error
 #undef  log_error
 #endif
-#ifdef ROLLDB_LOG_ERROR_ENABLE
+#if defined(ROLLDB_LOG_ERROR_ENABLE) && defined(ROLLDB_LOG_TRACE_ENABLE)
+#define log_error(...)                     ROLLTRACE_EMIT(ROLLTRACE_LEVEL_ERROR, __VA_ARGS__)
+#elif defined(ROLLDB_LOG_ERROR_ENABLE)
 #define log_error(...)                     ROLLDB_PRINTF("ROLLDB[ERROR]:(%s:%d) ", __func__, __LINE__);ROLLDB_PRINTF(__VA_ARGS__);ROLLDB_PRINTF("\r\n")
 #else
 #define log_error(...)
@@ -0,0 +1,656 @@
+/**
+  ******************************************************************************
+  * @file           : rollKv.c
+  * @brief          : 键值状态存储实现
+  *
+  * 记录追加写入当前 block，同一键以最新记录为准；删除写入删除记录。
+  * 挂载时按 block 启用序号从旧到新扫描，重建内存哈希索引。
+  * 当前 block 写满且只剩 1 个空闲 block 时，启用空闲 block，
+  * 将最旧 block 中索引仍指向的记录复制过去后擦除最旧 block。
+  *
+  * @version        : 1.0.1
+  * @date           : 2025-12-10
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2025 ARSTUDIO.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+#define ROLLTRACE_FILE_ID  2   // 跟踪事件源文件号(tools/rolltrace_decode.cpp)
+#include "rollKv.h"
+
+// 实例大小：管理单元未配置 max_size 时使用 ROLLKV_MAX_SIZE
+#define ROLLKV_CFG_MAX_SIZE(m)       ((m)->max_size ? (m)->max_size : ROLLKV_MAX_SIZE)
+
+#define ROLLKV_BLOCK_ADDR(block)     ((block) * SINGLE_BLOCK_SIZE)
+#define ROLLKV_DATA_ADDR(block)      (ROLLKV_BLOCK_ADDR(block) + sizeof(rollkv_block_t))
+
+/* function-------------------------------------------------------------------*/
+/**
+ * @func: FNV-1a 哈希
+ */
+static uint32_t kv_hash(const char *key, uint32_t key_len)
+{
+    uint32_t hash = 2166136261u;
+    for (uint32_t i = 0; i < key_len; i++)
+    {
+        hash ^= (uint8_t)key[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @func: 记录校验(CRC-32)
+ */
+static uint32_t kv_crc(const uint8_t *data, uint32_t len)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    for (uint32_t i = 0; i < len; i++)
+    {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+/**
+ * @func: 计算缓冲区中记录的校验值
+ */
+static uint32_t kv_entry_crc(const uint8_t *buf)
+{
+    const rollkv_entry_t *entry = (const rollkv_entry_t *)buf;
+    uint8_t head[4] = {entry->key_len, entry->flags,
+                       (uint8_t)(entry->val_len & 0xFF), (uint8_t)(entry->val_len >> 8)};
+    uint32_t crc = kv_crc(head, sizeof(head));
+    return crc ^ kv_crc(buf + sizeof(rollkv_entry_t), entry->key_len + entry->val_len);
+}
+
+/**
+ * @func: 读取一条记录到缓冲区
+ *        返回 1:有效记录 0:空位 -1:记录头损坏 -2:校验失败(写入中断，记录长度可用)
+ */
+static int kv_entry_read(rollkv_manager_t *rollkv_manager, uint32_t addr)
+{
+    rollkv_entry_t *entry = (rollkv_entry_t *)rollkv_manager->buf;
+    uint32_t block_end = (addr / SINGLE_BLOCK_SIZE + 1) * SINGLE_BLOCK_SIZE;
+    if (addr + sizeof(rollkv_entry_t) > block_end)
+    {
+        return 0;
+    }
+    if (0 != rollkv_manager->flash_ops.read_data(addr, entry, sizeof(rollkv_entry_t)))
+    {
+        return -1;
+    }
+    if (0xFF == entry->key_len)
+    {
+        return 0;
+    }
+    if (0 == entry->key_len || entry->key_len > ROLLKV_KEY_MAX || entry->val_len > ROLLKV_VALUE_MAX
+        || addr + ROLLKV_ENTRY_SIZE(entry->key_len, entry->val_len) > block_end)
+    {
+        return -1;
+    }
+    if (0 != rollkv_manager->flash_ops.read_data(addr + sizeof(rollkv_entry_t),
+                                                 rollkv_manager->buf + sizeof(rollkv_entry_t),
+                                                 entry->key_len + entry->val_len))
+    {
+        return -1;
+    }
+    return (entry->crc == kv_entry_crc(rollkv_manager->buf)) ? 1 : -2;
+}
+
+/**
+ * @func: 查找键所在索引槽
+ *        哈希与键长一致时读取 Flash 中的键比较，返回槽号，不存在返回 -1
+ */
+static int32_t index_find(rollkv_manager_t *rollkv_manager, const char *key, uint32_t key_len, uint32_t hash)
+{
+    for (uint32_t i = 0; i < ROLLKV_INDEX_SIZE; i++)
+    {
+        uint32_t pos = (hash + i) & (ROLLKV_INDEX_SIZE - 1);
+        rollkv_slot_t *slot = &rollkv_manager->index[pos];
+        if (ROLLKV_SLOT_EMPTY == slot->state)
+        {
+            break;
+        }
+        if (ROLLKV_SLOT_USED != slot->state || slot->hash != hash || slot->key_len != key_len)
+        {
+            continue;
+        }
+        if (0 == rollkv_manager->flash_ops.read_data(slot->addr + sizeof(rollkv_entry_t), rollkv_manager->buf, key_len)
+            && 0 == memcmp(rollkv_manager->buf, key, key_len))
+        {
+            return (int32_t)pos;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @func: 查找指向指定地址的索引槽(回收时判断记录是否有效，不读 Flash)
+ */
+static int32_t index_find_addr(rollkv_manager_t *rollkv_manager, uint32_t hash, uint32_t addr)
+{
+    for (uint32_t i = 0; i < ROLLKV_INDEX_SIZE; i++)
+    {
+        uint32_t pos = (hash + i) & (ROLLKV_INDEX_SIZE - 1);
+        rollkv_slot_t *slot = &rollkv_manager->index[pos];
+        if (ROLLKV_SLOT_EMPTY == slot->state)
+        {
+            break;
+        }
+        if (ROLLKV_SLOT_USED == slot->state && slot->addr == addr)
+        {
+            return (int32_t)pos;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @func: 新键插入索引
+ */
+static bool index_insert(rollkv_manager_t *rollkv_manager, uint32_t hash, uint32_t addr,
+                         uint8_t key_len, uint16_t val_len)
+{
+    if (rollkv_manager->key_count >= ROLLKV_KEY_NUM)
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < ROLLKV_INDEX_SIZE; i++)
+    {
+        uint32_t pos = (hash + i) & (ROLLKV_INDEX_SIZE - 1);
+        rollkv_slot_t *slot = &rollkv_manager->index[pos];
+        if (ROLLKV_SLOT_USED != slot->state)
+        {
+            slot->state   = ROLLKV_SLOT_USED;
+            slot->hash    = hash;
+            slot->addr    = addr;
+            slot->key_len = key_len;
+            slot->val_len = val_len;
+            rollkv_manager->key_count++;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @func: 删除索引槽
+ */
+static void index_remove(rollkv_manager_t *rollkv_manager, int32_t pos)
+{
+    rollkv_manager->index[pos].state = ROLLKV_SLOT_DELETED;
+    rollkv_manager->key_count--;
+}
+
+/**
+ * @func: 按缓冲区中的记录更新索引
+ */
+static void index_apply(rollkv_manager_t *rollkv_manager, uint32_t addr)
+{
+    rollkv_entry_t *entry = (rollkv_entry_t *)rollkv_manager->buf;
+    char key[ROLLKV_KEY_MAX];
+    uint8_t  key_len = entry->key_len;
+    uint16_t val_len = entry->val_len;
+    bool     del     = (entry->flags & ROLLKV_FLAG_DEL) != 0;
+    memcpy(key, rollkv_manager->buf + sizeof(rollkv_entry_t), key_len);
+
+    uint32_t hash = kv_hash(key, key_len);
+    int32_t pos = index_find(rollkv_manager, key, key_len, hash);
+    if (del)
+    {
+        if (pos >= 0)
+        {
+            index_remove(rollkv_manager, pos);
+        }
+    }
+    else if (pos >= 0)
+    {
+        rollkv_manager->index[pos].addr    = addr;
+        rollkv_manager->index[pos].val_len = val_len;
+    }
+    else if (!index_insert(rollkv_manager, hash, addr, key_len, val_len))
+    {
+        log_error("kv index full, key dropped");
+    }
+}
+
+/**
+ * @func: 查找空闲 block(从当前 block 之后依次查找，均衡擦写)
+ */
+static int32_t kv_free_block(rollkv_manager_t *rollkv_manager, uint32_t *free_num)
+{
+    int32_t found = -1;
+    *free_num = 0;
+    for (uint32_t i = 1; i <= rollkv_manager->block_num; i++)
+    {
+        uint32_t block = (rollkv_manager->active_block + i) % rollkv_manager->block_num;
+        if (ROLLKV_AGE_FREE == rollkv_manager->block_age[block])
+        {
+            if (found < 0)
+            {
+                found = (int32_t)block;
+            }
+            (*free_num)++;
+        }
+    }
+    return found;
+}
+
+/**
+ * @func: 查找最旧 block(不含当前 block)
+ */
+static int32_t kv_oldest_block(rollkv_manager_t *rollkv_manager)
+{
+    int32_t oldest = -1;
+    for (uint32_t block = 0; block < rollkv_manager->block_num; block++)
+    {
+        if (block == rollkv_manager->active_block || ROLLKV_AGE_FREE == rollkv_manager->block_age[block])
+        {
+            continue;
+        }
+        if (oldest < 0 || rollkv_manager->block_age[block] < rollkv_manager->block_age[oldest])
+        {
+            oldest = (int32_t)block;
+        }
+    }
+    return oldest;
+}
+
+/**
+ * @func: 启用空闲 block 作为写入 block
+ */
+static int kv_block_open(rollkv_manager_t *rollkv_manager, uint32_t block)
+{
+    rollkv_block_t head;
+    head.magic_valid = MAGIC_KV_VALID;
+    head.age         = rollkv_manager->max_age + 1;
+    if (0 != rollkv_manager->flash_ops.write_data(ROLLKV_BLOCK_ADDR(block), &head, sizeof(head)))
+    {
+        return -1;
+    }
+    rollkv_manager->max_age              = head.age;
+    rollkv_manager->block_age[block]     = head.age;
+    rollkv_manager->active_block         = block;
+    rollkv_manager->write_addr           = ROLLKV_DATA_ADDR(block);
+    return 0;
+}
+
+/**
+ * @func: 回收 block
+ *        将索引仍指向的记录复制到当前写入 block 后擦除
+ *        一个 block 的有效记录不超过一个 block，复制不会写满
+ */
+static int kv_block_reclaim(rollkv_manager_t *rollkv_manager, uint32_t block)
+{
+    uint32_t addr = ROLLKV_DATA_ADDR(block);
+    int ret;
+    while ((ret = kv_entry_read(rollkv_manager, addr)) != 0 && ret != -1)
+    {
+        rollkv_entry_t *entry = (rollkv_entry_t *)rollkv_manager->buf;
+        uint32_t size = ROLLKV_ENTRY_SIZE(entry->key_len, entry->val_len);
+        if (1 == ret && 0 == (entry->flags & ROLLKV_FLAG_DEL))
+        {
+            uint32_t hash = kv_hash((const char *)rollkv_manager->buf + sizeof(rollkv_entry_t), entry->key_len);
+            int32_t pos = index_find_addr(rollkv_manager, hash, addr);
+            if (pos >= 0)
+            {
+                if (rollkv_manager->write_addr + size > ROLLKV_BLOCK_ADDR(rollkv_manager->active_block + 1)
+                    || 0 != rollkv_manager->flash_ops.write_data(rollkv_manager->write_addr, rollkv_manager->buf, size))
+                {
+                    return -1;
+                }
+                rollkv_manager->index[pos].addr = rollkv_manager->write_addr;
+                rollkv_manager->write_addr += size;
+            }
+        }
+        addr += size;
+    }
+    if (0 != rollkv_manager->flash_ops.erase_sector(ROLLKV_BLOCK_ADDR(block)))
+    {
+        return -1;
+    }
+    rollkv_manager->block_age[block] = ROLLKV_AGE_FREE;
+    return 0;
+}
+
+/**
+ * @func: 预留记录写入空间
+ *        当前 block 放不下时启用空闲 block，只剩 1 个空闲 block 时先回收最旧 block
+ */
+static bool kv_reserve(rollkv_manager_t *rollkv_manager, uint32_t size)
+{
+    for (uint32_t i = 0; i <= rollkv_manager->block_num; i++)
+    {
+        if (rollkv_manager->write_addr + size <= ROLLKV_BLOCK_ADDR(rollkv_manager->active_block + 1))
+        {
+            return true;
+        }
+        uint32_t free_num = 0;
+        int32_t block = kv_free_block(rollkv_manager, &free_num);
+        if (block < 0 || 0 != kv_block_open(rollkv_manager, (uint32_t)block))
+        {
+            return false;
+        }
+        if (1 == free_num)
+        {
+            int32_t oldest = kv_oldest_block(rollkv_manager);
+            if (oldest < 0 || 0 != kv_block_reclaim(rollkv_manager, (uint32_t)oldest))
+            {
+                return false;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @func: 追加一条记录(记录头、键、值一次写入)
+ */
+static int32_t kv_entry_write(rollkv_manager_t *rollkv_manager, const char *key, uint8_t key_len,
+                              const void *value, uint16_t val_len, uint8_t flags)
+{
+    uint32_t size = ROLLKV_ENTRY_SIZE(key_len, val_len);
+    if (!kv_reserve(rollkv_manager, size))
+    {
+        log_error("kv no space");
+        return -1;
+    }
+    rollkv_entry_t *entry = (rollkv_entry_t *)rollkv_manager->buf;
+    memset(rollkv_manager->buf, 0xFF, size);
+    entry->key_len = key_len;
+    entry->flags   = flags;
+    entry->val_len = val_len;
+    memcpy(rollkv_manager->buf + sizeof(rollkv_entry_t), key, key_len);
+    if (val_len > 0)
+    {
+        memcpy(rollkv_manager->buf + sizeof(rollkv_entry_t) + key_len, value, val_len);
+    }
+    entry->crc = kv_entry_crc(rollkv_manager->buf);
+
+    uint32_t addr = rollkv_manager->write_addr;
+    if (0 != rollkv_manager->flash_ops.write_data(addr, rollkv_manager->buf, size))
+    {
+        return -1;
+    }
+    rollkv_manager->write_addr += size;
+    return (int32_t)addr;
+}
+
+/**
+ * @func: 扫描 block 重建索引
+ *        返回下一条记录写入地址，校验失败的记录跳过，记录头损坏时返回 block 结束地址(不再写入)
+ */
+static uint32_t kv_block_scan(rollkv_manager_t *rollkv_manager, uint32_t block)
+{
+    uint32_t addr = ROLLKV_DATA_ADDR(block);
+    int ret;
+    while ((ret = kv_entry_read(rollkv_manager, addr)) != 0 && ret != -1)
+    {
+        rollkv_entry_t *entry = (rollkv_entry_t *)rollkv_manager->buf;
+        uint32_t size = ROLLKV_ENTRY_SIZE(entry->key_len, entry->val_len);
+        if (1 == ret)
+        {
+            index_apply(rollkv_manager, addr);
+        }
+        addr += size;
+    }
+    if (ret < 0)
+    {
+        log_info("kv block %d: torn entry at 0x%x", block, addr);
+        return ROLLKV_BLOCK_ADDR(block + 1);
+    }
+    return addr;
+}
+
+/**
+ * @func: 键值存储初始化
+ *        读取各 block 头，按启用序号从旧到新扫描重建索引
+ */
+int rollkv_init(rollkv_manager_t *rollkv_manager)
+{
+    uint32_t max_size = ROLLKV_CFG_MAX_SIZE(rollkv_manager);
+    if (max_size % SINGLE_BLOCK_SIZE != 0 || max_size / SINGLE_BLOCK_SIZE < 2
+        || max_size / SINGLE_BLOCK_SIZE > ROLLKV_MAX_BLOCK_NUM)
+    {
+        log_error("kv size invalid");
+        return -1;
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollkv_manager->flash_ops.mutex_lock();
+#endif
+    int ret = 0;
+    rollkv_manager->is_init    = 0;
+    rollkv_manager->block_num  = max_size / SINGLE_BLOCK_SIZE;
+    rollkv_manager->max_age    = 0;
+    rollkv_manager->key_count  = 0;
+    memset(rollkv_manager->index, 0, sizeof(rollkv_manager->index));
+
+    for (uint32_t block = 0; block < rollkv_manager->block_num && 0 == ret; block++)
+    {
+        rollkv_block_t head;
+        rollkv_manager->block_age[block] = ROLLKV_AGE_FREE;
+        if (0 != rollkv_manager->flash_ops.read_data(ROLLKV_BLOCK_ADDR(block), &head, sizeof(head)))
+        {
+            ret = -1;
+        }
+        else if (MAGIC_KV_VALID == head.magic_valid && ROLLKV_AGE_FREE != head.age)
+        {
+            rollkv_manager->block_age[block] = head.age;
+            if (head.age > rollkv_manager->max_age)
+            {
+                rollkv_manager->max_age = head.age;
+            }
+        }
+        else if (0xFFFFFFFF != head.magic_valid || ROLLKV_AGE_FREE != head.age)
+        {
+            // block 头写入中断
+            ret = rollkv_manager->flash_ops.erase_sector(ROLLKV_BLOCK_ADDR(block));
+        }
+    }
+
+    // 按启用序号从旧到新扫描
+    int32_t active = -1;
+    uint32_t last_age = 0;
+    while (0 == ret)
+    {
+        int32_t next = -1;
+        for (uint32_t block = 0; block < rollkv_manager->block_num; block++)
+        {
+            uint32_t age = rollkv_manager->block_age[block];
+            if (ROLLKV_AGE_FREE != age && age > last_age
+                && (next < 0 || age < rollkv_manager->block_age[next]))
+            {
+                next = (int32_t)block;
+            }
+        }
+        if (next < 0)
+        {
+            break;
+        }
+        last_age = rollkv_manager->block_age[next];
+        rollkv_manager->write_addr = kv_block_scan(rollkv_manager, (uint32_t)next);
+        active = next;
+    }
+
+    if (0 == ret)
+    {
+        uint32_t free_num = 0;
+        if (active < 0)
+        {
+            rollkv_manager->active_block = rollkv_manager->block_num - 1;
+            int32_t block = kv_free_block(rollkv_manager, &free_num);
+            ret = kv_block_open(rollkv_manager, (uint32_t)block);
+        }
+        else
+        {
+            rollkv_manager->active_block = (uint32_t)active;
+            kv_free_block(rollkv_manager, &free_num);
+            if (0 == free_num)
+            {
+                // 回收中断：继续将最旧 block 的有效记录复制到当前 block
+                int32_t oldest = kv_oldest_block(rollkv_manager);
+                if (oldest < 0 || 0 != kv_block_reclaim(rollkv_manager, (uint32_t)oldest))
+                {
+                    log_error("kv reclaim failed, read only");
+                }
+            }
+        }
+    }
+    if (0 == ret)
+    {
+        rollkv_manager->is_init = MAGIC_VALID;
+        log_info("kv init ok, %d keys", rollkv_manager->key_count);
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollkv_manager->flash_ops.mutex_unlock();
+#endif
+    return ret;
+}
+
+/**
+ * @func: 写入键值
+ */
+bool rollkv_put(rollkv_manager_t *rollkv_manager, const char *key, const void *value, uint32_t len)
+{
+    uint32_t key_len = (NULL == key) ? 0 : strlen(key);
+    if (MAGIC_VALID != rollkv_manager->is_init || 0 == key_len || key_len > ROLLKV_KEY_MAX
+        || len > ROLLKV_VALUE_MAX || (len > 0 && NULL == value))
+    {
+        return false;
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollkv_manager->flash_ops.mutex_lock();
+#endif
+    bool ret = false;
+    uint32_t hash = kv_hash(key, key_len);
+    int32_t pos = index_find(rollkv_manager, key, key_len, hash);
+    if (pos >= 0 || rollkv_manager->key_count < ROLLKV_KEY_NUM)
+    {
+        int32_t addr = kv_entry_write(rollkv_manager, key, (uint8_t)key_len, value, (uint16_t)len, 0);
+        if (addr >= 0)
+        {
+            // 回收不会移动槽位，只更新槽内地址
+            if (pos >= 0)
+            {
+                rollkv_manager->index[pos].addr    = (uint32_t)addr;
+                rollkv_manager->index[pos].val_len = (uint16_t)len;
+                ret = true;
+            }
+            else
+            {
+                ret = index_insert(rollkv_manager, hash, (uint32_t)addr, (uint8_t)key_len, (uint16_t)len);
+            }
+        }
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollkv_manager->flash_ops.mutex_unlock();
+#endif
+    return ret;
+}
+
+/**
+ * @func: 读取键值
+ *        缓冲区放得下 键+值 时一次读出并比较键，否则先读键再读值
+ */
+int32_t rollkv_get(rollkv_manager_t *rollkv_manager, const char *key, void *value, uint32_t max_len)
+{
+    uint32_t key_len = (NULL == key) ? 0 : strlen(key);
+    if (MAGIC_VALID != rollkv_manager->is_init || 0 == key_len || key_len > ROLLKV_KEY_MAX)
+    {
+        return -1;
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollkv_manager->flash_ops.mutex_lock();
+#endif
+    int32_t ret = -1;
+    uint32_t hash = kv_hash(key, key_len);
+    uint8_t *out = (uint8_t *)value;
+    for (uint32_t i = 0; i < ROLLKV_INDEX_SIZE; i++)
+    {
+        rollkv_slot_t *slot = &rollkv_manager->index[(hash + i) & (ROLLKV_INDEX_SIZE - 1)];
+        if (ROLLKV_SLOT_EMPTY == slot->state)
+        {
+            break;
+        }
+        if (ROLLKV_SLOT_USED != slot->state || slot->hash != hash || slot->key_len != key_len)
+        {
+            continue;
+        }
+        uint32_t data_addr = slot->addr + sizeof(rollkv_entry_t);
+        if (NULL != out && key_len + slot->val_len <= max_len)
+        {
+            if (0 == rollkv_manager->flash_ops.read_data(data_addr, out, key_len + slot->val_len)
+                && 0 == memcmp(out, key, key_len))
+            {
+                memmove(out, out + key_len, slot->val_len);
+                ret = slot->val_len;
+                break;
+            }
+        }
+        else if (0 == rollkv_manager->flash_ops.read_data(data_addr, rollkv_manager->buf, key_len)
+                 && 0 == memcmp(rollkv_manager->buf, key, key_len))
+        {
+            uint32_t len = (slot->val_len < max_len) ? slot->val_len : max_len;
+            if (len > 0 && NULL != out)
+            {
+                rollkv_manager->flash_ops.read_data(data_addr + key_len, out, len);
+            }
+            ret = slot->val_len;
+            break;
+        }
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollkv_manager->flash_ops.mutex_unlock();
+#endif
+    return ret;
+}
+
+/**
+ * @func: 删除键
+ *        写入删除记录，旧值所在 block 回收时丢弃
+ */
+bool rollkv_del(rollkv_manager_t *rollkv_manager, const char *key)
+{
+    uint32_t key_len = (NULL == key) ? 0 : strlen(key);
+    if (MAGIC_VALID != rollkv_manager->is_init || 0 == key_len || key_len > ROLLKV_KEY_MAX)
+    {
+        return false;
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollkv_manager->flash_ops.mutex_lock();
+#endif
+    bool ret = true;
+    int32_t pos = index_find(rollkv_manager, key, key_len, kv_hash(key, key_len));
+    if (pos >= 0)
+    {
+        ret = (kv_entry_write(rollkv_manager, key, (uint8_t)key_len, NULL, 0, ROLLKV_FLAG_DEL) >= 0);
+        if (ret)
+        {
+            index_remove(rollkv_manager, pos);
+        }
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollkv_manager->flash_ops.mutex_unlock();
+#endif
+    return ret;
+}
+
+/**
+ * @func: 查询键数量
+ */
+uint32_t rollkv_count(rollkv_manager_t *rollkv_manager)
+{
+    return (MAGIC_VALID == rollkv_manager->is_init) ? rollkv_manager->key_count : 0;
+}
@@ -0,0 +1,157 @@
+/**
+  ******************************************************************************
+  * @file           : rollKv.h
+  * @brief          : 键值状态存储
+  *
+  * 与日志分区配合使用的小型键值存储，用于保存设备最新状态(配置、计数器等)：
+  * - 日志结构追加写入：每次写入/删除追加一条记录，最新记录有效
+  * - 内存开放寻址哈希索引：挂载时扫描重建，读取只需一次 Flash 读
+  * - 回收：没有空闲 block 时将最旧 block 中的有效键复制到新 block 后擦除
+  *
+  * +-------------------+
+  * |     KV block 0    | -> rollkv_block_t + rollkv_entry_t 链
+  * +-------------------+
+  * |       ...         |
+  * +-------------------+
+  * |   KV block n-1    | -> 至少保留 1 个空闲 block 用于回收
+  * +-------------------+
+  *
+  * @version        : 1.0.1
+  * @date           : 2025-12-10
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2025 ARSTUDIO.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+#ifndef ROLLKV_H
+#define ROLLKV_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include "rollTs.h"
+/*---------------------------------------------------------------------------*/
+/********************
+ * 配置项 键值存储
+ *******************/
+
+// 键值存储总大小 -字节数(需与 SINGLE_BLOCK_SIZE 对齐，至少 2 个 block)
+#define ROLLKV_MAX_SIZE         (4 * SINGLE_BLOCK_SIZE)
+// 键最大长度(不含结束符)
+#define ROLLKV_KEY_MAX          32
+// 值最大长度
+#define ROLLKV_VALUE_MAX        128
+// 最多保存的键数量
+#define ROLLKV_KEY_NUM          64
+/*---------------------------------------------------------------------------*/
+/*******************
+ * 自动配置
+ *******************/
+
+#define ROLLKV_MAX_BLOCK_NUM    (ROLLKV_MAX_SIZE / SINGLE_BLOCK_SIZE)
+// 哈希索引槽数(2 的幂，不小于 2 倍键数量)
+#define ROLLKV_INDEX_SIZE       128
+
+#define MAGIC_KV_VALID          0x20251207
+
+#define ROLLKV_FLAG_DEL         0x01        // 删除标记
+#define ROLLKV_AGE_FREE         0xFFFFFFFF  // block 空闲
+
+/**
+ * KV block 头
+ * 整体一次写入，magic 无效且非擦除值的 block 挂载时擦除
+ */
+typedef struct
+{
+    uint32_t                    magic_valid;
+    uint32_t                            age;               // block 启用序号，越大越新
+} rollkv_block_t;
+
+/**
+ * KV 记录头
+ * 记录头、键、值一次写入，crc 校验不通过的记录视为写入中断
+ */
+typedef struct
+{
+    uint8_t                         key_len;               // 0xFF:空位
+    uint8_t                           flags;               // ROLLKV_FLAG_DEL:删除记录
+    uint16_t                        val_len;
+    uint32_t                            crc;               // 记录头(crc 除外)+键+值
+} rollkv_entry_t;
+
+#define ROLLKV_ENTRY_SIZE(key_len, val_len) \
+    ((sizeof(rollkv_entry_t) + (key_len) + (val_len) + MIN_WRITE_UNIT_SIZE - 1) / MIN_WRITE_UNIT_SIZE * MIN_WRITE_UNIT_SIZE)
+#define ROLLKV_ENTRY_MAX        ROLLKV_ENTRY_SIZE(ROLLKV_KEY_MAX, ROLLKV_VALUE_MAX)
+
+/**
+ * 哈希索引槽
+ */
+#define ROLLKV_SLOT_EMPTY       0
+#define ROLLKV_SLOT_USED        1
+#define ROLLKV_SLOT_DELETED     2
+
+typedef struct
+{
+    uint32_t                           addr;               // 有效记录地址
+    uint32_t                           hash;
+    uint16_t                        val_len;
+    uint8_t                         key_len;
+    uint8_t                           state;
+} rollkv_slot_t;
+
+/**
+ * 键值存储管理单元
+ */
+typedef struct
+{
+    uint32_t                        is_init;
+    flash_ops_t                   flash_ops;               // 地址从 0 开始的独立区域
+    uint32_t                       max_size;               // 实例大小(可选，0:ROLLKV_MAX_SIZE)
+    uint32_t                      block_num;
+    uint32_t    block_age[ROLLKV_MAX_BLOCK_NUM];           // 各 block 启用序号(ROLLKV_AGE_FREE:空闲)
+    uint32_t                   active_block;               // 当前写入 block
+    uint32_t                     write_addr;               // 下一条记录写入地址
+    uint32_t                        max_age;
+    uint32_t                      key_count;
+    rollkv_slot_t index[ROLLKV_INDEX_SIZE];
+    uint8_t          buf[ROLLKV_ENTRY_MAX];                // 记录读写缓冲
+} rollkv_manager_t;
+
+/**
+ * @func: 键值存储初始化(扫描重建索引)
+ */
+extern int rollkv_init(rollkv_manager_t *rollkv_manager);
+
+/**
+ * @func: 写入键值 覆盖已有值
+ */
+extern bool rollkv_put(rollkv_manager_t *rollkv_manager, const char *key, const void *value, uint32_t len);
+
+/**
+ * @func: 读取键值 返回值长度，不存在返回 -1
+ *        缓冲区不小于 键长+值长 时只需一次 Flash 读
+ */
+extern int32_t rollkv_get(rollkv_manager_t *rollkv_manager, const char *key, void *value, uint32_t max_len);
+
+/**
+ * @func: 删除键
+ */
+extern bool rollkv_del(rollkv_manager_t *rollkv_manager, const char *key);
+
+/**
+ * @func: 查询键数量
+ */
+extern uint32_t rollkv_count(rollkv_manager_t *rollkv_manager);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ROLLKV_H
@@ -0,0 +1,234 @@
+#include "rollStripe.h"
+
+/**
+ * 条带组
+ */
+typedef struct
+{
+    bool                             in_use;
+    uint32_t                        dev_num;
+    rollts_stripe_dev_t dev[ROLLTS_STRIPE_DEV_MAX];
+    bool            busy[ROLLTS_STRIPE_DEV_MAX];           // 已发起异步擦除，下次访问前等待
+#if ROLLTS_STRIPE_POST_SIZE > 0
+    uint32_t    post_addr[ROLLTS_STRIPE_DEV_MAX];          // 暂存写入地址(器件内)
+    uint32_t     post_len[ROLLTS_STRIPE_DEV_MAX];          // 暂存写入长度，0:无
+    uint8_t          post[ROLLTS_STRIPE_DEV_MAX][ROLLTS_STRIPE_POST_SIZE];
+    bool         post_err[ROLLTS_STRIPE_DEV_MAX];          // 暂存写入失败，下次访问返回错误
+#endif
+} rollts_stripe_t;
+
+static rollts_stripe_t stripe_tab[ROLLTS_STRIPE_MAX];
+
+/* function-------------------------------------------------------------------*/
+/**
+ * @func: 逻辑地址映射到器件及器件内地址
+ */
+static uint32_t stripe_map(const rollts_stripe_t *stripe, uint32_t address, uint32_t *dev)
+{
+    uint32_t block  = address / SINGLE_BLOCK_SIZE;
+    uint32_t unit   = block / ROLLTS_STRIPE_UNIT;
+    uint32_t local  = unit / stripe->dev_num * ROLLTS_STRIPE_UNIT + block % ROLLTS_STRIPE_UNIT;
+    *dev = ROLLTS_STRIPE_DEV(block, stripe->dev_num);
+    return local * SINGLE_BLOCK_SIZE + address % SINGLE_BLOCK_SIZE;
+}
+
+/**
+ * @func: 等待器件空闲并写入暂存数据，暂存写入失败返回 -1
+ */
+static int stripe_wait(rollts_stripe_t *stripe, uint32_t dev)
+{
+    if (stripe->busy[dev])
+    {
+        while (stripe->dev[dev].is_busy())
+        {
+        }
+        stripe->busy[dev] = false;
+    }
+#if ROLLTS_STRIPE_POST_SIZE > 0
+    if (stripe->post_len[dev] > 0)
+    {
+        uint32_t len = stripe->post_len[dev];
+        stripe->post_len[dev] = 0;
+        if (0 != stripe->dev[dev].write_data(stripe->post_addr[dev], stripe->post[dev], len))
+        {
+            stripe->post_err[dev] = true;
+        }
+    }
+    if (stripe->post_err[dev])
+    {
+        stripe->post_err[dev] = false;
+        return -1;
+    }
+#endif
+    return 0;
+}
+
+/**
+ * @func: 器件擦除进行中时暂存一次小写入，已暂存返回 true
+ */
+static bool stripe_post(rollts_stripe_t *stripe, uint32_t dev, uint32_t local, const uint8_t *data, uint32_t len)
+{
+#if ROLLTS_STRIPE_POST_SIZE > 0
+    if (stripe->busy[dev] && 0 == stripe->post_len[dev] && len <= ROLLTS_STRIPE_POST_SIZE)
+    {
+        memcpy(stripe->post[dev], data, len);
+        stripe->post_addr[dev] = local;
+        stripe->post_len[dev]  = len;
+        return true;
+    }
+#endif
+    (void)stripe; (void)dev; (void)local; (void)data; (void)len;
+    return false;
+}
+
+/**
+ * @func: 擦除 器件支持时异步发起
+ */
+static int stripe_erase(rollts_stripe_t *stripe, uint32_t address)
+{
+    uint32_t dev;
+    uint32_t local = stripe_map(stripe, address, &dev);
+    if (0 != stripe_wait(stripe, dev))
+    {
+        return -1;
+    }
+    if (NULL == stripe->dev[dev].erase_start)
+    {
+        return stripe->dev[dev].erase_sector(local);
+    }
+    if (0 != stripe->dev[dev].erase_start(local))
+    {
+        return -1;
+    }
+    stripe->busy[dev] = true;
+    return 0;
+}
+
+/**
+ * @func: 读写 跨 block 时按 block 拆分
+ */
+static int stripe_io(rollts_stripe_t *stripe, uint32_t address, uint8_t *data, uint32_t length, bool is_write)
+{
+    while (length > 0)
+    {
+        uint32_t dev;
+        uint32_t local = stripe_map(stripe, address, &dev);
+        uint32_t len   = SINGLE_BLOCK_SIZE - address % SINGLE_BLOCK_SIZE;
+        int ret;
+        if (len > length)
+        {
+            len = length;
+        }
+        if (is_write && stripe_post(stripe, dev, local, data, len))
+        {
+            ret = 0;
+        }
+        else if (0 != stripe_wait(stripe, dev))
+        {
+            return -1;
+        }
+        else
+        {
+            ret = is_write ? stripe->dev[dev].write_data(local, data, len)
+                           : stripe->dev[dev].read_data(local, data, len);
+        }
+        if (0 != ret)
+        {
+            return ret;
+        }
+        address += len;
+        data    += len;
+        length  -= len;
+    }
+    return 0;
+}
+
+/**
+ * 每个条带组一组静态入口，绑定到 flash_ops_t
+ */
+#define STRIPE_ENTRY(n)                                                                                              \
+static int stripe_erase_##n(uint32_t a)                  { return stripe_erase(&stripe_tab[n], a); }                \
+static int stripe_write_##n(uint32_t a, void *d, uint32_t l) { return stripe_io(&stripe_tab[n], a, (uint8_t *)d, l, true); }  \
+static int stripe_read_##n(uint32_t a, void *d, uint32_t l)  { return stripe_io(&stripe_tab[n], a, (uint8_t *)d, l, false); }
+
+STRIPE_ENTRY(0)
+STRIPE_ENTRY(1)
+
+#if ROLLTS_STRIPE_MAX != 2
+#error "ROLLTS_STRIPE_MAX changed: update STRIPE_ENTRY list and stripe_entry_tab"
+#endif
+
+typedef struct
+{
+    int (*erase_sector)(uint32_t address);
+    int (*write_data)(uint32_t address, void *data, uint32_t length);
+    int (*read_data)(uint32_t address, void *data, uint32_t length);
+} stripe_entry_t;
+
+static const stripe_entry_t stripe_entry_tab[ROLLTS_STRIPE_MAX] =
+{
+    { stripe_erase_0, stripe_write_0, stripe_read_0 },
+    { stripe_erase_1, stripe_write_1, stripe_read_1 },
+};
+
+/**
+ * @func: 打开条带组
+ */
+int rollts_stripe_open(const rollts_stripe_dev_t *devs, uint32_t dev_num, flash_ops_t *flash_ops)
+{
+    if (NULL == devs || NULL == flash_ops || 0 == dev_num || dev_num > ROLLTS_STRIPE_DEV_MAX)
+    {
+        return -1;
+    }
+    for (uint32_t i = 0; i < dev_num; i++)
+    {
+        if (NULL == devs[i].write_data || NULL == devs[i].read_data
+            || (NULL == devs[i].erase_start ? NULL == devs[i].erase_sector : NULL == devs[i].is_busy))
+        {
+            return -1;
+        }
+    }
+    for (int id = 0; id < ROLLTS_STRIPE_MAX; id++)
+    {
+        if (stripe_tab[id].in_use)
+        {
+            continue;
+        }
+        memset(&stripe_tab[id], 0, sizeof(rollts_stripe_t));
+        memcpy(stripe_tab[id].dev, devs, dev_num * sizeof(rollts_stripe_dev_t));
+        stripe_tab[id].dev_num  = dev_num;
+        stripe_tab[id].in_use   = true;
+        flash_ops->erase_sector = stripe_entry_tab[id].erase_sector;
+        flash_ops->write_data   = stripe_entry_tab[id].write_data;
+        flash_ops->read_data    = stripe_entry_tab[id].read_data;
+        return id;
+    }
+    return -1;
+}
+
+/**
+ * @func: 等待所有器件擦除完成并写入暂存的块头
+ */
+void rollts_stripe_sync(int stripe)
+{
+    if (stripe < 0 || stripe >= ROLLTS_STRIPE_MAX || !stripe_tab[stripe].in_use)
+    {
+        return;
+    }
+    for (uint32_t dev = 0; dev < stripe_tab[stripe].dev_num; dev++)
+    {
+        stripe_wait(&stripe_tab[stripe], dev);
+    }
+}
+
+/**
+ * @func: 等待擦除完成并释放条带组
+ */
+void rollts_stripe_close(int stripe)
+{
+    rollts_stripe_sync(stripe);
+    if (stripe >= 0 && stripe < ROLLTS_STRIPE_MAX)
+    {
+        stripe_tab[stripe].in_use = false;
+    }
+}
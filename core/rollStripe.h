@@ -0,0 +1,94 @@
+/**
+  ******************************************************************************
+  * @file           : rollStripe.h
+  * @brief          : 多 Flash 器件条带化
+  *
+  * 将 N 个相同的 Flash 器件(独立总线)组合为一个 flash_ops_t：
+  * - 连续 ROLLTS_STRIPE_UNIT 个 block 位于同一器件，之后轮换到下一个器件
+  * - block 到器件的映射为 ROLLTS_STRIPE_DEV(rollTs.h)，与 get_next_block 的环形顺序一致
+  * - 器件提供 erase_start/is_busy 时擦除异步发起，对该器件的下一次访问前等待完成，
+  *   其余器件上的写入与擦除并行进行
+  * - 擦除进行中的器件上的小写入(块头)暂存，擦除完成后、该器件下一次访问前写入，
+  *   擦除后立即写块头的顺序不变，调用方不阻塞
+  *
+  * 切换 block 时需擦除新写入 block(原 head)与新 backup block(原最旧 block)，两者相距
+  * 2 个 block，条带单元为 2 时位于不同器件，两次擦除及其块头写入并行进行。
+  *
+  *   逻辑 block:  0  1 | 2  3 | 4  5 | 6  7 | ...
+  *   器件(N=2):   A  A | B  B | A  A | B  B | ...
+  *
+  * 使用示例：
+  *   rollts_stripe_dev_t devs[2] = {
+  *       { nor0_erase, nor0_write, nor0_read, nor0_erase_start, nor0_busy },
+  *       { nor1_erase, nor1_write, nor1_read, nor1_erase_start, nor1_busy },
+  *   };
+  *   int stripe = rollts_stripe_open(devs, 2, &mgr.flash_ops);
+  *   rollts_init(&mgr);
+  *
+  * @version        : 1.0.2
+  * @date           : 2025-12-10
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2025 ARSTUDIO.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+#ifndef ROLLSTRIPE_H
+#define ROLLSTRIPE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include "rollTs.h"
+/*---------------------------------------------------------------------------*/
+/********************
+ * 配置项 条带化
+ *******************/
+
+// 单个条带组最多器件数
+#define ROLLTS_STRIPE_DEV_MAX   4
+// 最多同时打开的条带组数(flash_ops_t 无上下文参数，每组占用一组静态入口)
+#define ROLLTS_STRIPE_MAX       2
+// 擦除进行中的器件上可暂存的一次小写入(块头) -字节数，0:不暂存
+#define ROLLTS_STRIPE_POST_SIZE 64
+/*---------------------------------------------------------------------------*/
+
+/**
+ * 单个器件操作(地址为器件内地址)
+ */
+typedef struct
+{
+    int                            (*erase_sector)(uint32_t address);        // 同步擦除(未提供 erase_start 时使用)
+    int (*write_data)(uint32_t address, void *data, uint32_t length);
+    int  (*read_data)(uint32_t address, void *data, uint32_t length);
+    int                             (*erase_start)(uint32_t address);        // 发起擦除后立即返回(可选)
+    bool                                       (*is_busy)(void);             // 擦除进行中(提供 erase_start 时必须提供)
+} rollts_stripe_dev_t;
+
+/**
+ * @func: 打开条带组并填充 flash_ops(不含互斥锁)，返回条带组号，失败返回 -1
+ *        每个器件需容纳 总大小/器件数 向上取整到条带单元
+ */
+extern int rollts_stripe_open(const rollts_stripe_dev_t *devs, uint32_t dev_num, flash_ops_t *flash_ops);
+
+/**
+ * @func: 等待所有器件擦除完成并写入暂存的块头(掉电/关闭前调用)
+ */
+extern void rollts_stripe_sync(int stripe);
+
+/**
+ * @func: 等待擦除完成并释放条带组
+ */
+extern void rollts_stripe_close(int stripe);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ROLLSTRIPE_H
@@ -0,0 +1,55 @@
+#include "rollTrace.h"
+#include <string.h>
+
+rolltrace_ring_t rolltrace_ring;
+static uint32_t (*rolltrace_clock)(void);
+
+/* function-------------------------------------------------------------------*/
+/**
+ * @func: 初始化跟踪缓冲
+ */
+void rolltrace_init(uint32_t (*clock)(void))
+{
+    memset(&rolltrace_ring, 0, sizeof(rolltrace_ring));
+    rolltrace_ring.entry_size  = sizeof(rolltrace_entry_t);
+    rolltrace_ring.entry_num   = ROLLTRACE_NUM;
+    rolltrace_ring.magic_valid = MAGIC_TRACE_VALID;
+    rolltrace_clock            = clock;
+}
+
+/**
+ * @func: 写入一条事件
+ */
+void rolltrace_emit(uint8_t info, uint8_t file, uint16_t line,
+                    uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+{
+    uint32_t count = rolltrace_ring.count;
+    rolltrace_entry_t *entry;
+    if (MAGIC_TRACE_VALID != rolltrace_ring.magic_valid)
+    {
+        rolltrace_init(NULL);
+    }
+    entry = &rolltrace_ring.entries[count & (ROLLTRACE_NUM - 1)];
+    entry->ts     = rolltrace_clock ? rolltrace_clock() : count;
+    entry->line   = line;
+    entry->file   = file;
+    entry->info   = info;
+    entry->arg[0] = a;
+    entry->arg[1] = b;
+    entry->arg[2] = c;
+    entry->arg[3] = d;
+    rolltrace_ring.count = count + 1;
+}
+
+/**
+ * @func: 导出跟踪缓冲
+ */
+uint32_t rolltrace_snapshot(void *buf, uint32_t len)
+{
+    if (NULL == buf || len < sizeof(rolltrace_ring_t))
+    {
+        return 0;
+    }
+    memcpy(buf, &rolltrace_ring, sizeof(rolltrace_ring_t));
+    return sizeof(rolltrace_ring_t);
+}
@@ -0,0 +1,130 @@
+/**
+  ******************************************************************************
+  * @file           : rollTrace.h
+  * @brief          : 二进制跟踪环形缓冲
+  *
+  * 开启 ROLLDB_LOG_TRACE_ENABLE 后，rollDef.h 中已开启等级的 log_* 不再调用 printf，
+  * 而是向 RAM 环形缓冲写入一条定长事件(时间戳、等级、源文件号、行号、最多 4 个整数参数)：
+  * - 格式化字符串不进入固件，热路径只有一次结构体赋值
+  * - 缓冲写满后覆盖最旧事件
+  * - rolltrace_snapshot 导出整个缓冲(或由调试器直接读取 rolltrace_ring)，
+  *   主机端 tools/rolltrace_decode.cpp 按 源文件号+行号 在源码中查找格式字符串还原日志
+  *
+  * 源文件在包含 rollDef.h 前定义 ROLLTRACE_FILE_ID(1~15)，解码时按该定义对应源文件。
+  *
+  * @version        : 1.0.1
+  * @date           : 2025-12-10
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2025 ARSTUDIO.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+#ifndef ROLLTRACE_H
+#define ROLLTRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+/*---------------------------------------------------------------------------*/
+/********************
+ * 配置项 跟踪缓冲
+ *******************/
+
+// 环形缓冲事件条数(2 的幂)
+#define ROLLTRACE_NUM           64
+// 单条事件最多整数参数个数
+#define ROLLTRACE_ARG_MAX       4
+/*---------------------------------------------------------------------------*/
+
+#if (ROLLTRACE_NUM & (ROLLTRACE_NUM - 1)) != 0
+#error "ROLLTRACE_NUM must be a power of 2"
+#endif
+
+#define MAGIC_TRACE_VALID       0x20251208
+
+#define ROLLTRACE_LEVEL_DEBUG   0
+#define ROLLTRACE_LEVEL_INFO    1
+#define ROLLTRACE_LEVEL_ALT     2
+#define ROLLTRACE_LEVEL_ERROR   3
+
+#ifndef ROLLTRACE_FILE_ID
+#define ROLLTRACE_FILE_ID       0
+#endif
+
+/**
+ * 跟踪事件 24 字节
+ */
+typedef struct
+{
+    uint32_t                             ts;               // 时间戳(rolltrace_init 注册的时钟，未注册时为事件序号)
+    uint16_t                           line;               // 源码行号
+    uint8_t                            file;               // 源文件号 ROLLTRACE_FILE_ID
+    uint8_t                            info;               // bit[1:0]:等级 bit[4:2]:参数个数
+    uint32_t          arg[ROLLTRACE_ARG_MAX];
+} rolltrace_entry_t;
+
+/**
+ * 跟踪缓冲(快照格式与内存布局一致)
+ */
+typedef struct
+{
+    uint32_t                    magic_valid;
+    uint16_t                     entry_size;               // sizeof(rolltrace_entry_t)
+    uint16_t                      entry_num;               // ROLLTRACE_NUM
+    uint32_t                          count;               // 累计写入事件数，最新事件位于 (count-1) % entry_num
+    uint32_t                       reserved;
+    rolltrace_entry_t entries[ROLLTRACE_NUM];
+} rolltrace_ring_t;
+
+#define ROLLTRACE_INFO(level, argc)  ((uint8_t)(((level) & 0x03) | ((argc) << 2)))
+#define ROLLTRACE_LEVEL(info)        ((info) & 0x03)
+#define ROLLTRACE_ARGC(info)         (((info) >> 2) & 0x07)
+
+/**
+ * 日志宏展开：丢弃格式字符串，参数按 uint32_t 记录(最多 ROLLTRACE_ARG_MAX 个)
+ */
+#define ROLLTRACE_SELECT(_f, _1, _2, _3, _4, name, ...)  name
+#define ROLLTRACE_EMIT(level, ...) \
+    ROLLTRACE_SELECT(__VA_ARGS__, ROLLTRACE_EMIT4, ROLLTRACE_EMIT3, ROLLTRACE_EMIT2, ROLLTRACE_EMIT1, ROLLTRACE_EMIT0, 0)(level, __VA_ARGS__)
+#define ROLLTRACE_EMIT0(level, f) \
+    rolltrace_emit(ROLLTRACE_INFO(level, 0), ROLLTRACE_FILE_ID, __LINE__, 0, 0, 0, 0)
+#define ROLLTRACE_EMIT1(level, f, a) \
+    rolltrace_emit(ROLLTRACE_INFO(level, 1), ROLLTRACE_FILE_ID, __LINE__, (uint32_t)(a), 0, 0, 0)
+#define ROLLTRACE_EMIT2(level, f, a, b) \
+    rolltrace_emit(ROLLTRACE_INFO(level, 2), ROLLTRACE_FILE_ID, __LINE__, (uint32_t)(a), (uint32_t)(b), 0, 0)
+#define ROLLTRACE_EMIT3(level, f, a, b, c) \
+    rolltrace_emit(ROLLTRACE_INFO(level, 3), ROLLTRACE_FILE_ID, __LINE__, (uint32_t)(a), (uint32_t)(b), (uint32_t)(c), 0)
+#define ROLLTRACE_EMIT4(level, f, a, b, c, d) \
+    rolltrace_emit(ROLLTRACE_INFO(level, 4), ROLLTRACE_FILE_ID, __LINE__, (uint32_t)(a), (uint32_t)(b), (uint32_t)(c), (uint32_t)(d))
+
+extern rolltrace_ring_t rolltrace_ring;
+
+/**
+ * @func: 初始化跟踪缓冲并注册时钟(可为 NULL)
+ */
+extern void rolltrace_init(uint32_t (*clock)(void));
+
+/**
+ * @func: 写入一条事件(不加锁，并发写入时可能丢失事件)
+ */
+extern void rolltrace_emit(uint8_t info, uint8_t file, uint16_t line,
+                           uint32_t a, uint32_t b, uint32_t c, uint32_t d);
+
+/**
+ * @func: 导出跟踪缓冲 返回拷贝字节数，缓冲区小于 sizeof(rolltrace_ring_t) 时返回 0
+ */
+extern uint32_t rolltrace_snapshot(void *buf, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ROLLTRACE_H
@@ -1,7 +1,29 @@
+#define ROLLTRACE_FILE_ID  1   // 跟踪事件源文件号(tools/rolltrace_decode.cpp)
 #include "rollTs.h" 
 
-#define MAGIC_VALID       0x20251204 // 定义一个有效的魔数，用于验证系统分区的有效性
-#define MAGIC_DATA_VALID  0x20251205
+// 实例数据库大小：管理单元未配置 rollts_max_size 时使用 ROLLTS_MAX_SIZE
+#define ROLLTS_CFG_MAX_SIZE(m)       ((m)->rollts_max_size ? (m)->rollts_max_size : ROLLTS_MAX_SIZE)
+#define ROLLTS_CFG_MAX_BLOCK_NUM(m)  (ROLLTS_CFG_MAX_SIZE(m) / SINGLE_BLOCK_SIZE)
+// 数据分区结束块：最后一个 block 作为消费者扇区，不足 6 个 block 时数据分区至少保留 4 个 block，不设消费者扇区
+#define ROLLTS_CFG_DATA_END_BLOCK(m) (ROLLTS_CFG_MAX_BLOCK_NUM(m) - ((ROLLTS_CFG_MAX_BLOCK_NUM(m) >= 6) ? 2 : 1))
+// 数据分区 block 数
+#define ROLLTS_DATA_BLOCK_NUM(m)     ((m)->sys_info.data_end_block_num - (m)->sys_info.data_start_block_num + 1)
+// 实例日志格式：配置 fixed_size 时使用定长格式，未配置 record_format 时使用 ROLLTS_RECORD_FORMAT
+#define ROLLTS_CFG_RECORD_FORMAT(m)  ((m)->fixed_size ? ROLLTS_SYS_FIXED_FORMAT((m)->fixed_size) \
+                                    : (m)->record_format ? (uint32_t)(m)->record_format : (uint32_t)ROLLTS_RECORD_FORMAT)
+
+// 分片首片最小负载长度，当前 block 剩余空间不足时从下一个 block 开始分片
+#define ROLLTS_FRAG_MIN_LEN          16
+
+// 前置缓冲 head/tail 发布与读取：release 写入保证之前的条目写入先于偏移可见，acquire 读取保证之后读到的条目完整
+#if defined(__GNUC__) || defined(__clang__)
+#define ROLLTS_LOAD_ACQUIRE(p)       __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define ROLLTS_STORE_RELEASE(p, v)   __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#else
+// 其它编译器仅依赖 volatile 访问顺序，适用于单核且不乱序访存的 MCU
+#define ROLLTS_LOAD_ACQUIRE(p)       (*(p))
+#define ROLLTS_STORE_RELEASE(p, v)   (*(p) = (v))
+#endif
 uint32_t crc_simple(uint8_t *data, size_t len) 
 {
     uint32_t checksum = 0x07;  
@@ -13,6 +35,56 @@ uint32_t crc_simple(uint8_t *data, size_t len)
 }
 
 /* function-------------------------------------------------------------------*/
+/**
+ * @func: 聚合值清零
+ */
+static void agg_reset(rollts_agg_t *agg)
+{
+    agg->count = 0;
+    agg->min   = INT32_MAX;
+    agg->max   = INT32_MIN;
+    agg->sum   = 0;
+}
+
+/**
+ * @func: 合并聚合值
+ */
+static void agg_merge(rollts_agg_t *agg, const rollts_agg_t *other)
+{
+    if (0 == other->count)
+    {
+        return;
+    }
+    agg->count += other->count;
+    agg->sum   += other->sum;
+    if (other->min < agg->min)
+    {
+        agg->min = other->min;
+    }
+    if (other->max > agg->max)
+    {
+        agg->max = other->max;
+    }
+}
+
+/**
+ * @func: 单条日志参与聚合
+ */
+static void agg_add_record(rollts_manager_t *rollts_manager, rollts_agg_t *agg,
+                           uint8_t tag, uint8_t *buf, uint32_t len)
+{
+    rollts_agg_t one;
+    int32_t value = 0;
+    if (NULL == rollts_manager->agg_extract || !rollts_manager->agg_extract(tag, buf, len, &value))
+    {
+        return;
+    }
+    one.count = 1;
+    one.min   = value;
+    one.max   = value;
+    one.sum   = value;
+    agg_merge(agg, &one);
+}
 
 static void rollts_manager_print(rollts_manager_t *rollts_manager)
 {
@@ -26,20 +98,27 @@ static void rollts_manager_print(rollts_manager_t *rollts_manager)
     log_debug("rollts_max_block_num : 0x%x", rollts_manager->sys_info.rollts_max_block_num);
     log_debug("data_start_addr      : 0x%x", rollts_manager->sys_info.data_start_addr);
     log_debug("data_end_addr        : 0x%x", rollts_manager->sys_info.data_end_addr);
+    log_debug("layout_version       : %d",   rollts_manager->sys_info.layout_version);
 }
 
 /**
  * @func: 检查数据库大小配置是否与最小擦除单元对齐
  *        检查最小大小是否无法完成roll
  */
-static bool check_if_rollts_size_aligned(void)
+static bool check_if_rollts_size_aligned(rollts_manager_t *rollts_manager)
 {
-    if(ROLLTS_MAX_SIZE % SINGLE_BLOCK_SIZE != 0)
+    if(ROLLTS_CFG_MAX_SIZE(rollts_manager) % SINGLE_BLOCK_SIZE != 0)
+    {
+        return false;
+    }
+    if(ROLLTS_CFG_MAX_BLOCK_NUM(rollts_manager) < 5)
     {
         return false;
     }
-    if(ROLLTS_MAX_SIZE/SINGLE_BLOCK_SIZE < 5)
+    // 定长日志不分片：按 v1 日志头计算也不超过单帧上限
+    if(rollts_manager->fixed_size + sizeof(rollts_data_t) >= SINGLE_BLOCK_SIZE - sizeof(block_info_t) - 4)
     {
+        log_error(" fixed_size %d exceeds a block", rollts_manager->fixed_size);
         return false;
     }
     else
@@ -48,6 +127,40 @@ static bool check_if_rollts_size_aligned(void)
     }
 }
 
+static const rollts_layout_t rollts_legacy_layouts[ROLLTS_LEGACY_LAYOUT_NUM] = ROLLTS_LEGACY_LAYOUTS;
+
+/**
+ * @func: 布局版本对应的旧布局 block 头
+ *        NULL: 当前布局或不支持的布局
+ */
+static const rollts_layout_t *legacy_layout_get(uint32_t layout_version)
+{
+    if(layout_version >= ROLLTS_LEGACY_LAYOUT_NUM || 0 == rollts_legacy_layouts[layout_version].hdr_size)
+    {
+        return NULL;
+    }
+    return &rollts_legacy_layouts[layout_version];
+}
+
+/**
+ * @func: 系统分区追加记录起始地址
+ *        加入代号之前的 layout 5 分区系统信息为 48 字节，追加记录紧接其后(与代号位置重叠)；
+ *        当前布局系统信息之后到 ROLLTS_CONSUMER_AREA_ADDR 始终为擦除值，追加记录名称以 0 结尾，据此区分
+ */
+static uint32_t sys_log_start(rollts_manager_t *rollts_manager)
+{
+    uint8_t pad[ROLLTS_CONSUMER_AREA_ADDR - SYSINFO_SIZE];
+    ROLLTS_FLASH_READ(rollts_manager, SYSINFO_SIZE, pad, sizeof(pad));
+    for(uint32_t i = 0; i < sizeof(pad); i++)
+    {
+        if(0xFF != pad[i])
+        {
+            return offsetof(rollts_sys_t, generation);
+        }
+    }
+    return ROLLTS_CONSUMER_AREA_ADDR;
+}
+
 /**
  * @func: 检查系统分区是否能正常分配，
  *        并初始化系统分区信息
@@ -55,20 +168,35 @@ static bool check_if_rollts_size_aligned(void)
 static bool check_if_sys_aligned(rollts_manager_t *rollts_manager)
 {
     bool ret = false;
-    if(0 == rollts_manager->flash_ops.read_data(0, &rollts_manager->sys_info, SYSINFO_SIZE))
+    rollts_manager->legacy_layout = 0;
+    if(0 == ROLLTS_FLASH_READ(rollts_manager, 0, &rollts_manager->sys_info, SYSINFO_SIZE))
     {
-        //读取成功后，检查magic是否有效
+        //读取成功后，检查magic与布局版本是否有效
+        if(MAGIC_VALID == rollts_manager->sys_info.magic_valid && 0xFFFFFFFF == rollts_manager->sys_info.layout_version)
+        {
+            rollts_manager->sys_info.layout_version = ROLLTS_LAYOUT_BASE;
+        }
         if(MAGIC_VALID != rollts_manager->sys_info.magic_valid)
         {
             ret = false;
         }
-        if(    rollts_manager->sys_info.data_start_block_num      != 1
-            || rollts_manager->sys_info.data_end_block_num        != ROLLTS_MAX_BLOCK_NUM - 1
-            || rollts_manager->sys_info.log_size                  != ROLLTS_MAX_BLOCK_NUM * SINGLE_BLOCK_SIZE
-            || rollts_manager->sys_info.rollts_max_size           != ROLLTS_MAX_SIZE
+        else if(ROLLTS_LAYOUT_VERSION != rollts_manager->sys_info.layout_version
+                && NULL == legacy_layout_get(rollts_manager->sys_info.layout_version))
+        {
+            // 未知布局(更新版本固件写入)无法解析，分区需要重新格式化
+            log_alt(" rollTs layout %d not supported, partition will be reformatted",
+                    rollts_manager->sys_info.layout_version);
+            ret = false;
+        }
+        else if(    rollts_manager->sys_info.data_start_block_num      != 1
+            || (    rollts_manager->sys_info.data_end_block_num   != ROLLTS_CFG_DATA_END_BLOCK(rollts_manager)
+                 // 旧分区数据分区延伸到最后一个 block，消费者位置在系统分区
+                 && rollts_manager->sys_info.data_end_block_num   != ROLLTS_CFG_MAX_BLOCK_NUM(rollts_manager) - 1)
+            || rollts_manager->sys_info.log_size                  != ROLLTS_CFG_MAX_BLOCK_NUM(rollts_manager) * SINGLE_BLOCK_SIZE
+            || rollts_manager->sys_info.rollts_max_size           != ROLLTS_CFG_MAX_SIZE(rollts_manager)
             || rollts_manager->sys_info.single_block_size         != SINGLE_BLOCK_SIZE
             || rollts_manager->sys_info.min_write_unit_size       != MIN_WRITE_UNIT_SIZE
-            || rollts_manager->sys_info.rollts_max_block_num      != ROLLTS_MAX_BLOCK_NUM)
+            || rollts_manager->sys_info.rollts_max_block_num      != ROLLTS_CFG_MAX_BLOCK_NUM(rollts_manager))
         {
             ret = false;
         }
@@ -76,6 +204,17 @@ static bool check_if_sys_aligned(rollts_manager_t *rollts_manager)
         {
             rollts_manager->sys_info.data_start_addr  = rollts_manager->sys_info.data_start_block_num * rollts_manager->sys_info.single_block_size;
             rollts_manager->sys_info.data_end_addr    = (rollts_manager->sys_info.data_end_block_num)   * rollts_manager->sys_info.single_block_size;
+            // 旧布局分区原地挂载，已有 block 按旧布局逐块解析，清除后按当前布局重新写入系统分区
+            if(ROLLTS_LAYOUT_VERSION != rollts_manager->sys_info.layout_version)
+            {
+                log_info(" rollTs layout %d partition, old blocks kept in place", rollts_manager->sys_info.layout_version);
+                rollts_manager->legacy_layout = (uint8_t)rollts_manager->sys_info.layout_version;
+            }
+            // 追加记录占用代号位置的旧分区没有代号，按擦除值处理(与其 block 头中的代号一致)
+            if(offsetof(rollts_sys_t, generation) == sys_log_start(rollts_manager))
+            {
+                rollts_manager->sys_info.generation = 0xFFFFFFFF;
+            }
             ret = true;
         }
     }
@@ -88,923 +227,4606 @@ static bool check_if_sys_aligned(rollts_manager_t *rollts_manager)
  */
 static void rollts_manager_init(rollts_manager_t *rollts_manager)
 {
+    // 新代号在原代号基础上递增(原系统分区无效时同样递增读到的值)，
+    // block 头只保存 16 位，擦除值 0xFFFF 留给未记录代号的旧 block
+    uint16_t generation = (uint16_t)(rollts_manager->sys_info.generation + 1);
+    if(0xFFFF == generation)
+    {
+        generation = 0;
+    }
     rollts_manager->sys_info.magic_valid               = MAGIC_VALID;
     // 数据分区在系统分区后1 block
     rollts_manager->sys_info.data_start_block_num      = 1;        
-    rollts_manager->sys_info.data_end_block_num        = ROLLTS_MAX_BLOCK_NUM - 1;  
-    rollts_manager->sys_info.log_size                  = ROLLTS_MAX_BLOCK_NUM * SINGLE_BLOCK_SIZE;
-    rollts_manager->sys_info.rollts_max_size           = ROLLTS_MAX_SIZE; 
+    rollts_manager->sys_info.data_end_block_num        = ROLLTS_CFG_DATA_END_BLOCK(rollts_manager);
+    rollts_manager->sys_info.log_size                  = ROLLTS_CFG_MAX_BLOCK_NUM(rollts_manager) * SINGLE_BLOCK_SIZE;
+    rollts_manager->sys_info.rollts_max_size           = ROLLTS_CFG_MAX_SIZE(rollts_manager); 
     rollts_manager->sys_info.single_block_size         = SINGLE_BLOCK_SIZE;
     rollts_manager->sys_info.min_write_unit_size       = MIN_WRITE_UNIT_SIZE;
-    rollts_manager->sys_info.rollts_max_block_num      = ROLLTS_MAX_BLOCK_NUM;
+    rollts_manager->sys_info.rollts_max_block_num      = ROLLTS_CFG_MAX_BLOCK_NUM(rollts_manager);
     rollts_manager->sys_info.data_start_addr           = rollts_manager->sys_info.data_start_block_num * rollts_manager->sys_info.single_block_size;
     rollts_manager->sys_info.data_end_addr             = (rollts_manager->sys_info.data_end_block_num)  * rollts_manager->sys_info.single_block_size;
+    rollts_manager->sys_info.layout_version            = ROLLTS_LAYOUT_VERSION;
+    rollts_manager->sys_info.record_format             = ROLLTS_CFG_RECORD_FORMAT(rollts_manager);
+    rollts_manager->sys_info.generation                = generation;
 }
 
 /**
- * @func: 格式化 数据区head
+ * @func: 获取新 block 使用的日志格式
  */
-static int head_block_force_format(rollts_manager_t *rollts_manager)
+static uint8_t sys_record_format(rollts_manager_t *rollts_manager)
 {
-    log_debug("format head block...");
-    block_info_t block_info;
-    memset(&block_info, 0xFF, sizeof(block_info_t));
-    block_info.magic_valid = MAGIC_VALID;
-    block_info.data_num    = -1;
-    // 清除数据分区
-    uint32_t rollts_max_data_block_num = rollts_manager->sys_info.rollts_max_block_num - 1;
-    for (uint32_t i = 0; i < rollts_max_data_block_num; i++) 
-    { 
-        if(0 != rollts_manager->flash_ops.erase_sector(rollts_manager->sys_info.data_start_addr  + \
-                                                      rollts_manager->sys_info.single_block_size * i))
-        {
-            return -1;
-        }
-        else
-        {
-            if(1 == i)
-            {
-                // 写入数据分区起始地址
-                SET_HEAD(block_info);
-            }
-            else if(2 == i)
-            {
-                SET_BACKUP(block_info);
-            }
-            else
-            {
-                SET_NOT_HEAD(block_info);
-            }
-            // 初始化当前数据块
-            if(0 != rollts_manager->flash_ops.write_data(rollts_manager->sys_info.data_start_addr  + \
-                                                     rollts_manager->sys_info.single_block_size * i,
-                                                     &block_info, sizeof(block_info_t)))
-            {
-                return -1;
-            }  
-            else                                       
-            {
-                log_info(" Log Sector erase and init  at : 0x%x ", (rollts_manager->sys_info.data_start_addr  + \
-                                                rollts_manager->sys_info.single_block_size * i));
-            }
+    // 旧分区无该字段(擦除值)，按 v1 处理
+    uint32_t record_format = rollts_manager->sys_info.record_format;
+    if(ROLLTS_FMT_FIXED == (record_format & 0xFF) && 0xFFFFFFFF != record_format && 0 != (record_format >> 8))
+    {
+        return ROLLTS_FMT_FIXED;
+    }
+    return (ROLLTS_FMT_V2 == record_format) ? ROLLTS_FMT_V2 : ROLLTS_FMT_V1;
+}
+
+/**
+ * @func: 定长日志占用长度(提交标记 + 负载)
+ */
+static uint32_t sys_fixed_slot(rollts_manager_t *rollts_manager)
+{
+    return 1 + (rollts_manager->sys_info.record_format >> 8);
+}
+
+/**
+ * @func: block_status 中的日志格式
+ */
+static uint8_t block_record_format(const block_info_t *block_info)
+{
+    uint8_t format = GET_BLOCK_FORMAT((*block_info));
+    return (ROLLTS_FMT_V2 == format || ROLLTS_FMT_FIXED == format || ROLLTS_FMT_V1_BASE == format) ? format : ROLLTS_FMT_V1;
+}
+
+/**
+ * @func: 写入 block 头的标签位图
+ *        layout 1~3 的 magic 与当前布局标签位图/填充字节位置重叠，位图恰好等于 MAGIC_VALID 时多置标签 0(只多扫描该块)
+ */
+static uint32_t block_tag_bitmap(uint32_t tag_bitmap)
+{
+    return (MAGIC_VALID == tag_bitmap) ? (tag_bitmap | ROLLTS_TAG_MASK(0)) : tag_bitmap;
+}
 
+// 读取 block 头/日志区(定义在块内日志遍历部分)
+static void record_flash_read(rollts_manager_t *rollts_manager, uint32_t addr, void *data, uint32_t len);
+
+/**
+ * @func: 判断 block 头是否按旧布局写入(raw 为 block 起始 ROLLTS_LEGACY_HDR_MAX 字节)
+ *        layout 1~3 的 magic 位于当前布局标签位图/填充字节处(当前布局 block 该处不等于 MAGIC_VALID)，
+ *        当前布局 magic 位置是旧 block 的日志区，因此先检查旧布局 magic；
+ *        其余布局当前布局 magic 有效时优先按当前布局解析；layout 6 magic 位置与当前布局相同，
+ *        以 status 之后的填充字节区分(当前布局为擦除值，layout 6 为 32 位代号的次低字节)
+ *        返回旧布局，NULL: 当前布局或无效 block
+ */
+static const rollts_layout_t *block_layout(rollts_manager_t *rollts_manager, const uint8_t *raw)
+{
+    const rollts_layout_t *layout = legacy_layout_get(rollts_manager->legacy_layout);
+    uint32_t magic = 0;
+    if(NULL == layout)
+    {
+        return NULL;
+    }
+    if(layout->magic_valid < offsetof(block_info_t, agg))
+    {
+        memcpy(&magic, raw + layout->magic_valid, sizeof(uint32_t));
+        if(MAGIC_VALID == magic)
+        {
+            return layout;
         }
     }
-    rollts_manager->mem_tab.pre_addr         = rollts_manager->sys_info.data_start_addr;
-    rollts_manager->mem_tab.head_addr        = rollts_manager->mem_tab.pre_addr + rollts_manager->sys_info.single_block_size;
-    rollts_manager->mem_tab.head_backup_addr = rollts_manager->mem_tab.head_addr + rollts_manager->sys_info.single_block_size;
-    return 0;
+    memcpy(&magic, raw + offsetof(block_info_t, magic_valid), sizeof(uint32_t));
+    if(MAGIC_VALID == magic)
+    {
+        return (offsetof(block_info_t, magic_valid) == layout->magic_valid
+                && 0xFF != raw[offsetof(block_info_t, status) + 1]) ? layout : NULL;
+    }
+    memcpy(&magic, raw + layout->magic_valid, sizeof(uint32_t));
+    return (MAGIC_VALID == magic) ? layout : NULL;
 }
 
 /**
- * @func: 初始化所有分区信息
- *        
+ * @func: 读取 block 头
+ *        旧布局 block 转换为当前布局：没有的字段保持擦除值(标签位图/聚合值按未封顶处理，first_seq 由调用方推算)，
+ *        没有代号的旧布局 block 代号与系统分区一致
+ *        返回旧布局，NULL: 当前布局
  */
-static int rollts_format(rollts_manager_t *rollts_manager)
+static const rollts_layout_t *block_info_read(rollts_manager_t *rollts_manager, uint32_t block_addr, block_info_t *block_info)
 {
-    // 对物理地址进行初始化
-    if(0 != head_block_force_format(rollts_manager))
+    uint8_t raw[ROLLTS_LEGACY_HDR_MAX];
+    if(0 == rollts_manager->legacy_layout)
     {
-        log_info(" Log Sector erase failed! ");
-        return -1;
+        record_flash_read(rollts_manager, block_addr, block_info, sizeof(block_info_t));
+        return NULL;
     }
-    // 清除系统分区
-    if(0 != rollts_manager->flash_ops.erase_sector(0))
+    record_flash_read(rollts_manager, block_addr, raw, sizeof(raw));
+    const rollts_layout_t *layout = block_layout(rollts_manager, raw);
+    if(NULL == layout)
     {
-        return -1;
+        memcpy(block_info, raw, sizeof(block_info_t));
+        return NULL;
     }
-    else
+    memset(block_info, 0xFF, sizeof(block_info_t));
+    memcpy(&block_info->last_data_addr, raw + offsetof(block_info_t, last_data_addr), sizeof(uint32_t));
+    memcpy(&block_info->data_num, raw + offsetof(block_info_t, data_num), sizeof(int32_t));
+    if(0 != layout->tag_bitmap)
     {
-        if(0 != rollts_manager->flash_ops.write_data(0,&rollts_manager->sys_info, sizeof(rollts_sys_t)))
-        {
-            return -1;
-        }  
-        else                                       
+        memcpy(&block_info->tag_bitmap, raw + layout->tag_bitmap, sizeof(uint32_t));
+    }
+    if(0 != layout->agg)
+    {
+        memcpy(&block_info->agg, raw + layout->agg, sizeof(rollts_agg_t));
+    }
+    if(0 != layout->first_seq)
+    {
+        memcpy(&block_info->first_seq, raw + layout->first_seq, sizeof(uint64_t));
+    }
+    block_info->magic_valid = MAGIC_VALID;
+    block_info->status      = raw[layout->status];
+    if(layout->v1_base)
+    {
+        SET_BLOCK_FORMAT((*block_info), ROLLTS_FMT_V1_BASE);
+    }
+    block_info->generation  = ROLLTS_BLOCK_GENERATION(rollts_manager->sys_info);
+    if(0 != layout->generation)
+    {
+        uint32_t generation = 0;
+        memcpy(&generation, raw + layout->generation, sizeof(uint32_t));
+        if(generation != rollts_manager->sys_info.generation)
         {
-            log_info(" Sys Sector erase and init  at : 0x%x ", 0);
+            block_info->generation = (uint16_t)~block_info->generation;
         }
+    }
+    return layout;
+}
 
+/**
+ * @func: 读取 block 头单个字段(offset/len 为当前布局 block_info_t 中的位置)
+ */
+static void block_info_field(rollts_manager_t *rollts_manager, uint32_t block_addr, uint32_t offset, void *data, uint32_t len)
+{
+    if(0 == rollts_manager->legacy_layout)
+    {
+        record_flash_read(rollts_manager, block_addr + offset, data, len);
+        return;
     }
-    
-    log_info("rollts_format succeed!");                        
-    return 0;
+    block_info_t block_info;
+    block_info_read(rollts_manager, block_addr, &block_info);
+    memcpy(data, (uint8_t *)&block_info + offset, len);
 }
 
-/* function-------------------------------------------------------------------*/
 /**
- * @func: 提取上一个block
+ * @func: block 日志区起始地址
  */
-static uint32_t get_pre_block(rollts_manager_t *rollts_manager, uint32_t mem_addr)
+static uint32_t block_data_start(rollts_manager_t *rollts_manager, uint32_t block_addr)
 {
-    // 提取上一个block的内存地址
-    mem_addr = mem_addr - rollts_manager->sys_info.single_block_size;
+    block_info_t block_info;
+    const rollts_layout_t *layout = (0 == rollts_manager->legacy_layout) ? NULL
+                                  : block_info_read(rollts_manager, block_addr, &block_info);
+    return block_addr + ((NULL != layout) ? layout->hdr_size : sizeof(block_info_t));
+}
 
-    // 可以在这里添加对mem_addr边界的检查，防止越界访问
-    if (mem_addr < rollts_manager->sys_info.data_start_addr) 
+/**
+ * @func: 查找消费者 create 为 true 时不存在则分配空位
+ */
+static rollts_consumer_t *consumer_find(rollts_manager_t *rollts_manager, const char *name, bool create)
+{
+    rollts_consumer_t *free_slot = NULL;
+    for(uint32_t i = 0; i < ROLLTS_CONSUMER_MAX; i++)
     {
-        // 处理边界情况，例如回到循环缓冲区的末尾
-        mem_addr = rollts_manager->sys_info.data_end_addr;
+        rollts_consumer_t *consumer = &rollts_manager->consumers[i];
+        if(consumer->used && 0 == strncmp(consumer->name, name, ROLLTS_CONSUMER_NAME_LEN))
+        {
+            return consumer;
+        }
+        if(!consumer->used && NULL == free_slot)
+        {
+            free_slot = consumer;
+        }
     }
-    return mem_addr;
+    if(!create || NULL == free_slot)
+    {
+        return NULL;
+    }
+    memset(free_slot, 0, sizeof(rollts_consumer_t));
+    strncpy(free_slot->name, name, ROLLTS_CONSUMER_NAME_LEN - 1);
+    return free_slot;
 }
 
 /**
- * @func: 提取下一个block
+ * @func: 消费者扇区地址(数据分区之后的最后一个 block)
+ *        0: 旧分区没有消费者扇区，消费者位置追加在系统分区
  */
-static uint32_t get_next_block(rollts_manager_t *rollts_manager, uint32_t mem_addr)
+static uint32_t consumer_sector_addr(rollts_manager_t *rollts_manager)
 {
-    // 提取下一个block的内存地址
-    mem_addr = mem_addr + rollts_manager->sys_info.single_block_size;
-
-    // 添加对mem_addr边界的检查，防止越界访问
-    if (mem_addr > rollts_manager->sys_info.data_end_addr) 
+    uint32_t block_num = rollts_manager->sys_info.data_end_block_num + 1;
+    if(block_num >= rollts_manager->sys_info.rollts_max_block_num)
     {
-        // 处理边界情况，例如回到循环缓冲区的起始位置
-        mem_addr = rollts_manager->sys_info.data_start_addr;
+        return 0;
     }
-    
-    return mem_addr;
+    return block_num * rollts_manager->sys_info.single_block_size;
 }
 
 /**
- * @func: 获取最旧的数据块
- *
+ * @func: 填充一条追加记录(magic 为擦除值)
  */
-static uint32_t get_oldest_block(rollts_manager_t *rollts_manager)
+static void sys_entry_init(rollts_consumer_entry_t *entry, const char *name, uint64_t seq)
 {
-    return get_next_block(rollts_manager, rollts_manager->mem_tab.head_backup_addr);
+    memset(entry, 0, sizeof(rollts_consumer_entry_t));
+    strncpy(entry->name, name, ROLLTS_CONSUMER_NAME_LEN - 1);
+    entry->magic_valid = 0xFFFFFFFF;
+    entry->seq         = seq;
 }
 
 /**
- * @func: 格式化head block
+ * @func: 在 addr 写入一条追加记录(magic 最后写入)
  */
-static bool head_block_format(rollts_manager_t *rollts_manager)
+static int sys_entry_write(rollts_manager_t *rollts_manager, uint32_t addr,
+                           const char *name, uint32_t magic, uint64_t seq)
 {
-    log_debug("head_block_format start...");
-    uint32_t pre_addr  = 0;
-    uint32_t next_addr = 0;
-    if(rollts_manager->mem_tab.head_addr == rollts_manager->sys_info.data_start_addr) //head在起始块
+    rollts_consumer_entry_t entry;
+    sys_entry_init(&entry, name, seq);
+    if(0 != ROLLTS_FLASH_WRITE(rollts_manager, addr, &entry, sizeof(rollts_consumer_entry_t)))
     {
-        pre_addr  = rollts_manager->sys_info.data_end_addr;
-        next_addr = rollts_manager->sys_info.data_start_addr + rollts_manager->sys_info.single_block_size;
+        return -1;
     }
-    else if(rollts_manager->mem_tab.head_addr == rollts_manager->sys_info.data_end_addr) //head在结束块
+    entry.magic_valid = magic;
+    return ROLLTS_FLASH_WRITE(rollts_manager, addr + offsetof(rollts_consumer_entry_t, magic_valid),
+                                                &entry.magic_valid, sizeof(uint32_t));
+}
+
+/**
+ * @func: 系统分区追加一条记录
+ *        系统分区只在格式化/清除时擦除，写满返回 -1
+ */
+static int sys_log_append(rollts_manager_t *rollts_manager, const char *name, uint32_t magic, uint64_t seq)
+{
+    uint32_t addr = rollts_manager->sys_log_addr;
+    if(addr + sizeof(rollts_consumer_entry_t) > rollts_manager->sys_info.single_block_size)
     {
-        pre_addr  = rollts_manager->sys_info.data_end_addr - rollts_manager->sys_info.single_block_size;
-        next_addr = rollts_manager->sys_info.data_start_addr;
+        log_alt(" sys log full");
+        return -1;
     }
-    else
+    rollts_manager->sys_log_addr += sizeof(rollts_consumer_entry_t);
+    // 旧分区消费者位置与系统分区追加记录共用同一区域
+    if(0 == consumer_sector_addr(rollts_manager))
     {
-        pre_addr  = rollts_manager->mem_tab.head_addr - rollts_manager->sys_info.single_block_size;
-        next_addr = rollts_manager->mem_tab.head_addr + rollts_manager->sys_info.single_block_size;
+        rollts_manager->consumer_log_addr = rollts_manager->sys_log_addr;
     }
-    block_info_t pre_block_info;
-    block_info_t next_block_info;
-    memset(&pre_block_info , 0xFF, sizeof(block_info_t));
-    memset(&next_block_info, 0xFF, sizeof(block_info_t));
+    return sys_entry_write(rollts_manager, addr, name, magic, seq);
+}
 
-    rollts_manager->flash_ops.read_data(pre_addr,  &pre_block_info, sizeof(block_info_t));
-    rollts_manager->flash_ops.read_data(next_addr,&next_block_info, sizeof(block_info_t));
-    if(!IS_NOT_HEAD(pre_block_info))
+/**
+ * @func: 追加一条消费者位置
+ */
+static int consumer_entry_write(rollts_manager_t *rollts_manager, const rollts_consumer_t *consumer)
+{
+    if(0 == consumer_sector_addr(rollts_manager))
     {
-        memset(&pre_block_info , 0xFF, sizeof(block_info_t));
-        pre_block_info.magic_valid = MAGIC_VALID;
-        pre_block_info.data_num    = -1;
-        if(0 != rollts_manager->flash_ops.erase_sector(pre_addr))
-        {
-            return false;
-        }
-        if(0 != rollts_manager->flash_ops.write_data(pre_addr, &pre_block_info, sizeof(block_info_t)))
-        {
-            return false;
-        }
+        return sys_log_append(rollts_manager, consumer->name, MAGIC_CONSUMER_VALID, consumer->seq);
     }
-    if(!IS_BACKUP(next_block_info))
+    uint32_t addr = rollts_manager->consumer_log_addr;
+    rollts_manager->consumer_log_addr += sizeof(rollts_consumer_entry_t);
+    return sys_entry_write(rollts_manager, addr, consumer->name, MAGIC_CONSUMER_VALID, consumer->seq);
+}
+
+/**
+ * @func: 写入消费者位置表(消费者扇区或系统分区擦除后调用，每个消费者一条)
+ */
+static int consumer_table_write(rollts_manager_t *rollts_manager)
+{
+    uint32_t sector = consumer_sector_addr(rollts_manager);
+    rollts_manager->consumer_log_addr = (0 != sector) ? sector : rollts_manager->sys_log_addr;
+    for(uint32_t i = 0; i < ROLLTS_CONSUMER_MAX; i++)
     {
-        memset(&next_block_info , 0xFF, sizeof(block_info_t));
-        pre_block_info.magic_valid = MAGIC_VALID;
-        pre_block_info.data_num    = -1;
-        SET_BACKUP(next_block_info);
-        if(rollts_manager->flash_ops.erase_sector(next_addr))
-        {
-            return false;
-        }
-        if(rollts_manager->flash_ops.write_data(next_addr, &next_block_info, sizeof(block_info_t)))
+        if(rollts_manager->consumers[i].used && 0 != consumer_entry_write(rollts_manager, &rollts_manager->consumers[i]))
         {
-            return false;
+            return -1;
         }
     }
-    rollts_manager->mem_tab.head_backup_addr = next_addr;
-    rollts_manager->mem_tab.pre_addr         = pre_addr;
-    return true;
+    return 0;
 }
 
 /**
- * @func: 扫描起始数据块
+ * @func: 压缩消费者位置日志
+ *        只擦除消费者扇区并写回每个消费者的最新位置，不擦除系统分区；压缩中掉电只丢失消费者位置
  */
-static int scan_head_block(rollts_manager_t *rollts_manager)
+static int consumer_compact(rollts_manager_t *rollts_manager)
 {
-    int num = 0;
-    bool find_in_first                 = false;
-    bool find_in_last                  = false;
-    uint32_t find_head_block_addr     = 0;
+    if(0 != ROLLTS_FLASH_ERASE(rollts_manager, consumer_sector_addr(rollts_manager)))
+    {
+        return -1;
+    }
+    return consumer_table_write(rollts_manager);
+}
 
+// 判断区域是否为擦除值(定义在数据块初始化部分)
+static bool is_erased_range(rollts_manager_t *rollts_manager, uint32_t addr, uint32_t len);
+
+/**
+ * @func: 获取 head_backup block 中下一个空闲备份位置
+ *        备份位置用完时擦除 head_backup 并重写 block 头(掉电时挂载按 head_block_format 修复)
+ *        返回备份地址，0: 失败
+ */
+static uint32_t sys_backup_slot(rollts_manager_t *rollts_manager)
+{
+    uint32_t block_addr = rollts_manager->mem_tab.head_backup_addr;
+    uint32_t block_end  = block_addr + rollts_manager->sys_info.single_block_size;
     block_info_t block_info;
-    uint32_t rollts_max_data_block_num = rollts_manager->sys_info.rollts_max_block_num - 1;
-    for (uint32_t i = 0; i < rollts_max_data_block_num; i++) 
-    { 
-        block_info.magic_valid = 0;
-        rollts_manager->flash_ops.read_data(rollts_manager->sys_info.data_start_addr  + \
-                                            rollts_manager->sys_info.single_block_size * i,
-                                            &block_info, sizeof(block_info_t));
-        log_debug("----------------------------------------");                                
-        log_debug("block_info.last_data_addr     : 0x%x", block_info.last_data_addr);
-        log_debug("block_info.data_num           : %d", block_info.data_num);
-        log_debug("block_info.magic_valid        : 0x%x", block_info.magic_valid);    
-        log_debug("block_info.is_head            : %d", block_info.is_head);
-        log_debug("----------------------------------------");     
-        if(MAGIC_VALID == block_info.magic_valid)
+    ROLLTS_FLASH_READ(rollts_manager, block_addr, &block_info, sizeof(block_info_t));
+    if(MAGIC_VALID == block_info.magic_valid && IS_BACKUP(block_info))
+    {
+        for(uint32_t addr = block_addr + sizeof(block_info_t); addr + ROLLTS_SYS_BACKUP_SLOT <= block_end;
+            addr += ROLLTS_SYS_BACKUP_SLOT)
         {
-            // 查询是否是启动块
-            if(IS_HEAD(block_info))
+            if(is_erased_range(rollts_manager, addr, ROLLTS_SYS_BACKUP_SLOT))
             {
-                num++;
-                rollts_manager->mem_tab.head_addr =rollts_manager->sys_info.data_start_addr  + \
-                                                   rollts_manager->sys_info.single_block_size * i;
-                if(i == 0)
-                {
-                    find_in_first = true;
-                    find_head_block_addr = rollts_manager->mem_tab.head_addr;
-                }                             
-                if(i == rollts_max_data_block_num)
-                {
-                    find_in_last = true;
-                }
+                return addr;
             }
         }
-        else
+    }
+    memset(&block_info, 0xFF, sizeof(block_info_t));
+    block_info.magic_valid = MAGIC_VALID;
+    block_info.data_num    = -1;
+    block_info.generation  = ROLLTS_BLOCK_GENERATION(rollts_manager->sys_info);
+    SET_BACKUP(block_info);
+    if(0 != ROLLTS_FLASH_ERASE(rollts_manager, block_addr)
+       || 0 != ROLLTS_FLASH_WRITE(rollts_manager, block_addr, &block_info, sizeof(block_info_t)))
+    {
+        return 0;
+    }
+    return block_addr + sizeof(block_info_t);
+}
+
+/**
+ * @func: 压缩系统分区追加区
+ *        系统信息按 Flash 原样保留(旧布局分区仍按原布局识别)，追加区重写为日志格式记录与每个消费者一条；
+ *        擦除系统分区前先写入 head_backup 中的备份，压缩中掉电时挂载按备份恢复
+ */
+static int sys_log_compact(rollts_manager_t *rollts_manager)
+{
+    uint8_t  image[ROLLTS_SYS_BACKUP_MAX];
+    uint32_t start         = sys_log_start(rollts_manager);
+    uint32_t len           = start;
+    uint32_t record_format = 0xFFFFFFFF;
+    rollts_consumer_entry_t entry;
+    ROLLTS_FLASH_READ(rollts_manager, 0, image, start);
+    memcpy(&record_format, image + offsetof(rollts_sys_t, record_format), sizeof(uint32_t));
+    // 日志格式已由追加记录更新
+    if(record_format != rollts_manager->sys_info.record_format)
+    {
+        sys_entry_init(&entry, "", rollts_manager->sys_info.record_format);
+        entry.magic_valid = MAGIC_FORMAT_VALID;
+        memcpy(image + len, &entry, sizeof(rollts_consumer_entry_t));
+        len += sizeof(rollts_consumer_entry_t);
+    }
+    for(uint32_t i = 0; i < ROLLTS_CONSUMER_MAX && 0 == consumer_sector_addr(rollts_manager); i++)
+    {
+        if(rollts_manager->consumers[i].used)
         {
-            continue;
+            sys_entry_init(&entry, rollts_manager->consumers[i].name, rollts_manager->consumers[i].seq);
+            entry.magic_valid = MAGIC_CONSUMER_VALID;
+            memcpy(image + len, &entry, sizeof(rollts_consumer_entry_t));
+            len += sizeof(rollts_consumer_entry_t);
         }
     }
-    // 启动块出现在一头一尾
-    if(find_in_last && find_in_first)
+
+    // 1. 写入备份
+    rollts_sys_backup_t backup;
+    backup.magic_valid = 0xFFFFFFFF;
+    backup.len         = len;
+    backup.check       = crc_simple(image, len);
+    uint32_t slot = sys_backup_slot(rollts_manager);
+    if(0 == slot
+       || 0 != ROLLTS_FLASH_WRITE(rollts_manager, slot, &backup, sizeof(rollts_sys_backup_t))
+       || 0 != ROLLTS_FLASH_WRITE(rollts_manager, slot + sizeof(rollts_sys_backup_t), image, len))
     {
-        rollts_manager->mem_tab.head_addr = find_head_block_addr;
+        log_error(" sys log backup failed!");
+        return -1;
     }
-    return num;
-
+    backup.magic_valid = MAGIC_SYS_BACKUP_VALID;
+    if(0 != ROLLTS_FLASH_WRITE(rollts_manager, slot + offsetof(rollts_sys_backup_t, magic_valid),
+                                                &backup.magic_valid, sizeof(uint32_t)))
+    {
+        return -1;
+    }
+    // 2. 擦除并重写系统分区(失败时备份保留，下次挂载恢复)
+    if(0 != ROLLTS_FLASH_ERASE(rollts_manager, 0) || 0 != ROLLTS_FLASH_WRITE(rollts_manager, 0, image, len))
+    {
+        log_error(" sys sector rewrite failed!");
+        return -1;
+    }
+    // 3. 备份失效
+    backup.magic_valid = 0;
+    ROLLTS_FLASH_WRITE(rollts_manager, slot + offsetof(rollts_sys_backup_t, magic_valid),
+                                        &backup.magic_valid, sizeof(uint32_t));
+    rollts_manager->sys_log_addr = len;
+    if(0 == consumer_sector_addr(rollts_manager))
+    {
+        rollts_manager->consumer_log_addr = len;
+    }
+    log_info(" sys log compacted, %d bytes", len);
+    return 0;
 }
 
 /**
- * @func: 初始化内存表
+ * @func: 按 head_backup 中已提交的备份恢复系统分区(压缩系统分区时掉电)
+ *        系统分区内容与备份不一致时擦除重写，之后备份失效；按配置的 block 数查找，只读挂载不处理
  */
-static int rollts_mem_tab_init(rollts_manager_t *rollts_manager)
+static void sys_backup_restore(rollts_manager_t *rollts_manager)
 {
-    log_debug(" rollts_mem_tab_init start...");
-    // 扫描 head块
-    if(scan_head_block(rollts_manager) > 0)
+    uint8_t image[ROLLTS_SYS_BACKUP_MAX];
+    uint8_t cur[ROLLTS_SYS_BACKUP_MAX];
+    for(uint32_t block = 1; block < ROLLTS_CFG_MAX_BLOCK_NUM(rollts_manager) && !rollts_manager->read_only; block++)
     {
-        log_debug("scan_head_block_addr : 0x%x",rollts_manager->mem_tab.head_addr);
-        if(head_block_format(rollts_manager))
+        uint32_t block_addr = block * SINGLE_BLOCK_SIZE;
+        block_info_t block_info;
+        ROLLTS_FLASH_READ(rollts_manager, block_addr, &block_info, sizeof(block_info_t));
+        if(MAGIC_VALID != block_info.magic_valid || !IS_BACKUP(block_info))
         {
-            log_debug("rollts_manager->mem_tab.pre_addr        : 0x%x",rollts_manager->mem_tab.pre_addr);
-            log_debug("rollts_manager->mem_tab.head_addr       : 0x%x",rollts_manager->mem_tab.head_addr);
-            log_debug("rollts_manager->mem_tab.head_backup_addr: 0x%x",rollts_manager->mem_tab.head_backup_addr);
+            continue;
         }
-        else
+        for(uint32_t addr = block_addr + sizeof(block_info_t); addr + ROLLTS_SYS_BACKUP_SLOT <= block_addr + SINGLE_BLOCK_SIZE;
+            addr += ROLLTS_SYS_BACKUP_SLOT)
         {
-            log_error(" head_block_format failed!");
-            return -1;
+            rollts_sys_backup_t backup;
+            ROLLTS_FLASH_READ(rollts_manager, addr, &backup, sizeof(rollts_sys_backup_t));
+            if(0xFFFFFFFF == backup.len)
+            {
+                break;
+            }
+            if(MAGIC_SYS_BACKUP_VALID != backup.magic_valid || backup.len > sizeof(image))
+            {
+                continue;
+            }
+            ROLLTS_FLASH_READ(rollts_manager, addr + sizeof(rollts_sys_backup_t), image, backup.len);
+            ROLLTS_FLASH_READ(rollts_manager, 0, cur, backup.len);
+            if(backup.check != crc_simple(image, backup.len))
+            {
+                continue;
+            }
+            if(0 != memcmp(cur, image, backup.len)
+               || !is_erased_range(rollts_manager, backup.len, SINGLE_BLOCK_SIZE - backup.len))
+            {
+                log_alt(" sys sector compaction interrupted, restore from backup 0x%x", addr);
+                if(0 != ROLLTS_FLASH_ERASE(rollts_manager, 0) || 0 != ROLLTS_FLASH_WRITE(rollts_manager, 0, image, backup.len))
+                {
+                    log_error(" sys sector restore failed!");
+                    return;
+                }
+            }
+            backup.magic_valid = 0;
+            ROLLTS_FLASH_WRITE(rollts_manager, addr + offsetof(rollts_sys_backup_t, magic_valid),
+                                                &backup.magic_valid, sizeof(uint32_t));
         }
-        return 0;
     }
-    else
+}
+
+/**
+ * @func: 加载 [addr, end) 内的追加记录 同名消费者取最后一条已提交记录，日志格式取最后一条更新记录
+ *        返回下一个空位
+ */
+static uint32_t sys_log_load(rollts_manager_t *rollts_manager, uint32_t addr, uint32_t end)
+{
+    rollts_consumer_entry_t entry;
+    rollts_consumer_entry_t empty;
+    memset(&empty, 0xFF, sizeof(rollts_consumer_entry_t));
+    while(addr + sizeof(rollts_consumer_entry_t) <= end)
     {
-        log_alt(" scan_head_block_addr not found!");
-        if(0 == head_block_force_format(rollts_manager))
+        ROLLTS_FLASH_READ(rollts_manager, addr, &entry, sizeof(rollts_consumer_entry_t));
+        if(0 == memcmp(&entry, &empty, sizeof(rollts_consumer_entry_t)))
         {
-            return 0;
+            break;
         }
-        rollts_manager->is_init = 0;
-        return -1;
+        // 未提交(写入中断)的记录跳过
+        if(MAGIC_CONSUMER_VALID == entry.magic_valid)
+        {
+            entry.name[ROLLTS_CONSUMER_NAME_LEN - 1] = '\0';
+            rollts_consumer_t *consumer = consumer_find(rollts_manager, entry.name, true);
+            if(NULL != consumer)
+            {
+                consumer->used = true;
+                consumer->seq  = entry.seq;
+            }
+        }
+        else if(MAGIC_FORMAT_VALID == entry.magic_valid)
+        {
+            rollts_manager->sys_info.record_format = (uint32_t)entry.seq;
+        }
+        addr += sizeof(rollts_consumer_entry_t);
     }
+    return addr;
 }
 
 /**
- * @func: 初始化数据块结构体
- * 
+ * @func: 加载系统分区追加记录与消费者位置
  */
-static void data_block_loop(rollts_manager_t *rollts_manager)
+static void consumer_load(rollts_manager_t *rollts_manager)
 {
-    memset(&rollts_manager->rollts_data,0x00,sizeof(rollts_data_t));
+    memset(rollts_manager->consumers, 0, sizeof(rollts_manager->consumers));
+    uint32_t block_size = rollts_manager->sys_info.single_block_size;
+    uint32_t sector     = consumer_sector_addr(rollts_manager);
+    rollts_manager->sys_log_addr      = sys_log_load(rollts_manager, sys_log_start(rollts_manager), block_size);
+    rollts_manager->consumer_log_addr = (0 != sector) ? sys_log_load(rollts_manager, sector, sector + block_size)
+                                                      : rollts_manager->sys_log_addr;
+}
 
-    uint32_t start_addr  = rollts_manager->mem_tab.pre_addr + sizeof(block_info_t);
-    uint32_t end_addr    = rollts_manager->mem_tab.pre_addr + rollts_manager->sys_info.single_block_size - 1;
+/**
+ * @func: 判断定长格式是否变化
+ *        已写入的定长 block 依赖系统分区中的负载长度解析，长度或格式变化时需要重新格式化
+ */
+static bool sys_fixed_format_changed(rollts_manager_t *rollts_manager)
+{
+    return ROLLTS_FMT_FIXED == sys_record_format(rollts_manager)
+        && ROLLTS_CFG_RECORD_FORMAT(rollts_manager) != rollts_manager->sys_info.record_format;
+}
 
-    bool is_block_info_valid = true;
-    // 首先查询block_info是否已经写入了end_addr 和 data_num
-    block_info_t current_block_info;
-    rollts_manager->flash_ops.read_data(rollts_manager->mem_tab.pre_addr, &current_block_info, sizeof(block_info_t));
-    if((0xFFFFFFFF != current_block_info.last_data_addr)
-     &&(-1         != current_block_info.data_num))
+/**
+ * @func: 更新系统分区日志格式
+ *        v1 分区升级时该字段为擦除值，直接写入；其余情况在系统分区追加格式更新记录，不擦除系统分区
+ *        已写入的 block 保持原格式，回滚成为写入块时按新格式写入
+ */
+static int sys_record_format_update(rollts_manager_t *rollts_manager)
+{
+    uint32_t record_format = ROLLTS_CFG_RECORD_FORMAT(rollts_manager);
+    if(rollts_manager->read_only || record_format == rollts_manager->sys_info.record_format)
     {
-        rollts_manager->current_block_full = true;
-        // 当前数据块已经写入了数据
-        if((0xFFFFFFFF == current_block_info.last_data_addr)
-                ||(-1  == current_block_info.data_num))
+        return 0;
+    }
+    log_info(" record format 0x%x -> 0x%x", rollts_manager->sys_info.record_format, record_format);
+    if(0xFFFFFFFF == rollts_manager->sys_info.record_format)
+    {
+        rollts_manager->sys_info.record_format = record_format;
+        return ROLLTS_FLASH_WRITE(rollts_manager, offsetof(rollts_sys_t, record_format),
+                                                    &rollts_manager->sys_info.record_format, sizeof(uint32_t));
+    }
+    if(rollts_manager->sys_log_addr + sizeof(rollts_consumer_entry_t) > rollts_manager->sys_info.single_block_size
+       && 0 != sys_log_compact(rollts_manager))
+    {
+        // 追加区已满且压缩失败，新 block 继续使用原格式，rollts_clear 后生效
+        log_alt(" sys log full, keep record format 0x%x", rollts_manager->sys_info.record_format);
+        return 0;
+    }
+    if(0 != sys_log_append(rollts_manager, "", MAGIC_FORMAT_VALID, record_format))
+    {
+        return -1;
+    }
+    rollts_manager->sys_info.record_format = record_format;
+    return 0;
+}
+
+/**
+ * @func: 格式化 数据区head
+ *        只擦除写入块/head/backup，其余 block 代号与新代号不一致，视为已清除，
+ *        回滚成为 backup 时擦除；代号恰好与新代号相同的旧 block 立即擦除
+ */
+static int head_block_force_format(rollts_manager_t *rollts_manager)
+{
+    log_debug("format head block...");
+    block_info_t block_info;
+    memset(&block_info, 0xFF, sizeof(block_info_t));
+    block_info.magic_valid = MAGIC_VALID;
+    block_info.data_num    = -1;
+    block_info.generation  = ROLLTS_BLOCK_GENERATION(rollts_manager->sys_info);
+    SET_BLOCK_FORMAT(block_info, sys_record_format(rollts_manager));
+    // 清除数据分区
+    uint32_t rollts_max_data_block_num = ROLLTS_DATA_BLOCK_NUM(rollts_manager);
+    for (uint32_t i = 0; i < rollts_max_data_block_num; i++) 
+    { 
+        if(i >= 3)
         {
-            // 完整性检查不通过，需要进行日志修复
-            log_alt("rollts_data_block_loop: block_info integrity check failed");
-            log_alt("repair...");
-            is_block_info_valid = false;
+            block_info_t old_info;
+            uint32_t block_addr = rollts_manager->sys_info.data_start_addr + rollts_manager->sys_info.single_block_size * i;
+            block_info_read(rollts_manager, block_addr, &old_info);
+            if(MAGIC_VALID == old_info.magic_valid && old_info.generation == ROLLTS_BLOCK_GENERATION(rollts_manager->sys_info)
+               && 0 != ROLLTS_FLASH_ERASE(rollts_manager, block_addr))
+            {
+                return -1;
+            }
+            continue;
+        }
+        if(0 != ROLLTS_FLASH_ERASE(rollts_manager, rollts_manager->sys_info.data_start_addr  + \
+                                                      rollts_manager->sys_info.single_block_size * i))
+        {
+            return -1;
         }
         else
         {
-            // 完整性检查通过，进行数据块数据初始化
-            rollts_manager->flash_ops.read_data(current_block_info.last_data_addr, 
-                                                     &rollts_manager->rollts_data, sizeof(rollts_data_t));
-            rollts_manager->cur_block_data_num = current_block_info.data_num;
-            return;
+            // 首块为写入块，序号接续 cur_block_first_seq
+            block_info.first_seq = (0 == i) ? rollts_manager->cur_block_first_seq : ROLLTS_SEQ_NONE;
+            if(1 == i)
+            {
+                // 写入数据分区起始地址
+                SET_HEAD(block_info);
+            }
+            else if(2 == i)
+            {
+                SET_BACKUP(block_info);
+            }
+            else
+            {
+                SET_NOT_HEAD(block_info);
+            }
+            // 初始化当前数据块
+            if(0 != ROLLTS_FLASH_WRITE(rollts_manager, rollts_manager->sys_info.data_start_addr  + \
+                                                     rollts_manager->sys_info.single_block_size * i,
+                                                     &block_info, sizeof(block_info_t)))
+            {
+                return -1;
+            }  
+            else                                       
+            {
+                log_info(" Log Sector erase and init  at : 0x%x ", (rollts_manager->sys_info.data_start_addr  + \
+                                                rollts_manager->sys_info.single_block_size * i));
+            }
+
         }
     }
-    else
-    {
-        rollts_manager->current_block_full = false;
-    }
-    rollts_data_t tmp_rollts_data;
-    memset(&tmp_rollts_data,0x00,sizeof(rollts_data_t));
-    // 遍历数据块
-    rollts_manager->cur_block_data_num = 0;
+    rollts_manager->mem_tab.pre_addr         = rollts_manager->sys_info.data_start_addr;
+    rollts_manager->mem_tab.head_addr        = rollts_manager->mem_tab.pre_addr + rollts_manager->sys_info.single_block_size;
+    rollts_manager->mem_tab.head_backup_addr = rollts_manager->mem_tab.head_addr + rollts_manager->sys_info.single_block_size;
+    return 0;
+}
 
-    rollts_manager->flash_ops.read_data(start_addr, &tmp_rollts_data, sizeof(rollts_data_t));
-    if(MAGIC_DATA_VALID != tmp_rollts_data.magic_valid)
+/**
+ * @func: 初始化所有分区信息
+ *        先写入新代号的系统分区，数据区格式化中断时挂载找不到同代号 head，重新格式化
+ *        keep_consumer: 消费者扇区位置不变(清除)时保留其内容，不擦除
+ */
+static int rollts_format(rollts_manager_t *rollts_manager, bool keep_consumer)
+{
+    // 清除系统分区
+    if(0 != ROLLTS_FLASH_ERASE(rollts_manager, 0))
     {
-        // 第一数据区为空
-        log_debug(" tmp_rollts_data find first empty");
-        // 从头开始写数据
-        rollts_manager->rollts_data.magic_valid = MAGIC_DATA_VALID;
-
-        rollts_manager->rollts_data.pre_addr  = 0;
-        rollts_manager->rollts_data.cur_addr  = start_addr;
+        return -1;
     }
     else
     {
-        rollts_manager->rollts_data.magic_valid = MAGIC_DATA_VALID;
-        rollts_manager->rollts_data.pre_addr    = tmp_rollts_data.cur_addr;
-        rollts_manager->rollts_data.cur_addr    = tmp_rollts_data.next_addr;
-
-        start_addr  = tmp_rollts_data.next_addr;
-        while(start_addr <= end_addr) //写入时保证有效数据的next不超限制
+        if(0 != ROLLTS_FLASH_WRITE(rollts_manager, 0,&rollts_manager->sys_info, sizeof(rollts_sys_t)))
+        {
+            return -1;
+        }  
+        else                                       
+        {
+            log_info(" Sys Sector erase and init  at : 0x%x ", 0);
+        }
+        // 系统分区已按当前布局写入，旧布局 block 代号与新代号不一致，视为已清除
+        rollts_manager->legacy_layout = 0;
+        rollts_manager->legacy_seq    = 0;
+        // 清除日志时保留消费者位置(序号继续递增)
+        uint32_t sector = consumer_sector_addr(rollts_manager);
+        rollts_manager->sys_log_addr = ROLLTS_CONSUMER_AREA_ADDR;
+        if(!keep_consumer || 0 == sector)
         {
-            rollts_manager->flash_ops.read_data(start_addr, &tmp_rollts_data, sizeof(rollts_data_t));
-            
-            if(MAGIC_DATA_VALID == tmp_rollts_data.magic_valid)
+            if(0 != sector && 0 != ROLLTS_FLASH_ERASE(rollts_manager, sector))
             {
-                // 当前block数据条数增加
-                rollts_manager->cur_block_data_num++;
-                start_addr  = tmp_rollts_data.next_addr;
-                // 保证rollts_data 始终为当前可写空位
-                rollts_manager->rollts_data.magic_valid = MAGIC_DATA_VALID;
-                rollts_manager->rollts_data.pre_addr    = tmp_rollts_data.cur_addr;
-                rollts_manager->rollts_data.cur_addr    = tmp_rollts_data.next_addr;
+                return -1;
             }
-            else
+            if(0 != consumer_table_write(rollts_manager))
             {
-                // 当前数据头为空
-                log_debug(" tmp_rollts_data find empty");
-                break;
+                return -1;
             }
-
         }
 
     }
-
-    if(false  == is_block_info_valid)
+    // 对物理地址进行初始化
+    if(0 != head_block_force_format(rollts_manager))
     {
-        // 修复blcok info
-        // 完整性检查失败，进行数据块数据初始化
-        current_block_info.last_data_addr = start_addr;
-        current_block_info.data_num       = rollts_manager->cur_block_data_num;
-
-        log_debug("writting last_data_addr... 0x%x",current_block_info.last_data_addr);
-        rollts_manager->flash_ops.write_data(rollts_manager->mem_tab.pre_addr + offsetof(block_info_t, last_data_addr),
-                                            &current_block_info.last_data_addr, sizeof(uint32_t));
-        
-        log_debug("writting data_num... %d",current_block_info.data_num);
-        rollts_manager->flash_ops.write_data(rollts_manager->mem_tab.pre_addr + offsetof(block_info_t, data_num),
-                                            &current_block_info.data_num, sizeof(uint32_t));                                       
-
+        log_info(" Log Sector erase failed! ");
+        return -1;
     }
+    
+    log_info("rollts_format succeed!");                        
+    return 0;
 }
 
 /* function-------------------------------------------------------------------*/
 /**
- * @func: head日志块迁移
+ * @func: 提取上一个block
  */
-static int head_block_move(rollts_manager_t *rollts_manager)
+static uint32_t get_pre_block(rollts_manager_t *rollts_manager, uint32_t mem_addr)
 {
-    log_debug("(pre)memtab:pre_addr        :0x%x",rollts_manager->mem_tab.pre_addr);
-    log_debug("(pre)memtab:head_addr       :0x%x",rollts_manager->mem_tab.head_addr);
-    log_debug("(pre)memtab:head_backup_addr:0x%x",rollts_manager->mem_tab.head_backup_addr);
-    block_info_t block_info;
-    memset(&block_info,0xFF,sizeof(block_info_t));
-    block_info.magic_valid = MAGIC_VALID;
-    block_info.data_num    = -1;
-    // 1. 将head_back 置为head
-    SET_HEAD(block_info);
-    rollts_manager->flash_ops.write_data(rollts_manager->mem_tab.head_backup_addr
-                                              ,&block_info, sizeof(block_info_t));
-    // 2. 将之前head置为数据区
-    SET_NOT_HEAD(block_info);
-    rollts_manager->flash_ops.erase_sector(rollts_manager->mem_tab.head_addr);
-    rollts_manager->flash_ops.write_data(rollts_manager->mem_tab.head_addr
-                                              ,&block_info, sizeof(block_info_t));                               
-    // 3.更新rollts_manager->mem_tab
-    log_debug("mem_tab fresh...");
-    uint32_t pre_addr  = 0;
-    uint32_t cur_addr  = 0;
-    uint32_t next_addr = 0;
-    pre_addr           = rollts_manager->mem_tab.head_addr;
-    cur_addr           = rollts_manager->mem_tab.head_backup_addr;
-    next_addr          = rollts_manager->mem_tab.head_backup_addr + rollts_manager->sys_info.single_block_size;
+    // 提取上一个block的内存地址
+    mem_addr = mem_addr - rollts_manager->sys_info.single_block_size;
 
-    if(next_addr > rollts_manager->sys_info.data_end_addr)
+    // 可以在这里添加对mem_addr边界的检查，防止越界访问
+    if (mem_addr < rollts_manager->sys_info.data_start_addr) 
     {
-        next_addr = rollts_manager->sys_info.data_start_addr;
+        // 处理边界情况，例如回到循环缓冲区的末尾
+        mem_addr = rollts_manager->sys_info.data_end_addr;
+    }
+    return mem_addr;
+}
+
+/**
+ * @func: 提取下一个block
+ *        条带化时相邻 block 按 ROLLTS_STRIPE_DEV 映射轮换器件，下一个条带单元位于另一器件
+ */
+static uint32_t get_next_block(rollts_manager_t *rollts_manager, uint32_t mem_addr)
+{
+    // 提取下一个block的内存地址
+    mem_addr = mem_addr + rollts_manager->sys_info.single_block_size;
+
+    // 添加对mem_addr边界的检查，防止越界访问
+    if (mem_addr > rollts_manager->sys_info.data_end_addr) 
+    {
+        // 处理边界情况，例如回到循环缓冲区的起始位置
+        mem_addr = rollts_manager->sys_info.data_start_addr;
     }
     
-    rollts_manager->mem_tab.pre_addr         = pre_addr;
-    rollts_manager->mem_tab.head_addr        = cur_addr;
-    rollts_manager->mem_tab.head_backup_addr = next_addr;
+    return mem_addr;
+}
 
-    // 4.将之前head_back后1 block置为head_back
-    SET_BACKUP(block_info);
-    rollts_manager->flash_ops.erase_sector(rollts_manager->mem_tab.head_backup_addr);
-    rollts_manager->flash_ops.write_data(rollts_manager->mem_tab.head_backup_addr 
-                                              ,&block_info, sizeof(block_info_t)); 
-    rollts_manager->current_block_full = false;
-    // 打印 memtab信息
-    log_debug("memtab:pre_addr        :0x%x",rollts_manager->mem_tab.pre_addr);
-    log_debug("memtab:head_addr       :0x%x",rollts_manager->mem_tab.head_addr);
-    log_debug("memtab:head_backup_addr:0x%x",rollts_manager->mem_tab.head_backup_addr);
+/**
+ * @func: 获取最旧的数据块
+ *
+ */
+static uint32_t get_oldest_block(rollts_manager_t *rollts_manager)
+{
+    if(0 != rollts_manager->mem_tab.live_addr)
+    {
+        return rollts_manager->mem_tab.live_addr;
+    }
+    return get_next_block(rollts_manager, rollts_manager->mem_tab.head_backup_addr);
+}
 
-    // 5.从头开始写块数据
-    rollts_manager->rollts_data.magic_valid = MAGIC_DATA_VALID;
-    rollts_manager->rollts_data.pre_addr  = 0;
-    rollts_manager->rollts_data.cur_addr  = rollts_manager->mem_tab.pre_addr + sizeof(block_info_t);
+/**
+ * @func: 循环顺序下 from 到 to 相隔的 block 数
+ */
+static uint32_t block_distance(rollts_manager_t *rollts_manager, uint32_t from, uint32_t to)
+{
+    uint32_t block_size = rollts_manager->sys_info.single_block_size;
+    uint32_t data_size  = rollts_manager->sys_info.data_end_addr + block_size - rollts_manager->sys_info.data_start_addr;
+    return (to + data_size - from) % data_size / block_size;
+}
 
-    // test
-    // {
+/**
+ * @func: 查找最旧有效 block
+ *        清除后代号不一致的 block 位于 head_backup 之后、有效 block 之前，回滚时逐个回收
+ */
+static void stale_block_scan(rollts_manager_t *rollts_manager)
+{
+    uint32_t first      = get_next_block(rollts_manager, rollts_manager->mem_tab.head_backup_addr);
+    uint32_t block_addr = first;
+    rollts_manager->mem_tab.live_addr        = 0;
+    rollts_manager->mem_tab.stale_erased_num = 0;
+    while(block_addr != rollts_manager->mem_tab.pre_addr)
+    {
+        block_info_t block_info;
+        block_info_read(rollts_manager, block_addr, &block_info);
+        if(MAGIC_VALID == block_info.magic_valid && block_info.generation == ROLLTS_BLOCK_GENERATION(rollts_manager->sys_info))
+        {
+            break;
+        }
+        block_addr = get_next_block(rollts_manager, block_addr);
+    }
+    if(block_addr != first)
+    {
+        log_info(" %d cleared blocks pending erase", block_distance(rollts_manager, first, block_addr));
+        rollts_manager->mem_tab.live_addr = block_addr;
+    }
+}
 
-    //     block_info_t block_info_test;  
+/**
+ * @func: 判断是否为未提交的日志头
+ *        日志头先于负载写入、magic 最后写入，掉电中断时头部有效但 magic 仍为擦除值
+ */
+static bool is_uncommitted_head(const rollts_data_t *head, uint32_t data_addr, uint32_t block_end)
+{
+    return (0xFFFFFFFF == head->magic_valid)
+        && (data_addr == head->cur_addr)
+        && (head->next_addr > data_addr)
+        && (head->next_addr <= block_end);
+}
 
-    //     memset(&block_info_test,0x00,sizeof(block_info_t));     
-    //     rollts_manager->flash_ops.read_data(rollts_manager->mem_tab.pre_addr
-    //                                             ,&block_info_test, sizeof(block_info_t));
-    //     log_debug("pre block_info_test:is_head         :0x%x",block_info_test.is_head);
-    //     log_debug("pre block_info_test:head_addr       :0x%x",block_info_test.magic_valid);                                       
+/**
+ * 块内日志遍历位置
+ */
+typedef struct
+{
+    uint32_t                 block_addr;
+    uint32_t                  data_addr;                // 当前日志头地址
+    rollts_data_t                  head;                // 当前日志头(v2 解码为同一结构)
+    uint32_t                 data_start;                // 块内日志区起始地址(旧布局 block 头长度不同)
+    uint32_t                   data_end;                // 块内日志区结束地址(有偏移表时为偏移表起始)
+    uint8_t                      format;                // block 日志格式
+    uint8_t                     hdr_len;                // 当前日志头长度
+} record_pos_t;
 
-    //     memset(&block_info_test,0x00,sizeof(block_info_t));                                        
-    //     rollts_manager->flash_ops.read_data(rollts_manager->mem_tab.head_addr
-    //                                             ,&block_info_test, sizeof(block_info_t));
-    //     log_debug("head block_info_test:is_head         :0x%x",block_info_test.is_head);
-    //     log_debug("head block_info_test:head_addr       :0x%x",block_info_test.magic_valid);
+/**
+ * @func: 读取 block 头/日志区 命中预读窗口时从内存拷贝
+ */
+static void record_flash_read(rollts_manager_t *rollts_manager, uint32_t addr, void *data, uint32_t len)
+{
+    rollts_window_t *window = rollts_manager->window;
+    if (NULL != window && addr >= window->addr && addr + len <= window->addr + window->len)
+    {
+        memcpy(data, window->buf + (addr - window->addr), len);
+        return;
+    }
+    ROLLTS_FLASH_READ(rollts_manager, addr, data, len);
+}
 
-    //     memset(&block_info_test,0x00,sizeof(block_info_t));                                        
-    //     rollts_manager->flash_ops.read_data(rollts_manager->mem_tab.head_backup_addr
-    //                                             ,&block_info_test, sizeof(block_info_t));   
-    //     log_debug("head back block_info_test:is_head         :0x%x",block_info_test.is_head);
-    //     log_debug("head back block_info_test:head_addr       :0x%x",block_info_test.magic_valid);
-    // }
-    return 0;
+/**
+ * @func: 读取 block 日志格式与日志区范围
+ *        返回块尾偏移表条数(0:无偏移表)
+ */
+static uint32_t record_block_init(rollts_manager_t *rollts_manager, uint32_t block_addr, record_pos_t *pos)
+{
+    block_info_t block_info;
+    const rollts_layout_t *layout = block_info_read(rollts_manager, block_addr, &block_info);
+    pos->block_addr = block_addr;
+    pos->format     = block_record_format(&block_info);
+    pos->data_start = block_addr + ((NULL != layout) ? layout->hdr_size : sizeof(block_info_t));
+    pos->data_end   = block_addr + rollts_manager->sys_info.single_block_size;
+    if (!HAS_BLOCK_FOOTER(block_info) || block_info.data_num <= 0)
+    {
+        return 0;
+    }
+    pos->data_end  -= ROLLTS_FOOTER_SIZE(block_info.data_num);
+    return (uint32_t)block_info.data_num;
 }
 
 /**
- * @func: 查找最后一个日志位置,并计算是否需要切换日志块
+ * @func: 计算日志头长度
  */
-static bool find_the_last_position_and_calc(rollts_manager_t *rollts_manager,
-                                                uint32_t    frame_len,
-                                                uint32_t  payload_len)
+static uint32_t record_hdr_len(uint8_t format, uint32_t payload_len)
 {
-    // 当前块是否已经封顶
-    if(rollts_manager->current_block_full)
+    if(ROLLTS_FMT_FIXED == format)
     {
-        log_debug("current block is full,need to move to next block");
-        return false;
+        return 1;
+    }
+    if(ROLLTS_FMT_V1_BASE == format)
+    {
+        return ROLLTS_V1_BASE_HDR_LEN;
+    }
+    if(ROLLTS_FMT_V2 != format)
+    {
+        return sizeof(rollts_data_t);
     }
+    return (payload_len < (1u << 7)) ? 3 : (payload_len < (1u << 14)) ? 4 : 5;
+}
 
-    // 不可超过当前block最后一位
-    if((rollts_manager->rollts_data.cur_addr % rollts_manager->sys_info.single_block_size + frame_len \
-         < rollts_manager->sys_info.single_block_size ))
+/**
+ * @func: 编码日志头(提交标记保持擦除值)
+ *        v2 长度按 hdr_len 定长编码，分片时头长度可按剩余负载预先确定
+ */
+static void record_encode_head(uint8_t format, const rollts_data_t *head, uint32_t hdr_len, uint8_t *buf)
+{
+    if(ROLLTS_FMT_FIXED == format)
     {
-        // 不需要切换日志块
-        rollts_manager->rollts_data.next_addr     = rollts_manager->rollts_data.cur_addr + frame_len;
-        rollts_manager->rollts_data.payload_len   = payload_len;
-        // 当前block数据条数增加
-        rollts_manager->cur_block_data_num++;
+        buf[0] = 0xFF;
+        return;
+    }
+    if(ROLLTS_FMT_V2 != format)
+    {
+        rollts_data_t tmp = *head;
+        tmp.magic_valid   = 0xFFFFFFFF;
+        memcpy(buf, &tmp, sizeof(rollts_data_t));
+        return;
+    }
+    uint32_t len = head->payload_len;
+    buf[0] = 0xFF;
+    buf[1] = (uint8_t)(((head->frag & 0x03) << 5) | (head->tag & 0x1F));
+    for(uint32_t i = 2; i < hdr_len; i++)
+    {
+        buf[i] = (uint8_t)((len & 0x7F) | ((i + 1 < hdr_len) ? 0x80 : 0x00));
+        len >>= 7;
+    }
+}
 
-        log_debug("rollts_data.magic_valid:0x%x",rollts_manager->rollts_data.magic_valid);
-        log_debug("rollts_data.pre_addr   :0x%x",rollts_manager->rollts_data.pre_addr);
-        log_debug("rollts_data.cur_addr   :0x%x",rollts_manager->rollts_data.cur_addr);
-        log_debug("rollts_data.next_addr  :0x%x",rollts_manager->rollts_data.next_addr);
-        log_debug("rollts_data.payload_len:%d"  ,rollts_manager->rollts_data.payload_len);
-        return true;
+/**
+ * @func: 读取并解码日志头
+ *        v2 日志头解码为 rollts_data_t：已提交 magic 置为 MAGIC_DATA_VALID，未提交保持 0xFFFFFFFF
+ *        返回日志头长度，0: 空位或越界
+ */
+static uint32_t record_decode_head(rollts_manager_t *rollts_manager, uint8_t format,
+                                   uint32_t data_addr, uint32_t block_end, rollts_data_t *head)
+{
+    if(ROLLTS_FMT_FIXED == format)
+    {
+        uint32_t slot   = sys_fixed_slot(rollts_manager);
+        uint8_t  marker = 0xFF;
+        if(data_addr + slot > block_end)
+        {
+            return 0;
+        }
+        record_flash_read(rollts_manager, data_addr, &marker, sizeof(uint8_t));
+        if(ROLLTS_FIXED_COMMIT != (marker & ROLLTS_FIXED_COMMIT_MASK))
+        {
+            // 空位(定长 block 内无空洞，未提交的空位之后不再有日志)
+            return 0;
+        }
+        memset(head, 0, sizeof(rollts_data_t));
+        head->magic_valid = MAGIC_DATA_VALID;
+        head->cur_addr    = data_addr;
+        head->next_addr   = data_addr + slot;
+        head->payload_len = slot - 1;
+        head->tag         = marker & 0x1F;
+        head->frag        = ROLLTS_FRAG_NONE;
+        return 1;
     }
-    else
+    if(ROLLTS_FMT_V1_BASE == format)
     {
-        //需要切换日志块
-        log_debug("no space in current block,need switch to next block");
+        if(data_addr + ROLLTS_V1_BASE_HDR_LEN > block_end)
+        {
+            return 0;
+        }
+        memset(head, 0, sizeof(rollts_data_t));
+        record_flash_read(rollts_manager, data_addr, head, ROLLTS_V1_BASE_HDR_LEN);
+        return ROLLTS_V1_BASE_HDR_LEN;
+    }
+    if(ROLLTS_FMT_V2 != format)
+    {
+        if(data_addr + sizeof(rollts_data_t) > block_end)
+        {
+            return 0;
+        }
+        record_flash_read(rollts_manager, data_addr, head, sizeof(rollts_data_t));
+        return sizeof(rollts_data_t);
+    }
+    uint8_t  buf[ROLLTS_V2_HDR_MAX];
+    uint32_t n = block_end - data_addr;
+    if(data_addr + ROLLTS_V2_HDR_MIN > block_end)
+    {
+        return 0;
+    }
+    n = (n > ROLLTS_V2_HDR_MAX) ? ROLLTS_V2_HDR_MAX : n;
+    record_flash_read(rollts_manager, data_addr, buf, n);
+    if(buf[1] & 0x80)
+    {
+        // 空位
+        return 0;
+    }
+    uint32_t len = 0;
+    uint32_t i   = 2;
+    do
+    {
+        if(i >= n)
+        {
+            return 0;
+        }
+        len |= (uint32_t)(buf[i] & 0x7F) << (7 * (i - 2));
+    } while(buf[i++] & 0x80);
 
-        // 进行当前block封顶
-        rollts_manager->last_valid_data_addr = rollts_manager->rollts_data.pre_addr; // 更新最后有效数据块
-        //空间不足时,对pre block记录最后数据地址 
-        uint32_t last_data_addr = 0x0a; //随机值观察是否被覆写
-        rollts_manager->flash_ops.read_data(rollts_manager->mem_tab.pre_addr + offsetof(block_info_t, last_data_addr),
-                                               &last_data_addr, sizeof(uint32_t));
-        //空间不足时，对pre block记录日志数量   
-        int32_t data_num = 0x06; //随机值观察是否被覆写
-        rollts_manager->flash_ops.read_data(rollts_manager->mem_tab.pre_addr + offsetof(block_info_t, data_num),
-                                               &data_num, sizeof(int32_t));  
-
-        if(0xFFFFFFFF == last_data_addr) //无数据
-        {
-            log_debug("writting last_data_addr... 0x%x",rollts_manager->last_valid_data_addr);
-            rollts_manager->flash_ops.write_data(rollts_manager->mem_tab.pre_addr + offsetof(block_info_t, last_data_addr),
-                                                &rollts_manager->last_valid_data_addr, sizeof(uint32_t));
+    memset(head, 0, sizeof(rollts_data_t));
+    head->magic_valid = (ROLLTS_V2_COMMIT == buf[0]) ? MAGIC_DATA_VALID : (0xFF == buf[0]) ? 0xFFFFFFFF : 0;
+    head->cur_addr    = data_addr;
+    head->next_addr   = data_addr + i + len;
+    head->payload_len = len;
+    head->tag         = buf[1] & 0x1F;
+    head->frag        = (buf[1] >> 5) & 0x03;
+    return i;
+}
+
+/**
+ * @func: 读取当前位置的日志头
+ *        返回 false: 本 block 数据结束
+ */
+static bool record_read_head(rollts_manager_t *rollts_manager, record_pos_t *pos)
+{
+    uint32_t block_end = pos->data_end;
+    while (true)
+    {
+        pos->hdr_len = (uint8_t)record_decode_head(rollts_manager, pos->format, pos->data_addr, block_end, &pos->head);
+        if (0 == pos->hdr_len)
+        {
+            break;
         }
-        else
+        if (MAGIC_DATA_VALID == pos->head.magic_valid)
         {
-            log_alt("last_data_addr is not 0xFFFFFFFF,you need to check it");
+            return true;
         }
-        if(-1 == data_num)  
+        if (!is_uncommitted_head(&pos->head, pos->data_addr, block_end))
         {
-            log_debug("writting data_num... %d",rollts_manager->cur_block_data_num);
-            rollts_manager->flash_ops.write_data(rollts_manager->mem_tab.pre_addr + offsetof(block_info_t, data_num),
-                                                &rollts_manager->cur_block_data_num, sizeof(uint32_t));                                       
-        }  
-        else
+            break;
+        }
+        /* 未提交的日志不可见，跳过其占用的空间 */
+        pos->data_addr = pos->head.next_addr;
+    }
+    return false;
+}
+
+/**
+ * @func: 定位到 block 内第一条日志
+ */
+static bool record_first(rollts_manager_t *rollts_manager, uint32_t block_addr, record_pos_t *pos)
+{
+    record_block_init(rollts_manager, block_addr, pos);
+    pos->data_addr  = pos->data_start;
+    return record_read_head(rollts_manager, pos);
+}
+
+/**
+ * @func: 移动到 block 内下一条日志
+ */
+static bool record_next(rollts_manager_t *rollts_manager, record_pos_t *pos)
+{
+    pos->data_addr = pos->head.next_addr;
+    return record_read_head(rollts_manager, pos);
+}
+
+/**
+ * @func: 定位到 block 内下一条日志起始(跳过上一 block 日志的续片)
+ */
+static bool record_next_start(rollts_manager_t *rollts_manager, record_pos_t *pos)
+{
+    while (record_next(rollts_manager, pos))
+    {
+        if (IS_RECORD_START(pos->head))
         {
-            log_alt("data_num is not -1,you need to check it");
+            return true;
         }
-        // test
-        // { 
-        //     block_info_t pre_block_info;
-        //     memset(&pre_block_info , 0xFF, sizeof(block_info_t));
-        //     rollts_manager->flash_ops.read_data(rollts_manager->mem_tab.pre_addr,  &pre_block_info, sizeof(block_info_t));
-        //     log_debug("writting pre_block_info:last_data_addr :0x%x",pre_block_info.last_data_addr);
-        //     log_debug("writting pre_block_info:data_num       :0x%x",pre_block_info.data_num);
-        // }
-        return false;
     }
+    return false;
 }
-/* function-------------------------------------------------------------------*/
+
 /**
- * @func: 添加数据
+ * @func: 定位到 block 内第一条日志起始
  */
-bool rollts_add(rollts_manager_t *rollts_manager, uint8_t *data, uint32_t payload_len)
+static bool record_first_start(rollts_manager_t *rollts_manager, uint32_t block_addr, record_pos_t *pos)
 {
-    if(MAGIC_VALID != rollts_manager->is_init)
+    if (!record_first(rollts_manager, block_addr, pos))
     {
         return false;
     }
-#ifdef RTOS_MUTEX_ENABLE
-    rollts_manager->flash_ops.mutex_lock();
-#endif
-    // 数据帧总长计算
-    uint32_t data_frame_len = sizeof(rollts_data_t) + payload_len;
-    // 检查数据长度是否超过单个块数据上限大小 冗余4字节
-    if(data_frame_len >= rollts_manager->sys_info.single_block_size - sizeof(block_info_t) - 4)
+    return IS_RECORD_START(pos->head) || record_next_start(rollts_manager, pos);
+}
+
+/**
+ * @func: 定位到 block 内第 index 条日志起始(从 0 开始)
+ *        有块尾偏移表时读取偏移直接定位，否则沿链表跳过
+ */
+static bool record_seek_start(rollts_manager_t *rollts_manager, uint32_t block_addr, uint32_t index, record_pos_t *pos)
+{
+    uint32_t footer_num = record_block_init(rollts_manager, block_addr, pos);
+    if (ROLLTS_FMT_FIXED == pos->format)
     {
-        log_alt(" rollts_add: (data_frame_len :%d, you need to split data less than %d",
-                    data_frame_len,rollts_manager->sys_info.single_block_size - sizeof(block_info_t) - 4);
-#ifdef RTOS_MUTEX_ENABLE
-        rollts_manager->flash_ops.mutex_unlock();
-#endif
-        return false;
+        /* 定长 block 内无空洞，第 index 条地址直接计算 */
+        uint64_t data_addr = (uint64_t)pos->data_start + (uint64_t)index * sys_fixed_slot(rollts_manager);
+        if (data_addr >= pos->data_end)
+        {
+            return false;
+        }
+        pos->data_addr = (uint32_t)data_addr;
+        return record_read_head(rollts_manager, pos) && pos->data_addr == (uint32_t)data_addr;
     }
-    // 查找当前最后日志位置
-    if(false == find_the_last_position_and_calc(rollts_manager,data_frame_len,payload_len))
+    if (index < footer_num)
     {
-        // 空间不足，切换日志块
-        head_block_move(rollts_manager);
-        // 切换完成 rollts_data已置为首个位置
+        uint16_t offset = 0;
+        ROLLTS_FLASH_READ(rollts_manager, pos->data_end + index * ROLLTS_FOOTER_ENTRY_SIZE, &offset, sizeof(uint16_t));
+        pos->data_addr = block_addr + offset;
+        return record_read_head(rollts_manager, pos) && pos->data_addr == block_addr + offset && IS_RECORD_START(pos->head);
+    }
+    bool valid = record_first_start(rollts_manager, block_addr, pos);
+    while (valid && index-- > 0)
+    {
+        valid = record_next_start(rollts_manager, pos);
+    }
+    return valid;
+}
 
-        rollts_manager->last_valid_data_addr = rollts_manager->rollts_data.cur_addr; // 更新最后有效数据块
-        rollts_manager->cur_block_data_num = 0;
-        if(false == find_the_last_position_and_calc(rollts_manager,data_frame_len,payload_len))
+/**
+ * @func: 定位到分片日志的下一个续片(位于下一个 block 的第一条)
+ *        返回 false: 分片不完整(被回收或写入中断)
+ */
+static bool record_next_frag(rollts_manager_t *rollts_manager, record_pos_t *frag)
+{
+    uint32_t next_block = get_next_block(rollts_manager, frag->block_addr);
+    return next_block != rollts_manager->mem_tab.head_addr
+        && record_first(rollts_manager, next_block, frag)
+        && !IS_RECORD_START(frag->head);
+}
+
+/**
+ * @func: 读取日志负载 [offset, offset + max_len)(分片日志沿后续 block 拼接)
+ *        copy_len 返回实际拷贝长度
+ *        返回 false: 分片不完整(被回收或写入中断)
+ */
+static bool record_read_range(rollts_manager_t *rollts_manager, const record_pos_t *pos, uint32_t offset,
+                              uint8_t *data, uint32_t max_len, uint32_t *copy_len)
+{
+    record_pos_t frag = *pos;
+    uint32_t copied   = 0;
+    while (true)
+    {
+        /* 跳过 offset 之前的分片/字节 */
+        uint32_t skip = (offset < frag.head.payload_len) ? offset : frag.head.payload_len;
+        uint32_t len  = frag.head.payload_len - skip;
+        offset -= skip;
+        if (len > max_len - copied)
+        {
+            len = max_len - copied;
+        }
+        if (len > 0)
+        {
+            record_flash_read(rollts_manager, frag.data_addr + frag.hdr_len + skip, data + copied, len);
+            copied += len;
+        }
+        if (ROLLTS_FRAG_NONE == frag.head.frag || ROLLTS_FRAG_LAST == frag.head.frag)
+        {
+            *copy_len = copied;
+            return true;
+        }
+        if (!record_next_frag(rollts_manager, &frag))
+        {
+            return false;
+        }
+    }
+}
+
+/**
+ * @func: 读取日志负载(分片日志沿后续 block 拼接)
+ *        最多拷贝 max_len 字节，copy_len 返回实际拷贝长度
+ *        返回 false: 分片不完整(被回收或写入中断)
+ */
+static bool record_read_payload(rollts_manager_t *rollts_manager, const record_pos_t *pos,
+                                uint8_t *data, uint32_t max_len, uint32_t *copy_len)
+{
+    return record_read_range(rollts_manager, pos, 0, data, max_len, copy_len);
+}
+
+/**
+ * @func: 计算日志负载总长(只读取日志头)
+ *        返回 false: 分片不完整
+ */
+static bool record_total_len(rollts_manager_t *rollts_manager, const record_pos_t *pos, uint32_t *total_len)
+{
+    record_pos_t frag = *pos;
+    uint32_t total    = frag.head.payload_len;
+    while (ROLLTS_FRAG_NONE != frag.head.frag && ROLLTS_FRAG_LAST != frag.head.frag)
+    {
+        if (!record_next_frag(rollts_manager, &frag))
+        {
+            return false;
+        }
+        total += frag.head.payload_len;
+    }
+    *total_len = total;
+    return true;
+}
+
+/**
+ * @func: 判断 block 是否处于有效数据区(最旧 block ~ pre)
+ */
+static bool is_live_block(rollts_manager_t *rollts_manager, uint32_t block_addr)
+{
+    return block_addr >= rollts_manager->sys_info.data_start_addr
+        && block_addr <= rollts_manager->sys_info.data_end_addr
+        && 0 == (block_addr - rollts_manager->sys_info.data_start_addr) % rollts_manager->sys_info.single_block_size
+        && block_addr != rollts_manager->mem_tab.head_addr
+        && block_addr != rollts_manager->mem_tab.head_backup_addr
+        && block_distance(rollts_manager, get_oldest_block(rollts_manager), block_addr)
+           <= block_distance(rollts_manager, get_oldest_block(rollts_manager), rollts_manager->mem_tab.pre_addr);
+}
+
+/**
+ * @func: 格式化head block
+ */
+static bool head_block_format(rollts_manager_t *rollts_manager)
+{
+    log_debug("head_block_format start...");
+    uint32_t pre_addr  = 0;
+    uint32_t next_addr = 0;
+    if(rollts_manager->mem_tab.head_addr == rollts_manager->sys_info.data_start_addr) //head在起始块
+    {
+        pre_addr  = rollts_manager->sys_info.data_end_addr;
+        next_addr = rollts_manager->sys_info.data_start_addr + rollts_manager->sys_info.single_block_size;
+    }
+    else if(rollts_manager->mem_tab.head_addr == rollts_manager->sys_info.data_end_addr) //head在结束块
+    {
+        pre_addr  = rollts_manager->sys_info.data_end_addr - rollts_manager->sys_info.single_block_size;
+        next_addr = rollts_manager->sys_info.data_start_addr;
+    }
+    else
+    {
+        pre_addr  = rollts_manager->mem_tab.head_addr - rollts_manager->sys_info.single_block_size;
+        next_addr = rollts_manager->mem_tab.head_addr + rollts_manager->sys_info.single_block_size;
+    }
+    block_info_t pre_block_info;
+    block_info_t next_block_info;
+    memset(&pre_block_info , 0xFF, sizeof(block_info_t));
+    memset(&next_block_info, 0xFF, sizeof(block_info_t));
+
+    block_info_read(rollts_manager, pre_addr,  &pre_block_info);
+    block_info_read(rollts_manager, next_addr, &next_block_info);
+    // 只读挂载时不修复
+    if((!IS_NOT_HEAD(pre_block_info) || pre_block_info.generation != ROLLTS_BLOCK_GENERATION(rollts_manager->sys_info))
+       && !rollts_manager->read_only)
+    {
+        memset(&pre_block_info , 0xFF, sizeof(block_info_t));
+        pre_block_info.magic_valid = MAGIC_VALID;
+        pre_block_info.data_num    = -1;
+        pre_block_info.generation  = ROLLTS_BLOCK_GENERATION(rollts_manager->sys_info);
+        SET_BLOCK_FORMAT(pre_block_info, sys_record_format(rollts_manager));
+        if(0 != ROLLTS_FLASH_ERASE(rollts_manager, pre_addr))
+        {
+            return false;
+        }
+        if(0 != ROLLTS_FLASH_WRITE(rollts_manager, pre_addr, &pre_block_info, sizeof(block_info_t)))
+        {
+            return false;
+        }
+    }
+    if((!IS_BACKUP(next_block_info) || next_block_info.generation != ROLLTS_BLOCK_GENERATION(rollts_manager->sys_info))
+       && !rollts_manager->read_only)
+    {
+        memset(&next_block_info , 0xFF, sizeof(block_info_t));
+        next_block_info.magic_valid = MAGIC_VALID;
+        next_block_info.data_num    = -1;
+        next_block_info.generation  = ROLLTS_BLOCK_GENERATION(rollts_manager->sys_info);
+        SET_BACKUP(next_block_info);
+        if(ROLLTS_FLASH_ERASE(rollts_manager, next_addr))
+        {
+            return false;
+        }
+        if(ROLLTS_FLASH_WRITE(rollts_manager, next_addr, &next_block_info, sizeof(block_info_t)))
+        {
+            return false;
+        }
+    }
+    rollts_manager->mem_tab.head_backup_addr = next_addr;
+    rollts_manager->mem_tab.pre_addr         = pre_addr;
+    return true;
+}
+
+/**
+ * @func: 扫描起始数据块
+ */
+static int scan_head_block(rollts_manager_t *rollts_manager)
+{
+    int num = 0;
+    bool find_in_first                 = false;
+    bool find_in_last                  = false;
+    uint32_t find_head_block_addr     = 0;
+
+    block_info_t block_info;
+    uint32_t rollts_max_data_block_num = ROLLTS_DATA_BLOCK_NUM(rollts_manager);
+    for (uint32_t i = 0; i < rollts_max_data_block_num; i++) 
+    { 
+        block_info.magic_valid = 0;
+        block_info_read(rollts_manager, rollts_manager->sys_info.data_start_addr  + \
+                                          rollts_manager->sys_info.single_block_size * i, &block_info);
+        log_debug("----------------------------------------");                                
+        log_debug("block_info.last_data_addr     : 0x%x", block_info.last_data_addr);
+        log_debug("block_info.data_num           : %d", block_info.data_num);
+        log_debug("block_info.magic_valid        : 0x%x", block_info.magic_valid);    
+        log_debug("block_info.is_head            : %d", block_info.is_head);
+        log_debug("----------------------------------------");     
+        if(MAGIC_VALID == block_info.magic_valid && block_info.generation == ROLLTS_BLOCK_GENERATION(rollts_manager->sys_info))
+        {
+            // 查询是否是启动块
+            if(IS_HEAD(block_info))
+            {
+                num++;
+                rollts_manager->mem_tab.head_addr =rollts_manager->sys_info.data_start_addr  + \
+                                                   rollts_manager->sys_info.single_block_size * i;
+                if(i == 0)
+                {
+                    find_in_first = true;
+                    find_head_block_addr = rollts_manager->mem_tab.head_addr;
+                }                             
+                if(i == rollts_max_data_block_num)
+                {
+                    find_in_last = true;
+                }
+            }
+        }
+        else
+        {
+            continue;
+        }
+    }
+    // 启动块出现在一头一尾
+    if(find_in_last && find_in_first)
+    {
+        rollts_manager->mem_tab.head_addr = find_head_block_addr;
+    }
+    return num;
+
+}
+
+/**
+ * @func: 初始化内存表
+ */
+static int rollts_mem_tab_init(rollts_manager_t *rollts_manager)
+{
+    log_debug(" rollts_mem_tab_init start...");
+    // 扫描 head块
+    if(scan_head_block(rollts_manager) > 0)
+    {
+        log_debug("scan_head_block_addr : 0x%x",rollts_manager->mem_tab.head_addr);
+        if(head_block_format(rollts_manager))
+        {
+            log_debug("rollts_manager->mem_tab.pre_addr        : 0x%x",rollts_manager->mem_tab.pre_addr);
+            log_debug("rollts_manager->mem_tab.head_addr       : 0x%x",rollts_manager->mem_tab.head_addr);
+            log_debug("rollts_manager->mem_tab.head_backup_addr: 0x%x",rollts_manager->mem_tab.head_backup_addr);
+        }
+        else
+        {
+            log_error(" head_block_format failed!");
+            return -1;
+        }
+        stale_block_scan(rollts_manager);
+        return 0;
+    }
+    else
+    {
+        log_alt(" scan_head_block_addr not found!");
+        if(!rollts_manager->read_only && 0 == head_block_force_format(rollts_manager))
+        {
+            stale_block_scan(rollts_manager);
+            return 0;
+        }
+        rollts_manager->is_init = 0;
+        return -1;
+    }
+}
+
+/**
+ * @func: 遍历链表统计 block 内日志条数
+ */
+static int32_t block_record_walk(rollts_manager_t *rollts_manager, uint32_t block_addr)
+{
+    record_pos_t pos;
+    bool valid = record_first_start(rollts_manager, block_addr, &pos);
+    int32_t num = 0;
+    while (valid)
+    {
+        num++;
+        valid = record_next_start(rollts_manager, &pos);
+    }
+    return num;
+}
+
+/**
+ * @func: 获取block内日志条数
+ *        未封顶的 block 或 data_num 不可靠的旧布局 block 遍历链表计数
+ */
+static int32_t block_record_count(rollts_manager_t *rollts_manager, uint32_t block_addr)
+{
+    if (block_addr == rollts_manager->mem_tab.pre_addr)
+    {
+        return rollts_manager->cur_block_data_num;
+    }
+    int32_t num = -1;
+    block_info_t block_info;
+    const rollts_layout_t *layout = (0 == rollts_manager->legacy_layout) ? NULL
+                                  : block_info_read(rollts_manager, block_addr, &block_info);
+    if (NULL == layout || !layout->count_walk)
+    {
+        ROLLTS_FLASH_READ(rollts_manager, block_addr + offsetof(block_info_t, data_num), &num, sizeof(num));
+    }
+    return (num >= 0) ? num : block_record_walk(rollts_manager, block_addr);
+}
+
+/**
+ * @func: 没有 first_seq 的旧布局 block 第一条日志序号
+ *        此类 block 位于最旧一侧，按最旧 block 序号累加之前各 block 的日志条数
+ */
+static uint64_t legacy_first_seq(rollts_manager_t *rollts_manager, uint32_t block_addr)
+{
+    uint64_t seq = rollts_manager->legacy_seq;
+    for (uint32_t addr = get_oldest_block(rollts_manager);
+         addr != block_addr && addr != rollts_manager->mem_tab.pre_addr; addr = get_next_block(rollts_manager, addr))
+    {
+        seq += (uint64_t)block_record_count(rollts_manager, addr);
+    }
+    return seq;
+}
+
+/**
+ * @func: 获取 block 第一条日志序号
+ */
+static uint64_t block_first_seq(rollts_manager_t *rollts_manager, uint32_t block_addr)
+{
+    if (block_addr == rollts_manager->mem_tab.pre_addr)
+    {
+        return rollts_manager->cur_block_first_seq;
+    }
+    uint64_t seq = ROLLTS_SEQ_NONE;
+    if (0 == rollts_manager->legacy_layout)
+    {
+        record_flash_read(rollts_manager, block_addr + offsetof(block_info_t, first_seq), &seq, sizeof(uint64_t));
+        return seq;
+    }
+    block_info_t block_info;
+    const rollts_layout_t *layout = block_info_read(rollts_manager, block_addr, &block_info);
+    return (NULL == layout || 0 != layout->first_seq) ? block_info.first_seq : legacy_first_seq(rollts_manager, block_addr);
+}
+
+/**
+ * @func: 挂载时计算最旧 block 第一条日志序号(最旧一侧为没有 first_seq 的旧布局 block 时)
+ *        以之后第一个当前布局 block 的 first_seq 为基准减去其之前各 block 的日志条数，没有基准时从 0 开始
+ */
+static void legacy_seq_init(rollts_manager_t *rollts_manager)
+{
+    uint64_t count = 0;
+    uint32_t addr  = get_oldest_block(rollts_manager);
+    rollts_manager->legacy_seq = 0;
+    while (0 != rollts_manager->legacy_layout)
+    {
+        block_info_t block_info;
+        const rollts_layout_t *layout = block_info_read(rollts_manager, addr, &block_info);
+        if (MAGIC_VALID == block_info.magic_valid && (NULL == layout || 0 != layout->first_seq))
+        {
+            if (ROLLTS_SEQ_NONE != block_info.first_seq && block_info.first_seq >= count)
+            {
+                rollts_manager->legacy_seq = block_info.first_seq - count;
+            }
+            break;
+        }
+        if (addr == rollts_manager->mem_tab.pre_addr)
+        {
+            break;
+        }
+        count += (uint64_t)block_record_count(rollts_manager, addr);
+        addr   = get_next_block(rollts_manager, addr);
+    }
+}
+
+/**
+ * @func: 最旧 block 回收前更新旧布局 block 序号基准
+ */
+static void legacy_seq_reclaim(rollts_manager_t *rollts_manager, uint32_t block_addr)
+{
+    block_info_t block_info;
+    const rollts_layout_t *layout = (0 == rollts_manager->legacy_layout) ? NULL
+                                  : block_info_read(rollts_manager, block_addr, &block_info);
+    if (NULL != layout && 0 == layout->first_seq)
+    {
+        rollts_manager->legacy_seq += (uint64_t)block_record_count(rollts_manager, block_addr);
+    }
+}
+
+/**
+ * @func: 计算 block 之后下一个 block 的第一条日志序号
+ */
+static uint64_t block_next_seq(rollts_manager_t *rollts_manager, uint32_t block_addr)
+{
+    uint64_t seq = block_first_seq(rollts_manager, block_addr);
+    if (ROLLTS_SEQ_NONE == seq)
+    {
+        return 0;
+    }
+    return seq + (uint64_t)block_record_count(rollts_manager, block_addr);
+}
+
+/**
+ * @func: 最新日志缓存 第 i 条(从最旧开始)
+ */
+static rollts_tail_entry_t *tail_entry(rollts_tail_t *tail, uint32_t i)
+{
+    return &tail->entry[(tail->first + i) % tail->entry_num];
+}
+
+/**
+ * @func: 淘汰最旧的缓存日志
+ */
+static void tail_evict(rollts_tail_t *tail)
+{
+    tail->used -= tail_entry(tail, 0)->len;
+    tail->first = (tail->first + 1) % tail->entry_num;
+    tail->count--;
+}
+
+/**
+ * @func: 挂载时检查最新日志缓存配置
+ *        条目数组或负载缓冲为空时不启用缓存，之后各接口按未配置处理
+ */
+static void tail_attach(rollts_manager_t *rollts_manager)
+{
+    rollts_tail_t *tail = rollts_manager->tail;
+    if (NULL != tail
+        && (NULL == tail->entry || 0 == tail->entry_num || NULL == tail->buf || 0 == tail->buf_size))
+    {
+        log_alt(" tail: invalid entry/buf config, cache disabled");
+        rollts_manager->tail = NULL;
+    }
+}
+
+/**
+ * @func: 清空最新日志缓存(挂载/清除后)
+ */
+static void tail_reset(rollts_manager_t *rollts_manager)
+{
+    rollts_tail_t *tail = rollts_manager->tail;
+    if (NULL == tail)
+    {
+        return;
+    }
+    tail->first      = 0;
+    tail->count      = 0;
+    tail->head       = 0;
+    tail->used       = 0;
+    tail->overflow   = false;
+    tail->oldest_seq = block_first_seq(rollts_manager, get_oldest_block(rollts_manager));
+}
+
+/**
+ * @func: 回滚后淘汰已被回收的缓存日志
+ */
+static void tail_rollover(rollts_manager_t *rollts_manager)
+{
+    rollts_tail_t *tail = rollts_manager->tail;
+    if (NULL == tail)
+    {
+        return;
+    }
+    tail->oldest_seq = block_first_seq(rollts_manager, get_oldest_block(rollts_manager));
+    while (tail->count > 0 && tail_entry(tail, 0)->seq < tail->oldest_seq)
+    {
+        tail_evict(tail);
+    }
+}
+
+/**
+ * @func: 开始缓存一条日志 淘汰旧日志腾出负载空间
+ */
+static void tail_begin(rollts_manager_t *rollts_manager, uint32_t payload_len)
+{
+    rollts_tail_t *tail = rollts_manager->tail;
+    if (NULL == tail)
+    {
+        return;
+    }
+    tail->overflow = (payload_len > tail->buf_size);
+    tail->pending  = tail->head;
+    while (tail->count > 0 && tail->used + payload_len > tail->buf_size)
+    {
+        tail_evict(tail);
+    }
+}
+
+/**
+ * @func: 缓存日志负载
+ */
+static void tail_write(rollts_manager_t *rollts_manager, const uint8_t *data, uint32_t len)
+{
+    rollts_tail_t *tail = rollts_manager->tail;
+    if (NULL == tail || tail->overflow || 0 == len)
+    {
+        return;
+    }
+    uint32_t first_len = tail->buf_size - tail->head;
+    if (first_len > len)
+    {
+        first_len = len;
+    }
+    memcpy(tail->buf + tail->head, data, first_len);
+    memcpy(tail->buf, data + first_len, len - first_len);
+    tail->head = (tail->head + len) % tail->buf_size;
+}
+
+/**
+ * @func: 日志提交后加入缓存
+ *        超过 buf_size 的日志不缓存并清空窗口，保证缓存序号连续
+ */
+static void tail_commit(rollts_manager_t *rollts_manager, uint8_t tag, uint32_t payload_len)
+{
+    rollts_tail_t *tail = rollts_manager->tail;
+    if (NULL == tail)
+    {
+        return;
+    }
+    if (tail->overflow)
+    {
+        tail_reset(rollts_manager);
+        return;
+    }
+    if (tail->count == tail->entry_num)
+    {
+        tail_evict(tail);
+    }
+    rollts_tail_entry_t *entry = tail_entry(tail, tail->count);
+    entry->seq    = rollts_manager->cur_block_first_seq + (uint64_t)rollts_manager->cur_block_data_num - 1;
+    entry->offset = tail->pending;
+    entry->len    = payload_len;
+    entry->tag    = tag;
+    tail->count++;
+    tail->used   += payload_len;
+}
+
+/**
+ * @func: 放弃写入中日志的缓存
+ */
+static void tail_cancel(rollts_manager_t *rollts_manager)
+{
+    rollts_tail_t *tail = rollts_manager->tail;
+    if (NULL == tail)
+    {
+        return;
+    }
+    tail->head     = tail->pending;
+    tail->overflow = false;
+}
+
+/**
+ * @func: 判断从 seq 开始的读取是否完全落在缓存窗口内，并统计命中
+ */
+static bool tail_hit(rollts_manager_t *rollts_manager, uint64_t seq)
+{
+    rollts_tail_t *tail = rollts_manager->tail;
+    if (NULL == tail)
+    {
+        return false;
+    }
+    if (tail->count > 0 && seq >= tail_entry(tail, 0)->seq)
+    {
+        tail->hit++;
+        return true;
+    }
+    tail->miss++;
+    return false;
+}
+
+/**
+ * @func: 从缓存读取日志负载 返回拷贝长度
+ */
+static uint32_t tail_read(rollts_tail_t *tail, const rollts_tail_entry_t *entry, uint8_t *data, uint32_t max_len)
+{
+    uint32_t len       = (entry->len < max_len) ? entry->len : max_len;
+    uint32_t first_len = tail->buf_size - entry->offset;
+    if (first_len > len)
+    {
+        first_len = len;
+    }
+    memcpy(data, tail->buf + entry->offset, first_len);
+    memcpy(data + first_len, tail->buf, len - first_len);
+    return len;
+}
+
+/**
+ * @func: 写入块尾偏移表
+ *        按日志起始顺序写入块内偏移，最后清除 block_status 偏移表标记
+ *        日志区与偏移表重叠(旧版本写入未预留空间)或旧布局 block 时不写入
+ */
+static void block_footer_write(rollts_manager_t *rollts_manager, uint32_t block_addr,
+                               uint32_t data_end, int32_t data_num)
+{
+#if ROLLTS_FOOTER_ENABLE
+    block_info_t block_info;
+    // 定长 block 按序号直接计算地址，不需要偏移表
+    if (NULL != block_info_read(rollts_manager, block_addr, &block_info)
+        || HAS_BLOCK_FOOTER(block_info) || data_num <= 0 || ROLLTS_FMT_FIXED == block_record_format(&block_info))
+    {
+        return;
+    }
+    uint32_t footer_addr = block_addr + rollts_manager->sys_info.single_block_size - ROLLTS_FOOTER_SIZE(data_num);
+    if (data_end > footer_addr)
+    {
+        log_debug("block 0x%x: no space for footer", block_addr);
+        return;
+    }
+    record_pos_t pos;
+    uint16_t batch[16];
+    uint32_t batch_num = 0;
+    uint32_t num       = 0;
+    bool valid = record_first_start(rollts_manager, block_addr, &pos);
+    // 偏移表标记写入前读取范围为整个 block，限制到偏移表之前，避免把已写入的偏移当作日志
+    pos.data_end = footer_addr;
+    while (valid && num < (uint32_t)data_num)
+    {
+        batch[batch_num++] = (uint16_t)(pos.data_addr - block_addr);
+        num++;
+        if (batch_num == sizeof(batch) / sizeof(batch[0]) || num == (uint32_t)data_num)
+        {
+            ROLLTS_FLASH_WRITE(rollts_manager, footer_addr + (num - batch_num) * ROLLTS_FOOTER_ENTRY_SIZE,
+                                                batch, batch_num * ROLLTS_FOOTER_ENTRY_SIZE);
+            batch_num = 0;
+        }
+        valid = record_next_start(rollts_manager, &pos);
+    }
+    if (num != (uint32_t)data_num || valid)
+    {
+        log_alt("block 0x%x: footer count mismatch", block_addr);
+        return;
+    }
+    SET_BLOCK_FOOTER(block_info);
+    ROLLTS_FLASH_WRITE(rollts_manager, block_addr + offsetof(block_info_t, status), &block_info.status, sizeof(uint8_t));
+#else
+    (void)rollts_manager;
+    (void)block_addr;
+    (void)data_end;
+    (void)data_num;
+#endif
+}
+
+/**
+ * @func: 补写待处理 block 的偏移表(延迟封顶)
+ *        block 已被回收或未封顶时跳过
+ */
+static void block_footer_flush(rollts_manager_t *rollts_manager)
+{
+    uint32_t block_addr = rollts_manager->maintain.footer_addr;
+    rollts_manager->maintain.footer_addr = 0;
+    if (0 == block_addr || !is_live_block(rollts_manager, block_addr))
+    {
+        return;
+    }
+    block_info_t  block_info;
+    rollts_data_t last;
+    block_info_read(rollts_manager, block_addr, &block_info);
+    if (block_info.data_num <= 0 || 0xFFFFFFFF == block_info.last_data_addr
+        || 0 == record_decode_head(rollts_manager, block_record_format(&block_info), block_info.last_data_addr,
+                                   block_addr + rollts_manager->sys_info.single_block_size, &last))
+    {
+        return;
+    }
+    block_footer_write(rollts_manager, block_addr, last.next_addr, block_info.data_num);
+}
+
+/**
+ * @func: 判断 Flash 区间是否为擦除值
+ */
+static bool is_erased_range(rollts_manager_t *rollts_manager, uint32_t addr, uint32_t len)
+{
+    uint8_t buf[32];
+    while(len > 0)
+    {
+        uint32_t n = (len < sizeof(buf)) ? len : sizeof(buf);
+        ROLLTS_FLASH_READ(rollts_manager, addr, buf, n);
+        for(uint32_t i = 0; i < n; i++)
+        {
+            if(0xFF != buf[i])
+            {
+                return false;
+            }
+        }
+        addr += n;
+        len  -= n;
+    }
+    return true;
+}
+
+/**
+ * @func: 初始化数据块结构体
+ * 
+ */
+static void data_block_loop(rollts_manager_t *rollts_manager)
+{
+    memset(&rollts_manager->rollts_data,0x00,sizeof(rollts_data_t));
+    // 挂载/清除后空闲维护重新开始
+    memset(&rollts_manager->maintain, 0, sizeof(rollts_maintain_t));
+    tail_reset(rollts_manager);
+
+    bool is_block_info_valid = true;
+    // 首先查询block_info是否已经写入了end_addr 和 data_num
+    block_info_t current_block_info;
+    const rollts_layout_t *layout = block_info_read(rollts_manager, rollts_manager->mem_tab.pre_addr, &current_block_info);
+    uint32_t start_addr  = rollts_manager->mem_tab.pre_addr + ((NULL != layout) ? layout->hdr_size : sizeof(block_info_t));
+    uint32_t end_addr    = rollts_manager->mem_tab.pre_addr + rollts_manager->sys_info.single_block_size - 1;
+    // 当前块日志格式(v1 分区升级后，当前块写满前仍按 v1 写入)
+    rollts_manager->cur_block_format = block_record_format(&current_block_info);
+    // 当前块第一条日志序号，迁移中断修复的 block 未写入时按上一 block 补写，旧布局 block 按日志条数推算
+    rollts_manager->cur_block_first_seq = current_block_info.first_seq;
+    if(NULL != layout && 0 == layout->first_seq)
+    {
+        rollts_manager->cur_block_first_seq = legacy_first_seq(rollts_manager, rollts_manager->mem_tab.pre_addr);
+    }
+    else if(ROLLTS_SEQ_NONE == current_block_info.first_seq)
+    {
+        rollts_manager->cur_block_first_seq = block_next_seq(rollts_manager, get_pre_block(rollts_manager, rollts_manager->mem_tab.pre_addr));
+        if(!rollts_manager->read_only && NULL == layout)
+        {
+            ROLLTS_FLASH_WRITE(rollts_manager, rollts_manager->mem_tab.pre_addr + offsetof(block_info_t, first_seq),
+                                                &rollts_manager->cur_block_first_seq, sizeof(uint64_t));
+        }
+    }
+    if((0xFFFFFFFF != current_block_info.last_data_addr)
+     &&(-1         != current_block_info.data_num))
+    {
+        rollts_manager->current_block_full = true;
+        // 当前数据块已经写入了数据
+        if((0xFFFFFFFF == current_block_info.last_data_addr)
+                ||(-1  == current_block_info.data_num))
+        {
+            // 完整性检查不通过，需要进行日志修复
+            log_alt("rollts_data_block_loop: block_info integrity check failed");
+            log_alt("repair...");
+            is_block_info_valid = false;
+        }
+        else
+        {
+            // 完整性检查通过，进行数据块数据初始化
+            record_decode_head(rollts_manager, rollts_manager->cur_block_format, current_block_info.last_data_addr,
+                               end_addr + 1, &rollts_manager->rollts_data);
+            rollts_manager->cur_block_data_num = (NULL != layout && layout->count_walk)
+                                               ? block_record_walk(rollts_manager, rollts_manager->mem_tab.pre_addr)
+                                               : current_block_info.data_num;
+            rollts_manager->cur_block_tag_bitmap = current_block_info.tag_bitmap;
+            rollts_manager->cur_block_agg_valid  = false;
+            // 封顶时偏移表写入中断，补写(延迟封顶时交给 rollts_maintain)
+            if(rollts_manager->maintain_defer)
+            {
+                rollts_manager->maintain.footer_addr = rollts_manager->mem_tab.pre_addr;
+            }
+            else if(!rollts_manager->read_only)
+            {
+                block_footer_write(rollts_manager, rollts_manager->mem_tab.pre_addr,
+                                   rollts_manager->rollts_data.next_addr, current_block_info.data_num);
+            }
+            return;
+        }
+    }
+    else
+    {
+        rollts_manager->current_block_full = false;
+    }
+    rollts_data_t tmp_rollts_data;
+    memset(&tmp_rollts_data,0x00,sizeof(rollts_data_t));
+    // 遍历数据块
+    rollts_manager->cur_block_data_num   = 0;
+    rollts_manager->cur_block_tag_bitmap = 0;
+    // 从头开始写数据
+    rollts_manager->rollts_data.magic_valid = MAGIC_DATA_VALID;
+    rollts_manager->rollts_data.pre_addr    = 0;
+    rollts_manager->rollts_data.cur_addr    = start_addr;
+
+    if(ROLLTS_FMT_FIXED == rollts_manager->cur_block_format)
+    {
+        // 定长 block 内已提交的日志连续排列，二分查找第一个空位
+        uint32_t slot = sys_fixed_slot(rollts_manager);
+        uint32_t lo   = 0;
+        uint32_t hi   = (end_addr + 1 - start_addr) / slot;
+        uint32_t slot_num = hi;
+        while(lo < hi)
+        {
+            uint32_t mid    = lo + (hi - lo) / 2;
+            uint8_t  marker = 0xFF;
+            ROLLTS_FLASH_READ(rollts_manager, start_addr + mid * slot, &marker, sizeof(uint8_t));
+            if(0xFF != marker)
+            {
+                lo = mid + 1;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+        rollts_manager->cur_block_data_num   = (int32_t)lo;
+        // 标签位图未逐条读取，按包含所有标签处理
+        rollts_manager->cur_block_tag_bitmap = (0 == lo) ? 0 : ROLLTS_TAG_ALL;
+        if(lo > 0)
+        {
+            rollts_manager->rollts_data.pre_addr = start_addr + (lo - 1) * slot;
+        }
+        start_addr += lo * slot;
+        rollts_manager->rollts_data.cur_addr = start_addr;
+        // 空位已被部分写入(提交前掉电)：不复用该空位，封顶当前 block
+        if(lo < slot_num && !is_erased_range(rollts_manager, start_addr, slot))
+        {
+            log_alt("rollts_data_block_loop: torn fixed record at 0x%x, seal block", start_addr);
+            rollts_manager->current_block_full = true;
+            is_block_info_valid = false;
+        }
+    }
+    //写入时保证有效数据的next不超限制
+    while(ROLLTS_FMT_FIXED != rollts_manager->cur_block_format
+          && 0 != record_decode_head(rollts_manager, rollts_manager->cur_block_format, start_addr, end_addr + 1, &tmp_rollts_data))
+    {
+        if(MAGIC_DATA_VALID == tmp_rollts_data.magic_valid)
+        {
+            // 当前block数据条数增加(只统计日志起始，上一 block 日志的续片不计数)
+            if(IS_RECORD_START(tmp_rollts_data))
+            {
+                rollts_manager->cur_block_data_num++;
+                rollts_manager->cur_block_tag_bitmap |= ROLLTS_TAG_MASK(tmp_rollts_data.tag % ROLLTS_TAG_NUM);
+            }
+        }
+        else if(!is_uncommitted_head(&tmp_rollts_data, start_addr, end_addr + 1))
+        {
+            // 当前数据头为空
+            log_debug(" tmp_rollts_data find empty");
+            break;
+        }
+        // 保证rollts_data 始终为当前可写空位(未提交的日志同样占用空间)
+        rollts_manager->rollts_data.pre_addr    = tmp_rollts_data.cur_addr;
+        rollts_manager->rollts_data.cur_addr    = tmp_rollts_data.next_addr;
+        start_addr  = tmp_rollts_data.next_addr;
+    }
+
+    // 重启后当前块已有数据时不回读负载重建聚合值，封顶时不写入，查询时扫描该块
+    agg_reset(&rollts_manager->cur_block_agg);
+    rollts_manager->cur_block_agg_valid = (0 == rollts_manager->cur_block_data_num);
+
+    if(false  == is_block_info_valid && !rollts_manager->read_only)
+    {
+        // 修复blcok info
+        // 完整性检查失败，进行数据块数据初始化
+        current_block_info.last_data_addr = start_addr;
+        current_block_info.data_num       = rollts_manager->cur_block_data_num;
+        current_block_info.tag_bitmap     = block_tag_bitmap(rollts_manager->cur_block_tag_bitmap);
+
+        // 旧布局 block 只写入位置相同的最后数据地址与数据条数
+        if(NULL == layout)
+        {
+            ROLLTS_FLASH_WRITE(rollts_manager, rollts_manager->mem_tab.pre_addr + offsetof(block_info_t, tag_bitmap),
+                                                &current_block_info.tag_bitmap, sizeof(uint32_t));
+        }
+
+        log_debug("writting last_data_addr... 0x%x",current_block_info.last_data_addr);
+        ROLLTS_FLASH_WRITE(rollts_manager, rollts_manager->mem_tab.pre_addr + offsetof(block_info_t, last_data_addr),
+                                            &current_block_info.last_data_addr, sizeof(uint32_t));
+        
+        log_debug("writting data_num... %d",current_block_info.data_num);
+        ROLLTS_FLASH_WRITE(rollts_manager, rollts_manager->mem_tab.pre_addr + offsetof(block_info_t, data_num),
+                                            &current_block_info.data_num, sizeof(uint32_t));                                       
+
+    }
+}
+
+/**
+ * @func: 扫描block内编号 [first, last] (块内从1开始) 的日志进行聚合
+ *        返回 false: 有日志负载超过 max_payload_len，agg_extract 只看到了前缀
+ */
+static bool block_agg_scan(rollts_manager_t *rollts_manager, uint32_t block_addr,
+                           uint32_t first, uint32_t last,
+                           uint8_t *data, uint32_t max_payload_len, rollts_agg_t *agg)
+{
+    record_pos_t pos;
+    uint32_t number = (first > 1) ? first - 1 : 0;
+    bool valid      = record_seek_start(rollts_manager, block_addr, number, &pos);
+    bool complete   = true;
+
+    while (valid)
+    {
+        number++;
+        uint32_t copy_len  = 0;
+        uint32_t total_len = 0;
+        if (number >= first && record_read_payload(rollts_manager, &pos, data, max_payload_len, &copy_len))
+        {
+            if (record_total_len(rollts_manager, &pos, &total_len) && total_len > copy_len)
+            {
+                complete = false;
+            }
+            agg_add_record(rollts_manager, agg, pos.head.tag, data, copy_len);
+        }
+        if (number >= last)
+        {
+            break;
+        }
+        valid = record_next_start(rollts_manager, &pos);
+    }
+    return complete;
+}
+
+/**
+ * @func: 写入一条汇总记录 失败时计入 rollup->failed
+ */
+static bool rollup_write(rollts_rollup_t *rollup, uint8_t *buf, uint32_t len)
+{
+    if (rollts_add_tag(rollup->target, rollup->tag, buf, len))
+    {
+        return true;
+    }
+    rollup->failed++;
+    return false;
+}
+
+/**
+ * @func: block 回收前汇总
+ *        将即将擦除的 block 压缩为汇总记录写入汇总实例
+ *        自定义汇总每个 block 最多写入 max_out 条 feed 记录，达到上限后不再读取该 block，剩余日志计入 skipped
+ */
+static void block_rollup(rollts_manager_t *rollts_manager, uint32_t block_addr)
+{
+    rollts_rollup_t *rollup = rollts_manager->rollup;
+    if (NULL == rollup || NULL == rollup->target || rollup->target == rollts_manager)
+    {
+        return;
+    }
+    block_info_t block_info;
+    block_info_read(rollts_manager, block_addr, &block_info);
+    int32_t count = (MAGIC_VALID == block_info.magic_valid) ? block_record_count(rollts_manager, block_addr) : 0;
+    if (count <= 0)
+    {
+        return;
+    }
+    uint32_t failed = rollup->failed;
+
+    if (NULL == rollup->feed)
+    {
+        // 内置汇总：每个 block 一条聚合记录，已封顶的 block 直接使用块头聚合值
+        rollts_agg_t agg;
+        memset(&agg, 0, sizeof(rollts_agg_t));
+        if (0xFFFFFFFF != block_info.agg.count)
+        {
+            agg = block_info.agg;
+        }
+        else
+        {
+            agg_reset(&agg);
+            block_agg_scan(rollts_manager, block_addr, 1, UINT32_MAX, rollup->in_buf, rollup->in_size, &agg);
+        }
+        if (agg.count > 0)
+        {
+            rollup_write(rollup, (uint8_t *)&agg, sizeof(rollts_agg_t));
+        }
+    }
+    else
+    {
+        if (NULL != rollup->begin)
+        {
+            rollup->begin();
+        }
+        record_pos_t pos;
+        uint32_t fed     = 0;
+        uint32_t written = 0;
+        bool valid = record_first_start(rollts_manager, block_addr, &pos);
+        while (valid && (0 == rollup->max_out || written < rollup->max_out))
+        {
+            uint32_t copy_len = 0;
+            if (record_read_payload(rollts_manager, &pos, rollup->in_buf, rollup->in_size, &copy_len))
+            {
+                uint32_t out_len = rollup->feed(pos.head.tag, rollup->in_buf, copy_len, rollup->out_buf, rollup->out_size);
+                if (out_len > 0)
+                {
+                    rollup_write(rollup, rollup->out_buf, out_len);
+                    written++;
+                }
+            }
+            fed++;
+            valid = record_next_start(rollts_manager, &pos);
+        }
+        if (valid && fed < (uint32_t)count)
+        {
+            rollup->skipped += (uint32_t)count - fed;
+            log_alt("rollup: block 0x%x reached max_out %d, %d records not summarised",
+                    block_addr, rollup->max_out, count - (int32_t)fed);
+        }
+        if (NULL != rollup->end)
+        {
+            uint32_t out_len = rollup->end(rollup->out_buf, rollup->out_size);
+            if (out_len > 0)
+            {
+                rollup_write(rollup, rollup->out_buf, out_len);
+            }
+        }
+    }
+    if (rollup->failed != failed)
+    {
+        log_alt("rollup: %d summary records of block 0x%x not written", (int)(rollup->failed - failed), block_addr);
+    }
+}
+
+// 冷存储层迁移(定义在日志复制部分)
+static void cold_migrate(rollts_manager_t *rollts_manager);
+static bool cold_premigrate(rollts_manager_t *rollts_manager);
+
+/* function-------------------------------------------------------------------*/
+/**
+ * @func: head日志块迁移
+ */
+static int head_block_move(rollts_manager_t *rollts_manager)
+{
+    // 0. 最旧 block 即将回收：先迁移到冷存储层
+    cold_migrate(rollts_manager);
+    log_debug("(pre)memtab:pre_addr        :0x%x",rollts_manager->mem_tab.pre_addr);
+    log_debug("(pre)memtab:head_addr       :0x%x",rollts_manager->mem_tab.head_addr);
+    log_debug("(pre)memtab:head_backup_addr:0x%x",rollts_manager->mem_tab.head_backup_addr);
+    block_info_t block_info;
+    memset(&block_info,0xFF,sizeof(block_info_t));
+    block_info.magic_valid = MAGIC_VALID;
+    block_info.data_num    = -1;
+    block_info.generation  = ROLLTS_BLOCK_GENERATION(rollts_manager->sys_info);
+    // 1. 将head_back 置为head
+    SET_HEAD(block_info);
+    ROLLTS_FLASH_WRITE(rollts_manager, rollts_manager->mem_tab.head_backup_addr
+                                              ,&block_info, sizeof(block_info_t));
+    // 2. 将之前head置为数据区(按系统分区当前日志格式写入)
+    SET_NOT_HEAD(block_info);
+    SET_BLOCK_FORMAT(block_info, sys_record_format(rollts_manager));
+    rollts_manager->cur_block_format = sys_record_format(rollts_manager);
+    // 序号接续上一写入块
+    block_info.first_seq = rollts_manager->cur_block_first_seq + (uint64_t)rollts_manager->cur_block_data_num;
+    rollts_manager->cur_block_first_seq = block_info.first_seq;
+    ROLLTS_FLASH_ERASE(rollts_manager, rollts_manager->mem_tab.head_addr);
+    ROLLTS_FLASH_WRITE(rollts_manager, rollts_manager->mem_tab.head_addr
+                                              ,&block_info, sizeof(block_info_t));
+    // 3.更新rollts_manager->mem_tab
+    log_debug("mem_tab fresh...");
+    uint32_t pre_addr  = 0;
+    uint32_t cur_addr  = 0;
+    uint32_t next_addr = 0;
+    pre_addr           = rollts_manager->mem_tab.head_addr;
+    cur_addr           = rollts_manager->mem_tab.head_backup_addr;
+    next_addr          = get_next_block(rollts_manager, rollts_manager->mem_tab.head_backup_addr);
+    
+    rollts_manager->mem_tab.pre_addr         = pre_addr;
+    rollts_manager->mem_tab.head_addr        = cur_addr;
+    rollts_manager->mem_tab.head_backup_addr = next_addr;
+
+    // 4.将之前head_back后1 block置为head_back(最旧 block 擦除前先汇总，已清除的 block 不汇总，空闲时已擦除的不再擦除)
+    if(0 == rollts_manager->mem_tab.live_addr)
+    {
+        legacy_seq_reclaim(rollts_manager, rollts_manager->mem_tab.head_backup_addr);
+        block_rollup(rollts_manager, rollts_manager->mem_tab.head_backup_addr);
+    }
+    SET_BACKUP(block_info);
+    block_info.first_seq = ROLLTS_SEQ_NONE;
+    if(rollts_manager->mem_tab.stale_erased_num > 0)
+    {
+        rollts_manager->mem_tab.stale_erased_num--;
+    }
+    else
+    {
+        ROLLTS_FLASH_ERASE(rollts_manager, rollts_manager->mem_tab.head_backup_addr);
+    }
+    ROLLTS_FLASH_WRITE(rollts_manager, rollts_manager->mem_tab.head_backup_addr 
+                                              ,&block_info, sizeof(block_info_t)); 
+    // 已清除的 block 全部回收
+    if(rollts_manager->mem_tab.live_addr == get_next_block(rollts_manager, rollts_manager->mem_tab.head_backup_addr))
+    {
+        rollts_manager->mem_tab.live_addr = 0;
+    }
+    rollts_manager->current_block_full = false;
+    rollts_manager->cur_block_tag_bitmap = 0;
+    agg_reset(&rollts_manager->cur_block_agg);
+    rollts_manager->cur_block_agg_valid  = true;
+    // 最旧 block 已变化，淘汰已回收的缓存日志
+    tail_rollover(rollts_manager);
+    // 打印 memtab信息
+    log_debug("memtab:pre_addr        :0x%x",rollts_manager->mem_tab.pre_addr);
+    log_debug("memtab:head_addr       :0x%x",rollts_manager->mem_tab.head_addr);
+    log_debug("memtab:head_backup_addr:0x%x",rollts_manager->mem_tab.head_backup_addr);
+
+    // 5.从头开始写块数据
+    rollts_manager->rollts_data.magic_valid = MAGIC_DATA_VALID;
+    rollts_manager->rollts_data.pre_addr  = 0;
+    rollts_manager->rollts_data.cur_addr  = rollts_manager->mem_tab.pre_addr + sizeof(block_info_t);
+
+    // test
+    // {
+
+    //     block_info_t block_info_test;  
+
+    //     memset(&block_info_test,0x00,sizeof(block_info_t));     
+    //     ROLLTS_FLASH_READ(rollts_manager, rollts_manager->mem_tab.pre_addr
+    //                                             ,&block_info_test, sizeof(block_info_t));
+    //     log_debug("pre block_info_test:is_head         :0x%x",block_info_test.is_head);
+    //     log_debug("pre block_info_test:head_addr       :0x%x",block_info_test.magic_valid);                                       
+
+    //     memset(&block_info_test,0x00,sizeof(block_info_t));                                        
+    //     ROLLTS_FLASH_READ(rollts_manager, rollts_manager->mem_tab.head_addr
+    //                                             ,&block_info_test, sizeof(block_info_t));
+    //     log_debug("head block_info_test:is_head         :0x%x",block_info_test.is_head);
+    //     log_debug("head block_info_test:head_addr       :0x%x",block_info_test.magic_valid);
+
+    //     memset(&block_info_test,0x00,sizeof(block_info_t));                                        
+    //     ROLLTS_FLASH_READ(rollts_manager, rollts_manager->mem_tab.head_backup_addr
+    //                                             ,&block_info_test, sizeof(block_info_t));   
+    //     log_debug("head back block_info_test:is_head         :0x%x",block_info_test.is_head);
+    //     log_debug("head back block_info_test:head_addr       :0x%x",block_info_test.magic_valid);
+    // }
+    return 0;
+}
+
+/**
+ * @func: 当前block封顶
+ *        写入标签位图、聚合值、最后数据地址与数据条数、块尾偏移表
+ */
+static void block_seal(rollts_manager_t *rollts_manager)
+{
+    rollts_manager->last_valid_data_addr = rollts_manager->rollts_data.pre_addr; // 更新最后有效数据块
+    //空间不足时,对pre block记录最后数据地址 
+    uint32_t last_data_addr = 0x0a; //随机值观察是否被覆写
+    ROLLTS_FLASH_READ(rollts_manager, rollts_manager->mem_tab.pre_addr + offsetof(block_info_t, last_data_addr),
+                                           &last_data_addr, sizeof(uint32_t));
+    //空间不足时，对pre block记录日志数量   
+    int32_t data_num = 0x06; //随机值观察是否被覆写
+    ROLLTS_FLASH_READ(rollts_manager, rollts_manager->mem_tab.pre_addr + offsetof(block_info_t, data_num),
+                                           &data_num, sizeof(int32_t));  
+
+    //旧布局 block(挂载时封顶)只写入位置相同的最后数据地址与数据条数
+    block_info_t pre_block_info;
+    bool legacy = (0 != rollts_manager->legacy_layout)
+               && (NULL != block_info_read(rollts_manager, rollts_manager->mem_tab.pre_addr, &pre_block_info));
+
+    //封顶时写入块内标签位图，供过滤读取跳过整块
+    log_debug("writting tag_bitmap... 0x%x",rollts_manager->cur_block_tag_bitmap);
+    if(!legacy)
+    {
+        uint32_t tag_bitmap = block_tag_bitmap(rollts_manager->cur_block_tag_bitmap);
+        ROLLTS_FLASH_WRITE(rollts_manager, rollts_manager->mem_tab.pre_addr + offsetof(block_info_t, tag_bitmap),
+                                            &tag_bitmap, sizeof(uint32_t));
+    }
+    //封顶时写入块内聚合值，聚合查询完整覆盖该块时不再扫描
+    if(rollts_manager->cur_block_agg_valid && !legacy)
+    {
+        ROLLTS_FLASH_WRITE(rollts_manager, rollts_manager->mem_tab.pre_addr + offsetof(block_info_t, agg),
+                                            &rollts_manager->cur_block_agg, sizeof(rollts_agg_t));
+    }
+    if(0xFFFFFFFF == last_data_addr) //无数据
+    {
+        log_debug("writting last_data_addr... 0x%x",rollts_manager->last_valid_data_addr);
+        ROLLTS_FLASH_WRITE(rollts_manager, rollts_manager->mem_tab.pre_addr + offsetof(block_info_t, last_data_addr),
+                                            &rollts_manager->last_valid_data_addr, sizeof(uint32_t));
+    }
+    else
+    {
+        log_alt("last_data_addr is not 0xFFFFFFFF,you need to check it");
+    }
+    if(-1 == data_num)  
+    {
+        log_debug("writting data_num... %d",rollts_manager->cur_block_data_num);
+        ROLLTS_FLASH_WRITE(rollts_manager, rollts_manager->mem_tab.pre_addr + offsetof(block_info_t, data_num),
+                                            &rollts_manager->cur_block_data_num, sizeof(uint32_t));                                       
+    }  
+    else
+    {
+        log_alt("data_num is not -1,you need to check it");
+    }
+    if(rollts_manager->maintain_defer)
+    {
+        // 偏移表交给 rollts_maintain 补写，上一个待补写 block 未处理时先补写
+        block_footer_flush(rollts_manager);
+        rollts_manager->maintain.footer_addr = rollts_manager->mem_tab.pre_addr;
+    }
+    else
+    {
+        block_footer_write(rollts_manager, rollts_manager->mem_tab.pre_addr,
+                           rollts_manager->rollts_data.cur_addr, rollts_manager->cur_block_data_num);
+    }
+    // test
+    // { 
+    //     block_info_t pre_block_info;
+    //     memset(&pre_block_info , 0xFF, sizeof(block_info_t));
+    //     ROLLTS_FLASH_READ(rollts_manager, rollts_manager->mem_tab.pre_addr,  &pre_block_info, sizeof(block_info_t));
+    //     log_debug("writting pre_block_info:last_data_addr :0x%x",pre_block_info.last_data_addr);
+    //     log_debug("writting pre_block_info:data_num       :0x%x",pre_block_info.data_num);
+    // }
+}
+
+/**
+ * @func: 查找最后一个日志位置,并计算是否需要切换日志块
+ */
+static bool find_the_last_position_and_calc(rollts_manager_t *rollts_manager,
+                                                uint32_t    frame_len,
+                                                uint32_t  payload_len)
+{
+    // 当前块是否已经封顶
+    if(rollts_manager->current_block_full)
+    {
+        log_debug("current block is full,need to move to next block");
+        return false;
+    }
+
+    // 不可超过当前block最后一位，并为块尾偏移表预留空间
+    uint32_t footer_size = (ROLLTS_FMT_FIXED == rollts_manager->cur_block_format) ? 0
+                         : ROLLTS_FOOTER_SIZE(rollts_manager->cur_block_data_num
+                                              + (IS_RECORD_START(rollts_manager->rollts_data) ? 1 : 0));
+    if((rollts_manager->rollts_data.cur_addr % rollts_manager->sys_info.single_block_size + frame_len + footer_size \
+         < rollts_manager->sys_info.single_block_size ))
+    {
+        // 不需要切换日志块
+        rollts_manager->rollts_data.next_addr     = rollts_manager->rollts_data.cur_addr + frame_len;
+        rollts_manager->rollts_data.payload_len   = payload_len;
+        // 当前block数据条数增加(分片续片不计数)
+        if(IS_RECORD_START(rollts_manager->rollts_data))
+        {
+            rollts_manager->cur_block_data_num++;
+        }
+
+        log_debug("rollts_data.magic_valid:0x%x",rollts_manager->rollts_data.magic_valid);
+        log_debug("rollts_data.pre_addr   :0x%x",rollts_manager->rollts_data.pre_addr);
+        log_debug("rollts_data.cur_addr   :0x%x",rollts_manager->rollts_data.cur_addr);
+        log_debug("rollts_data.next_addr  :0x%x",rollts_manager->rollts_data.next_addr);
+        log_debug("rollts_data.payload_len:%d"  ,rollts_manager->rollts_data.payload_len);
+        return true;
+    }
+    else
+    {
+        //需要切换日志块
+        log_debug("no space in current block,need switch to next block");
+
+        // 进行当前block封顶
+        block_seal(rollts_manager);
+        return false;
+    }
+}
+/* function-------------------------------------------------------------------*/
+/**
+ * @func: 添加数据
+ */
+bool rollts_add(rollts_manager_t *rollts_manager, uint8_t *data, uint32_t payload_len)
+{
+    return rollts_add_tag(rollts_manager, 0, data, payload_len);
+}
+
+/**
+ * @func: 封顶当前block并切换到下一个block
+ */
+static void block_switch(rollts_manager_t *rollts_manager)
+{
+    if(!rollts_manager->current_block_full)
+    {
+        block_seal(rollts_manager);
+    }
+    head_block_move(rollts_manager);
+    // 切换完成 rollts_data已置为首个位置
+    rollts_manager->last_valid_data_addr = rollts_manager->rollts_data.cur_addr; // 更新最后有效数据块
+    rollts_manager->cur_block_data_num = 0;
+}
+
+/**
+ * @func: 旧布局分区挂载后转换写入位置
+ *        head_backup 为旧布局时擦除后按当前布局写入(head 成为写入块前先擦除)，写入块为旧布局时封顶并切换，
+ *        之后日志只写入当前布局 block，旧布局 block 只读，回滚时逐个回收
+ */
+static void legacy_upgrade(rollts_manager_t *rollts_manager)
+{
+    block_info_t block_info;
+    if(0 == rollts_manager->legacy_layout || rollts_manager->read_only)
+    {
+        return;
+    }
+    if(NULL != block_info_read(rollts_manager, rollts_manager->mem_tab.head_backup_addr, &block_info))
+    {
+        memset(&block_info, 0xFF, sizeof(block_info_t));
+        block_info.magic_valid = MAGIC_VALID;
+        block_info.data_num    = -1;
+        block_info.generation  = ROLLTS_BLOCK_GENERATION(rollts_manager->sys_info);
+        SET_BACKUP(block_info);
+        if(0 != ROLLTS_FLASH_ERASE(rollts_manager, rollts_manager->mem_tab.head_backup_addr)
+           || 0 != ROLLTS_FLASH_WRITE(rollts_manager, rollts_manager->mem_tab.head_backup_addr, &block_info, sizeof(block_info_t)))
+        {
+            log_error(" legacy head_backup rewrite failed!");
+            return;
+        }
+    }
+    if(NULL != block_info_read(rollts_manager, rollts_manager->mem_tab.pre_addr, &block_info))
+    {
+        log_info(" legacy write block 0x%x sealed", rollts_manager->mem_tab.pre_addr);
+        block_switch(rollts_manager);
+    }
+}
+
+/**
+ * @func: 打开下一个分片
+ *        超过单个 block 的数据按 FIRST/MIDDLE/LAST 分片：首片填满当前 block 剩余空间，
+ *        续片总是从下一个 block 起始写入；日志头先写入(magic 保持擦除值)占用空间
+ */
+static bool append_open_frag(rollts_manager_t *rollts_manager)
+{
+    rollts_append_t *append = &rollts_manager->append;
+    uint32_t block_size     = rollts_manager->sys_info.single_block_size;
+    // 单帧总长上限 冗余4字节
+    uint32_t frame_max      = block_size - sizeof(block_info_t) - 4;
+    uint32_t chunk_len      = append->payload_len - append->offset;
+    uint8_t  frag           = ROLLTS_FRAG_NONE;
+
+    // 按最大日志头(v1)判断是否分片，切换 block 后日志格式变化时同样可以容纳
+    if(0 != append->offset || sizeof(rollts_data_t) + chunk_len >= frame_max)
+    {
+        uint32_t used = rollts_manager->rollts_data.cur_addr % block_size;
+        if(0 != append->offset || rollts_manager->current_block_full
+            || used + record_hdr_len(rollts_manager->cur_block_format, chunk_len) + ROLLTS_FRAG_MIN_LEN
+               + ROLLTS_FOOTER_SIZE(rollts_manager->cur_block_data_num + 1) >= block_size)
+        {
+            block_switch(rollts_manager);
+            used = rollts_manager->rollts_data.cur_addr % block_size;
+        }
+        // 首片为日志起始，占用一条偏移表
+        used += ROLLTS_FOOTER_SIZE(rollts_manager->cur_block_data_num + ((0 == append->offset) ? 1 : 0));
+        uint32_t hdr_len = record_hdr_len(rollts_manager->cur_block_format, chunk_len);
+        if(hdr_len + chunk_len > block_size - used - 1)
+        {
+            chunk_len = block_size - used - 1 - hdr_len;
+        }
+        frag = (0 == append->offset) ? ROLLTS_FRAG_FIRST
+             : (append->offset + chunk_len == append->payload_len) ? ROLLTS_FRAG_LAST : ROLLTS_FRAG_MIDDLE;
+    }
+    rollts_manager->rollts_data.frag = frag;
+    // 数据帧总长计算
+    uint32_t hdr_len        = record_hdr_len(rollts_manager->cur_block_format, chunk_len);
+    uint32_t data_frame_len = hdr_len + chunk_len;
+
+    // 查找当前最后日志位置
+    if(false == find_the_last_position_and_calc(rollts_manager,data_frame_len,chunk_len))
+    {
+        // 空间不足，切换日志块
+        head_block_move(rollts_manager);
+        // 切换完成 rollts_data已置为首个位置
+
+        rollts_manager->last_valid_data_addr = rollts_manager->rollts_data.cur_addr; // 更新最后有效数据块
+        rollts_manager->cur_block_data_num = 0;
+        // 新 block 日志格式可能不同，重新计算帧长
+        hdr_len        = record_hdr_len(rollts_manager->cur_block_format, chunk_len);
+        data_frame_len = hdr_len + chunk_len;
+        if(false == find_the_last_position_and_calc(rollts_manager,data_frame_len,chunk_len))
+        {
+            log_error(" rollts_add: something wrong when find_the_last_position_and_calc");
+            return false;
+        }
+    }
+    if(0 == append->offset)
+    {
+        // 日志起始所在 block 记录标签
+        rollts_manager->cur_block_tag_bitmap |= ROLLTS_TAG_MASK(append->tag);
+        append->start_block = rollts_manager->mem_tab.pre_addr;
+    }
+
+    // 空间足够写入当前数据
+    // WAL机制
+    // 1.写入 offset + 数据len，magic 保持擦除值，提交时写入
+    uint8_t head[sizeof(rollts_data_t)];
+    rollts_manager->rollts_data.tag = append->tag;
+    // 定长日志只有提交标记，提交时写入
+    if(ROLLTS_FMT_FIXED != rollts_manager->cur_block_format)
+    {
+        record_encode_head(rollts_manager->cur_block_format, &rollts_manager->rollts_data, hdr_len, head);
+        ROLLTS_FLASH_WRITE(rollts_manager, rollts_manager->rollts_data.cur_addr, head, hdr_len);
+    }
+
+    append->head_addr  = rollts_manager->rollts_data.cur_addr;
+    if(0 == append->offset)
+    {
+        append->start_addr = append->head_addr;
+    }
+    append->write_addr = rollts_manager->rollts_data.cur_addr + hdr_len;
+    append->frag_left  = chunk_len;
+    // 更新数据信息
+    rollts_manager->rollts_data.pre_addr = rollts_manager->rollts_data.cur_addr;
+    rollts_manager->rollts_data.cur_addr = rollts_manager->rollts_data.next_addr;
+    return true;
+}
+
+/**
+ * @func: 提交当前分片(写入 magic / v2 提交标记)
+ */
+static void append_commit_frag(rollts_manager_t *rollts_manager)
+{
+    if(ROLLTS_FMT_FIXED == rollts_manager->cur_block_format)
+    {
+        uint8_t marker = ROLLTS_FIXED_COMMIT | (rollts_manager->append.tag & 0x1F);
+        ROLLTS_FLASH_WRITE(rollts_manager, rollts_manager->append.head_addr, &marker, sizeof(uint8_t));
+        return;
+    }
+    if(ROLLTS_FMT_V2 == rollts_manager->cur_block_format)
+    {
+        uint8_t marker = ROLLTS_V2_COMMIT;
+        ROLLTS_FLASH_WRITE(rollts_manager, rollts_manager->append.head_addr, &marker, sizeof(uint8_t));
+        return;
+    }
+    uint32_t magic = MAGIC_DATA_VALID;
+    ROLLTS_FLASH_WRITE(rollts_manager, rollts_manager->append.head_addr + offsetof(rollts_data_t, magic_valid),
+                                         &magic, sizeof(uint32_t));
+}
+
+/**
+ * @func: 放弃写入 日志保持未提交状态
+ *        起始 block 仍为写入块时撤销计数，保证序号与块内可见日志一致
+ */
+static void append_cancel(rollts_manager_t *rollts_manager)
+{
+    rollts_append_t *append = &rollts_manager->append;
+    if(append->active && append->start_block == rollts_manager->mem_tab.pre_addr
+        && rollts_manager->cur_block_data_num > 0)
+    {
+        rollts_manager->cur_block_data_num--;
+        if(ROLLTS_FMT_FIXED == rollts_manager->cur_block_format && !rollts_manager->current_block_full)
+        {
+            // 定长 block 内不留空洞：放弃的空位之后不再写入，直接封顶
+            block_seal(rollts_manager);
+            rollts_manager->current_block_full = true;
+        }
+    }
+    if(append->active)
+    {
+        tail_cancel(rollts_manager);
+    }
+    append->active = false;
+}
+
+/**
+ * @func: 开始写入一条日志
+ */
+static bool append_start(rollts_manager_t *rollts_manager, uint8_t tag, uint32_t payload_len)
+{
+    uint32_t frame_max   = rollts_manager->sys_info.single_block_size - sizeof(block_info_t) - 4;
+    // 分片数据最多占用一半数据 block，保证写入过程中不会回收自身的首片
+    uint32_t payload_max = (frame_max - sizeof(rollts_data_t)) * (ROLLTS_DATA_BLOCK_NUM(rollts_manager) / 2);
+    if(rollts_manager->read_only || rollts_manager->append.active || tag >= ROLLTS_TAG_NUM)
+    {
+        return false;
+    }
+    if(ROLLTS_FMT_FIXED == sys_record_format(rollts_manager) && payload_len != sys_fixed_slot(rollts_manager) - 1)
+    {
+        log_alt(" rollts_add: fixed record mode, payload_len must be %d", sys_fixed_slot(rollts_manager) - 1);
+        return false;
+    }
+    if(payload_len > payload_max)
+    {
+        log_alt(" rollts_add: (payload_len :%d, you need to split data less than %d",
+                    payload_len, payload_max);
+        return false;
+    }
+    memset(&rollts_manager->append, 0, sizeof(rollts_append_t));
+    rollts_manager->append.tag         = tag;
+    rollts_manager->append.payload_len = payload_len;
+    rollts_manager->append.active      = append_open_frag(rollts_manager);
+    if(rollts_manager->append.active)
+    {
+        tail_begin(rollts_manager, payload_len);
+    }
+    return rollts_manager->append.active;
+}
+
+/**
+ * @func: 追加写入负载 当前分片写满时提交并打开下一个分片
+ */
+static bool append_write(rollts_manager_t *rollts_manager, uint8_t *data, uint32_t len)
+{
+    rollts_append_t *append = &rollts_manager->append;
+    if(append->offset + len > append->payload_len)
+    {
+        return false;
+    }
+    tail_write(rollts_manager, data, len);
+    while(len > 0)
+    {
+        if(0 == append->frag_left)
+        {
+            append_commit_frag(rollts_manager);
+            if(!append_open_frag(rollts_manager))
+            {
+                return false;
+            }
+        }
+        uint32_t chunk_len = (len < append->frag_left) ? len : append->frag_left;
+        if(0 == append->offset)
+        {
+            // 聚合值提取使用首段负载
+            agg_add_record(rollts_manager, &rollts_manager->cur_block_agg, append->tag, data, chunk_len);
+        }
+        // 2.写入数据
+        ROLLTS_FLASH_WRITE(rollts_manager, append->write_addr, data, chunk_len);
+        append->write_addr += chunk_len;
+        append->frag_left  -= chunk_len;
+        append->offset     += chunk_len;
+        data               += chunk_len;
+        len                -= chunk_len;
+    }
+    return true;
+}
+
+/**
+ * @func: 完成写入 提交最后一个分片
+ */
+static bool append_finish(rollts_manager_t *rollts_manager)
+{
+    rollts_append_t *append = &rollts_manager->append;
+    if(append->offset != append->payload_len)
+    {
+        return false;
+    }
+    if(0 == append->payload_len)
+    {
+        agg_add_record(rollts_manager, &rollts_manager->cur_block_agg, append->tag, NULL, 0);
+    }
+    // 3.写入 magic 提交
+    append_commit_frag(rollts_manager);
+    append->active = false;
+    tail_commit(rollts_manager, append->tag, append->payload_len);
+    return true;
+}
+
+/**
+ * @func: 写入一条日志(调用方持锁)
+ */
+static bool record_add(rollts_manager_t *rollts_manager, uint8_t tag, const rollts_iovec_t *iov, uint32_t iov_cnt)
+{
+    uint32_t payload_len = 0;
+    for(uint32_t i = 0; i < iov_cnt; i++)
+    {
+        payload_len += iov[i].len;
+    }
+    // 流式写入进行中时不允许插入其他日志
+    bool ret = append_start(rollts_manager, tag, payload_len);
+    if(ret)
+    {
+        for(uint32_t i = 0; ret && i < iov_cnt; i++)
+        {
+            ret = append_write(rollts_manager, iov[i].data, iov[i].len);
+        }
+        ret = ret && append_finish(rollts_manager);
+        // 写入失败时日志保持未提交状态
+        append_cancel(rollts_manager);
+    }
+    return ret;
+}
+
+/**
+ * @func: 前置缓冲偏移是否有效
+ */
+static bool burst_offset_valid(const rollts_burst_t *burst, uint32_t offset)
+{
+    return offset < burst->size && 0 == (offset & 3);
+}
+
+/**
+ * @func: 前置缓冲头部是否有效
+ */
+static bool burst_valid(rollts_manager_t *rollts_manager)
+{
+    rollts_burst_t *burst = rollts_manager->burst;
+    return NULL != burst && rollts_manager->burst_size >= sizeof(rollts_burst_t) + 2 * ROLLTS_BURST_ENTRY_SIZE(0)
+        && MAGIC_BURST_VALID == burst->magic_valid
+        && burst->size == (rollts_manager->burst_size - sizeof(rollts_burst_t)) / 4 * 4
+        && burst->check == crc_simple((uint8_t *)burst, offsetof(rollts_burst_t, check))
+        && burst_offset_valid(burst, ROLLTS_LOAD_ACQUIRE(&burst->head))
+        && burst_offset_valid(burst, ROLLTS_LOAD_ACQUIRE(&burst->tail));
+}
+
+/**
+ * @func: 前置缓冲条目校验
+ */
+static uint32_t burst_entry_check(uint8_t *entry_addr, uint32_t len)
+{
+    rollts_burst_entry_t *entry = (rollts_burst_entry_t *)entry_addr;
+    uint32_t check = entry->check;
+    entry->check   = 0;
+    uint32_t ret   = crc_simple(entry_addr, sizeof(rollts_burst_entry_t) + len);
+    entry->check   = check;
+    return ret;
+}
+
+/**
+ * @func: 前置缓冲条目按序写入 Flash(调用方持锁)，最多 max_num 条
+ *        条目校验失败(写入 RAM 时复位)时丢弃其后的全部条目
+ */
+static int32_t burst_flush(rollts_manager_t *rollts_manager, uint32_t max_num)
+{
+    rollts_burst_t *burst = rollts_manager->burst;
+    if (!burst_valid(rollts_manager) || rollts_manager->read_only || rollts_manager->append.active)
+    {
+        return 0;
+    }
+    uint8_t *area  = (uint8_t *)(burst + 1);
+    int32_t  count = 0;
+    uint32_t head  = burst->head;
+    // acquire 读取 tail 之后，tail 之前的条目与回绕标记已完整写入
+    uint32_t tail  = ROLLTS_LOAD_ACQUIRE(&burst->tail);
+    while ((uint32_t)count < max_num && head != tail)
+    {
+        rollts_burst_entry_t *entry = (rollts_burst_entry_t *)(area + head);
+        if (burst->size - head < sizeof(rollts_burst_entry_t) || ROLLTS_BURST_WRAP == entry->len)
+        {
+            head = 0;
+            ROLLTS_STORE_RELEASE(&burst->head, head);
+            continue;
+        }
+        uint32_t size = ROLLTS_BURST_ENTRY_SIZE(entry->len);
+        if (head + size > burst->size || entry->check != burst_entry_check(area + head, entry->len))
+        {
+            log_alt("burst: entry at %d corrupted, drop pending entries", (int)head);
+            ROLLTS_STORE_RELEASE(&burst->head, tail);
+            break;
+        }
+        rollts_iovec_t iov;
+        iov.data = (uint8_t *)(entry + 1);
+        iov.len  = entry->len;
+        if (!record_add(rollts_manager, entry->tag, &iov, 1))
+        {
+            log_alt("burst: write entry at %d failed, dropped", (int)head);
+        }
+        // 条目读取完成后再释放空间给生产者
+        head = (head + size) % burst->size;
+        ROLLTS_STORE_RELEASE(&burst->head, head);
+        count++;
+        if (head == tail)
+        {
+            tail = ROLLTS_LOAD_ACQUIRE(&burst->tail);
+        }
+    }
+    return count;
+}
+
+/**
+ * @func: 挂载前置缓冲 头部无效(冷启动)时初始化为空，否则重放上次运行未写入 Flash 的条目
+ */
+static void burst_open(rollts_manager_t *rollts_manager)
+{
+    rollts_burst_t *burst = rollts_manager->burst;
+    if (NULL == burst || rollts_manager->burst_size < sizeof(rollts_burst_t) + 2 * ROLLTS_BURST_ENTRY_SIZE(0))
+    {
+        return;
+    }
+    if (!burst_valid(rollts_manager))
+    {
+        burst->magic_valid = MAGIC_BURST_VALID;
+        burst->size        = (rollts_manager->burst_size - sizeof(rollts_burst_t)) / 4 * 4;
+        burst->check       = crc_simple((uint8_t *)burst, offsetof(rollts_burst_t, check));
+        burst->head        = 0;
+        burst->tail        = 0;
+        burst->dropped     = 0;
+        return;
+    }
+    int32_t count = burst_flush(rollts_manager, 0xFFFFFFFF);
+    if (count > 0)
+    {
+        log_info("burst: replay %d entries", (int)count);
+    }
+}
+
+/**
+ * @func: 添加带标签的数据
+ */
+bool rollts_add_tag(rollts_manager_t *rollts_manager, uint8_t tag, uint8_t *data, uint32_t payload_len)
+{
+    rollts_iovec_t iov;
+    iov.data = data;
+    iov.len  = payload_len;
+    return rollts_addv(rollts_manager, tag, &iov, 1);
+}
+
+/**
+ * @func: 分散写入一条日志
+ *        前置缓冲中的条目先写入，保持写入顺序
+ */
+bool rollts_addv(rollts_manager_t *rollts_manager, uint8_t tag, const rollts_iovec_t *iov, uint32_t iov_cnt)
+{
+    if(MAGIC_VALID != rollts_manager->is_init)
+    {
+        return false;
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_lock();
+#endif
+    burst_flush(rollts_manager, 0xFFFFFFFF);
+    bool ret = record_add(rollts_manager, tag, iov, iov_cnt);
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_unlock();
+#endif
+    return ret;
+}
+
+/**
+ * @func: 流式写入开始
+ */
+bool rollts_append_begin(rollts_manager_t *rollts_manager, uint8_t tag, uint32_t payload_len)
+{
+    if(MAGIC_VALID != rollts_manager->is_init)
+    {
+        return false;
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_lock();
+#endif
+    bool ret = append_start(rollts_manager, tag, payload_len);
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_unlock();
+#endif
+    return ret;
+}
+
+/**
+ * @func: 流式写入追加负载
+ */
+bool rollts_append_chunk(rollts_manager_t *rollts_manager, uint8_t *data, uint32_t len)
+{
+    if(MAGIC_VALID != rollts_manager->is_init)
+    {
+        return false;
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_lock();
+#endif
+    bool ret = rollts_manager->append.active && append_write(rollts_manager, data, len);
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_unlock();
+#endif
+    return ret;
+}
+
+/**
+ * @func: 流式写入提交
+ */
+bool rollts_append_commit(rollts_manager_t *rollts_manager)
+{
+    if(MAGIC_VALID != rollts_manager->is_init)
+    {
+        return false;
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_lock();
+#endif
+    bool ret = rollts_manager->append.active && append_finish(rollts_manager);
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_unlock();
+#endif
+    return ret;
+}
+
+/**
+ * @func: 流式写入放弃 已占用的空间保持未提交状态
+ */
+void rollts_append_abort(rollts_manager_t *rollts_manager)
+{
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_lock();
+#endif
+    append_cancel(rollts_manager);
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_unlock();
+#endif
+}
+
+/**
+ * @func: 前置缓冲写入 不加锁，只由单个生产者调用
+ */
+bool rollts_burst_add(rollts_manager_t *rollts_manager, uint8_t tag, const uint8_t *data, uint32_t len)
+{
+    rollts_burst_t *burst = rollts_manager->burst;
+    if (!burst_valid(rollts_manager) || tag >= ROLLTS_TAG_NUM || len >= ROLLTS_BURST_WRAP)
+    {
+        return false;
+    }
+    uint8_t *area = (uint8_t *)(burst + 1);
+    // acquire 读取 head，保证 Flash 一侧已读完 head 之前的条目后才覆盖其空间
+    uint32_t head = ROLLTS_LOAD_ACQUIRE(&burst->head);
+    uint32_t tail = burst->tail;
+    uint32_t size = ROLLTS_BURST_ENTRY_SIZE(len);
+    uint32_t used = (tail + burst->size - head) % burst->size;
+    // 数据区末尾放不下时回绕，末尾剩余空间计入占用；head == tail 表示空，至少保留一个对齐单位
+    uint32_t skip = (tail + size > burst->size) ? burst->size - tail : 0;
+    if (used + skip + size >= burst->size)
+    {
+        burst->dropped++;
+        return false;
+    }
+    if (skip >= sizeof(rollts_burst_entry_t))
+    {
+        ((rollts_burst_entry_t *)(area + tail))->len = ROLLTS_BURST_WRAP;
+    }
+    uint32_t pos = (0 != skip) ? 0 : tail;
+    rollts_burst_entry_t *entry = (rollts_burst_entry_t *)(area + pos);
+    entry->len      = (uint16_t)len;
+    entry->tag      = tag;
+    entry->reserved = 0;
+    entry->check    = 0;
+    if (len > 0)
+    {
+        memcpy(entry + 1, data, len);
+    }
+    entry->check    = burst_entry_check(area + pos, len);
+    // 回绕标记与条目完整写入后再 release 发布 tail
+    ROLLTS_STORE_RELEASE(&burst->tail, (pos + size) % burst->size);
+    return true;
+}
+
+/**
+ * @func: 前置缓冲条目写入 Flash
+ */
+int32_t rollts_burst_flush(rollts_manager_t *rollts_manager)
+{
+    if (MAGIC_VALID != rollts_manager->is_init)
+    {
+        return -1;
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_lock();
+#endif
+    int32_t count = burst_flush(rollts_manager, 0xFFFFFFFF);
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_unlock();
+#endif
+    return count;
+}
+
+
+/**
+ * @func: 热层最旧日志序号，没有冷存储层时返回 0
+ *        冷层只读取小于该序号的日志，避免与热层重复
+ */
+static uint64_t cold_end_seq(rollts_manager_t *rollts_manager)
+{
+    rollts_replica_t *cold = rollts_manager->cold;
+    if (NULL == cold || NULL == cold->dst || cold->dst == rollts_manager || MAGIC_VALID != cold->dst->is_init)
+    {
+        return 0;
+    }
+    uint64_t oldest = block_first_seq(rollts_manager, get_oldest_block(rollts_manager));
+    /* 热层最旧 block 未写入(刚格式化)：以下一个写入序号为界 */
+    return (ROLLTS_SEQ_NONE == oldest) ? rollts_manager->cur_block_first_seq : oldest;
+}
+
+/**
+ * @func: 统计实例内的日志条数(调用方持锁，不含冷存储层)
+ */
+static int32_t record_total(rollts_manager_t *rollts_manager)
+{
+    int32_t total = 0;
+
+    /* 当前写入 block(pre_addr)始终参与计数 */
+    total += rollts_manager->cur_block_data_num;
+
+    /* 满的 block：从 pre 的上一个 block 逆向遍历到 oldest_block(含) */
+    uint32_t cur_block = rollts_manager->mem_tab.pre_addr;
+
+    while (cur_block != get_oldest_block(rollts_manager)) 
+    {
+        cur_block = get_pre_block(rollts_manager, cur_block);
+
+        int32_t num = -1;
+        if (0 != rollts_manager->legacy_layout)
+        {
+            // 旧布局 block 的 data_num 可能不可靠
+            num = block_record_count(rollts_manager, cur_block);
+        }
+        else
+        {
+            ROLLTS_FLASH_READ(rollts_manager, cur_block + offsetof(block_info_t, data_num),
+                                                &num, sizeof(num));
+        }
+
+        if (num >= 0)
+        {
+            total += num;
+        }
+    }
+    return total;
+}
+
+/**
+ * @func: 获取总日志条数
+ *        热层在持锁时统计并确定冷层边界，释放热层锁后再获取冷层锁统计冷层，不同时持有两个实例的锁
+ */
+int32_t rollts_get_total_record_number(rollts_manager_t *rollts_manager)
+{
+    if (MAGIC_VALID != rollts_manager->is_init) 
+    {
+        return -1;
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_lock();
+#endif
+    int32_t  total    = record_total(rollts_manager);
+    uint64_t cold_end = cold_end_seq(rollts_manager);
+    rollts_manager_t *cold = (0 != cold_end) ? rollts_manager->cold->dst : NULL;
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_unlock();
+#endif
+    /* 冷存储层：计入早于热层最旧日志的部分，之后迁移到冷层的日志序号不小于 cold_end，不重复计数 */
+    if (NULL != cold)
+    {
+#ifdef RTOS_MUTEX_ENABLE
+        cold->flash_ops.mutex_lock();
+#endif
+        int32_t  cold_num  = record_total(cold);
+        uint64_t cold_next = cold->cur_block_first_seq + (uint64_t)cold->cur_block_data_num;
+#ifdef RTOS_MUTEX_ENABLE
+        cold->flash_ops.mutex_unlock();
+#endif
+        if (cold_next > cold_end)
+        {
+            cold_num -= (int32_t)(cold_next - cold_end);
+        }
+        if (cold_num > 0)
+        {
+            total += cold_num;
+        }
+    }
+    return total;
+}
+
+/**
+ * @func: 遍历单个block的链表
+ *        先读取日志头进行标签/过滤判断，通过后才读取负载
+ *        序号达到 end_seq 时结束(ROLLTS_SEQ_NONE:不限)
+ *        返回 false: 回调要求停止读取
+ */
+static bool block_scan(rollts_manager_t *rollts_manager, uint32_t block_addr,
+                       uint32_t tag_mask, rollTsFilter filter,
+                       uint8_t *data, uint32_t max_payload_len, rollTscb cb, uint64_t end_seq)
+{
+    record_pos_t pos;
+    bool valid = record_first_start(rollts_manager, block_addr, &pos);
+    uint64_t seq = (ROLLTS_SEQ_NONE == end_seq) ? 0 : block_first_seq(rollts_manager, block_addr);
+
+    /* 正向遍历当前 block 的链表 */
+    while (valid && seq < end_seq) 
+    {
+        if ((pos.head.tag < ROLLTS_TAG_NUM && (tag_mask & ROLLTS_TAG_MASK(pos.head.tag)))
+          &&(NULL == filter || filter(pos.head.tag, pos.head.payload_len)))
+        {
+            uint32_t copy_len = 0;
+            if (record_read_payload(rollts_manager, &pos, data, max_payload_len, &copy_len)
+              && !cb(data,copy_len))
+            {
+                return false;
+            }
+        }
+        seq++;
+        valid = record_next_start(rollts_manager, &pos);
+    }
+    return true;
+}
+
+/**
+ * @func: 从最旧 block 开始按标签遍历，序号达到 end_seq 时结束
+ *        返回 false: 回调要求停止读取
+ */
+static bool tag_scan(rollts_manager_t *rollts_manager, uint32_t tag_mask, rollTsFilter filter,
+                     uint8_t *data, uint32_t max_payload_len, rollTscb cb, uint64_t end_seq)
+{
+    /* 最旧 block = head_backup 的下一个 */
+    uint32_t current_block_addr = get_oldest_block(rollts_manager);  
+
+    /* 循环直到遇到 head */
+    while (current_block_addr != rollts_manager->mem_tab.head_addr) 
+    {
+        if (ROLLTS_SEQ_NONE != end_seq && block_first_seq(rollts_manager, current_block_addr) >= end_seq)
+        {
+            break;
+        }
+        /* 块内标签位图与掩码无交集时跳过整块 */
+        uint32_t tag_bitmap = rollts_manager->cur_block_tag_bitmap;
+        if (current_block_addr != rollts_manager->mem_tab.pre_addr)
+        {
+            block_info_field(rollts_manager, current_block_addr, offsetof(block_info_t, tag_bitmap),
+                                               &tag_bitmap, sizeof(tag_bitmap));
+        }
+        if (0 != (tag_bitmap & tag_mask)
+            && !block_scan(rollts_manager, current_block_addr, tag_mask, filter, data, max_payload_len, cb, end_seq))
+        {
+            return false;
+        }
+
+        /* 下一个 block */
+        current_block_addr = get_next_block(rollts_manager, current_block_addr);
+    }
+    return true;
+}
+
+/**
+ * @func:整体读取所有日志
+ */
+bool rollts_get_all(rollts_manager_t *rollts_manager, uint8_t *data, uint32_t max_payload_len,rollTscb cb)
+{
+    return rollts_get_by_tag(rollts_manager, ROLLTS_TAG_ALL, NULL, data, max_payload_len, cb);
+}
+
+/**
+ * @func:按标签过滤读取日志
+ */
+bool rollts_get_by_tag(rollts_manager_t *rollts_manager, uint32_t tag_mask, rollTsFilter filter,
+                       uint8_t *data, uint32_t max_payload_len, rollTscb cb)
+{
+    if (MAGIC_VALID != rollts_manager->is_init) 
+    {
+        return false;
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_lock();
+#endif
+    bool running = true;
+    /* 冷存储层：先读取热层最旧日志之前的部分 */
+    uint64_t cold_end = cold_end_seq(rollts_manager);
+    if (0 != cold_end)
+    {
+        rollts_manager_t *cold = rollts_manager->cold->dst;
+#ifdef RTOS_MUTEX_ENABLE
+        cold->flash_ops.mutex_lock();
+#endif
+        running = tag_scan(cold, tag_mask, filter, data, max_payload_len, cb, cold_end);
+#ifdef RTOS_MUTEX_ENABLE
+        cold->flash_ops.mutex_unlock();
+#endif
+    }
+    if (running)
+    {
+        tag_scan(rollts_manager, tag_mask, filter, data, max_payload_len, cb, ROLLTS_SEQ_NONE);
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_unlock();
+#endif
+    return true;
+}
+
+/**
+ * @func: 游标初始化
+ */
+void rollts_cursor_init(rollts_cursor_t *cursor)
+{
+    cursor->block_addr = 0;
+    cursor->data_addr  = 0;
+    cursor->seq        = 0;
+}
+
+/**
+ * @func: 游标前进一条(调用方持锁)
+ */
+static bool cursor_step(rollts_manager_t *rollts_manager, rollts_cursor_t *cursor, rollts_record_info_t *info)
+{
+    bool ret = false;
+    record_pos_t pos;
+
+    /* 未开始或所在 block 已被回收(回收后重新写入的 block 序号大于游标序号)：从最旧 block 开始 */
+    if (!is_live_block(rollts_manager, cursor->block_addr)
+        || cursor->seq < block_first_seq(rollts_manager, cursor->block_addr))
+    {
+        cursor->block_addr = get_oldest_block(rollts_manager);
+        cursor->data_addr  = block_data_start(rollts_manager, cursor->block_addr);
+        cursor->seq        = block_first_seq(rollts_manager, cursor->block_addr);
+    }
+
+    while (true)
+    {
+        record_block_init(rollts_manager, cursor->block_addr, &pos);
+        pos.data_addr  = cursor->data_addr;
+        bool valid = record_read_head(rollts_manager, &pos);
+        while (valid && !IS_RECORD_START(pos.head))
+        {
+            valid = record_next(rollts_manager, &pos);
+        }
+        if (valid && rollts_manager->append.active && pos.data_addr == rollts_manager->append.start_addr)
+        {
+            /* 写入中的日志(首片已提交、后续分片未写完)：停在其之前，提交后再读取 */
+            cursor->data_addr = pos.data_addr;
+            break;
+        }
+        if (valid)
+        {
+            cursor->data_addr = pos.head.next_addr;
+            info->seq         = cursor->seq++;
+            if (!record_total_len(rollts_manager, &pos, &info->payload_len))
+            {
+                /* 分片不完整的日志不可见 */
+                continue;
+            }
+            info->handle = pos.data_addr;
+            info->tag    = pos.head.tag;
+            info->frag   = pos.head.frag;
+            ret = true;
+            break;
+        }
+        if (cursor->block_addr == rollts_manager->mem_tab.pre_addr)
+        {
+            /* 停在写入位置，等待新日志；写入中的日志未提交时停在其日志头，不跳过 */
+            if (!rollts_manager->append.active || rollts_manager->append.start_block != cursor->block_addr
+                || rollts_manager->append.start_addr < cursor->data_addr
+                || rollts_manager->append.start_addr >= pos.data_addr)
+            {
+                cursor->data_addr = pos.data_addr;
+            }
+            break;
+        }
+        cursor->block_addr = get_next_block(rollts_manager, cursor->block_addr);
+        cursor->data_addr  = block_data_start(rollts_manager, cursor->block_addr);
+        cursor->seq        = block_first_seq(rollts_manager, cursor->block_addr);
+    }
+    return ret;
+}
+
+/**
+ * @func: 游标读取下一条日志头
+ */
+bool rollts_cursor_next(rollts_manager_t *rollts_manager, rollts_cursor_t *cursor, rollts_record_info_t *info)
+{
+    if (MAGIC_VALID != rollts_manager->is_init) 
+    {
+        return false;
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_lock();
+#endif
+    bool ret = cursor_step(rollts_manager, cursor, info);
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_unlock();
+#endif
+    return ret;
+}
+
+/**
+ * @func: 按句柄读取日志负载(调用方持锁)
+ */
+static int32_t record_read_handle(rollts_manager_t *rollts_manager, uint32_t handle,
+                                  uint32_t offset, uint8_t *data, uint32_t len)
+{
+    int32_t ret = -1;
+    uint32_t copy_len = 0;
+    record_pos_t pos;
+    uint32_t block_addr = handle - (handle - rollts_manager->sys_info.data_start_addr) % rollts_manager->sys_info.single_block_size;
+    if (is_live_block(rollts_manager, block_addr))
+    {
+        record_block_init(rollts_manager, block_addr, &pos);
+        pos.data_addr = handle;
+        /* 句柄不能落在块头内(旧布局 block 头长度不同) */
+        pos.hdr_len   = (handle < pos.data_start) ? 0
+                      : (uint8_t)record_decode_head(rollts_manager, pos.format, handle, pos.data_end, &pos.head);
+        if (0 != pos.hdr_len && MAGIC_DATA_VALID == pos.head.magic_valid && handle == pos.head.cur_addr && IS_RECORD_START(pos.head)
+            && record_read_range(rollts_manager, &pos, offset, data, len, &copy_len))
+        {
+            ret = (int32_t)copy_len;
+        }
+    }
+    return ret;
+}
+
+/**
+ * @func: 按句柄读取日志负载
+ */
+int32_t rollts_read_record(rollts_manager_t *rollts_manager, uint32_t handle,
+                           uint32_t offset, uint8_t *data, uint32_t len)
+{
+    if (MAGIC_VALID != rollts_manager->is_init || handle < rollts_manager->sys_info.data_start_addr) 
+    {
+        return -1;
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_lock();
+#endif
+    int32_t ret = record_read_handle(rollts_manager, handle, offset, data, len);
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_unlock();
+#endif
+    return ret;
+}
+
+/**
+ * @func: 下一条写入日志的序号
+ */
+uint64_t rollts_next_seq(rollts_manager_t *rollts_manager)
+{
+    if (MAGIC_VALID != rollts_manager->is_init) 
+    {
+        return 0;
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_lock();
+#endif
+    uint64_t seq = rollts_manager->cur_block_first_seq + (uint64_t)rollts_manager->cur_block_data_num;
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_unlock();
+#endif
+    return seq;
+}
+
+/**
+ * @func: 查找 seq 所在 block
+ *        有效 block 从最旧到 pre 的 first_seq 单调递增(未写入的空 block 只会出现在最旧一侧)，
+ *        二分查找最后一个 first_seq <= seq 的 block
+ *        返回 ROLLTS_SEQ_GAP: 请求的日志已被回滚，block_addr 为最旧 block
+ */
+static int32_t block_find_seq(rollts_manager_t *rollts_manager, uint64_t seq, uint32_t *block_addr, uint64_t *first_seq)
+{
+    uint32_t block_size = rollts_manager->sys_info.single_block_size;
+    uint32_t data_size  = rollts_manager->sys_info.data_end_addr + block_size - rollts_manager->sys_info.data_start_addr;
+    uint32_t oldest     = get_oldest_block(rollts_manager);
+    /* 有效 block: oldest ~ pre */
+    int32_t  lo         = 0;
+    int32_t  hi         = (int32_t)block_distance(rollts_manager, oldest, rollts_manager->mem_tab.pre_addr);
+    int32_t  found      = -1;
+    uint64_t found_seq  = ROLLTS_SEQ_NONE;
+    while (lo <= hi)
+    {
+        int32_t  mid        = lo + (hi - lo) / 2;
+        uint32_t mid_addr   = rollts_manager->sys_info.data_start_addr
+                            + (oldest - rollts_manager->sys_info.data_start_addr + (uint32_t)mid * block_size) % data_size;
+        uint64_t mid_seq    = block_first_seq(rollts_manager, mid_addr);
+        if (ROLLTS_SEQ_NONE == mid_seq || mid_seq <= seq)
+        {
+            found     = mid;
+            found_seq = mid_seq;
+            lo        = mid + 1;
+        }
+        else
+        {
+            hi = mid - 1;
+        }
+    }
+
+    /* 所有 block 的序号都大于 seq，或落在未写入的空 block：请求的日志已被回滚 */
+    if (found < 0 || ROLLTS_SEQ_NONE == found_seq)
+    {
+        *block_addr = oldest;
+        *first_seq  = block_first_seq(rollts_manager, oldest);
+        return ROLLTS_SEQ_GAP;
+    }
+    *block_addr = rollts_manager->sys_info.data_start_addr
+                + (oldest - rollts_manager->sys_info.data_start_addr + (uint32_t)found * block_size) % data_size;
+    *first_seq  = found_seq;
+    return 0;
+}
+
+/**
+ * @func: 按序号增量读取单个实例 读取 [seq, end_seq) 的日志(end_seq 为 ROLLTS_SEQ_NONE 时不限)
+ *        定位起始 block 后块内按日志起始计数跳过
+ *        *running 置为 false: 回调要求停止读取
+ */
+static int32_t since_scan(rollts_manager_t *rollts_manager, uint64_t seq, uint64_t end_seq,
+                          uint8_t *data, uint32_t max_payload_len, rollTsSeqcb cb, bool *running)
+{
+    /* 完全落在最新日志缓存内：不读取 Flash */
+    if (tail_hit(rollts_manager, seq))
+    {
+        rollts_tail_t *tail = rollts_manager->tail;
+        for (uint32_t i = 0; i < tail->count; i++)
+        {
+            const rollts_tail_entry_t *entry = tail_entry(tail, i);
+            if (entry->seq >= end_seq)
+            {
+                break;
+            }
+            if (entry->seq >= seq && !cb(entry->seq, data, tail_read(tail, entry, data, max_payload_len)))
+            {
+                *running = false;
+                break;
+            }
+        }
+        return 0;
+    }
+    uint32_t block_addr = 0;
+    uint64_t cur_seq    = 0;
+    int32_t  ret        = block_find_seq(rollts_manager, seq, &block_addr, &cur_seq);
+
+    while (*running && block_addr != rollts_manager->mem_tab.head_addr && cur_seq < end_seq)
+    {
+        record_pos_t pos;
+        /* 起始 block 内直接定位到 seq */
+        uint32_t skip = 0;
+        if (ROLLTS_SEQ_GAP != ret && cur_seq < seq)
+        {
+            skip = (seq - cur_seq > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32_t)(seq - cur_seq);
+        }
+        bool valid = record_seek_start(rollts_manager, block_addr, skip, &pos);
+        cur_seq   += skip;
+        while (valid && cur_seq < end_seq)
+        {
+            if (cur_seq >= seq || ROLLTS_SEQ_GAP == ret)
+            {
+                uint32_t copy_len = 0;
+                if (record_read_payload(rollts_manager, &pos, data, max_payload_len, &copy_len)
+                    && !cb(cur_seq, data, copy_len))
+                {
+                    *running = false;
+                    break;
+                }
+            }
+            cur_seq++;
+            valid = record_next_start(rollts_manager, &pos);
+        }
+        block_addr = get_next_block(rollts_manager, block_addr);
+        cur_seq    = block_first_seq(rollts_manager, block_addr);
+    }
+    return ret;
+}
+
+/**
+ * @func: 按序号增量读取
+ *        请求的序号早于热层最旧日志且配置了冷存储层时先读冷层
+ */
+int32_t rollts_read_since(rollts_manager_t *rollts_manager, uint64_t seq,
+                          uint8_t *data, uint32_t max_payload_len, rollTsSeqcb cb)
+{
+    if (MAGIC_VALID != rollts_manager->is_init) 
+    {
+        return -1;
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_lock();
+#endif
+    int32_t  ret      = 0;
+    bool     running  = true;
+    bool     cold_hit = false;
+    uint64_t cold_end = cold_end_seq(rollts_manager);
+    if (seq < cold_end)
+    {
+        cold_hit = true;
+        rollts_manager_t *cold = rollts_manager->cold->dst;
+#ifdef RTOS_MUTEX_ENABLE
+        cold->flash_ops.mutex_lock();
+#endif
+        ret = since_scan(cold, seq, cold_end, data, max_payload_len, cb, &running);
+#ifdef RTOS_MUTEX_ENABLE
+        cold->flash_ops.mutex_unlock();
+#endif
+        seq = cold_end;
+    }
+    if (running)
+    {
+        /* 已从冷层读取时热层从最旧日志接续，返回值以冷层为准 */
+        int32_t hot_ret = since_scan(rollts_manager, seq, ROLLTS_SEQ_NONE, data, max_payload_len, cb, &running);
+        if (!cold_hit)
+        {
+            ret = hot_ret;
+        }
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_unlock();
+#endif
+    return ret;
+}
+
+/**
+ * @func: 提交消费者位置
+ *        追加写入位置日志，消费者扇区写满时擦除该扇区并压缩(旧分区写满时提交失败，rollts_clear 后迁移到消费者扇区)
+ */
+bool rollts_consumer_commit(rollts_manager_t *rollts_manager, const char *name, uint64_t seq)
+{
+    if (MAGIC_VALID != rollts_manager->is_init || rollts_manager->read_only
+        || NULL == name || strlen(name) >= ROLLTS_CONSUMER_NAME_LEN) 
+    {
+        return false;
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_lock();
+#endif
+    bool ret = false;
+    rollts_consumer_t *consumer = consumer_find(rollts_manager, name, true);
+    if (NULL != consumer)
+    {
+        if (consumer->used && consumer->seq == seq)
+        {
+            ret = true;
+        }
+        else
+        {
+            consumer->used = true;
+            consumer->seq  = seq;
+            uint32_t sector = consumer_sector_addr(rollts_manager);
+            if (0 != sector && rollts_manager->consumer_log_addr + sizeof(rollts_consumer_entry_t)
+                               > sector + rollts_manager->sys_info.single_block_size)
+            {
+                ret = (0 == consumer_compact(rollts_manager));
+            }
+            else if (0 == sector && rollts_manager->sys_log_addr + sizeof(rollts_consumer_entry_t)
+                                    > rollts_manager->sys_info.single_block_size)
+            {
+                // 没有消费者扇区：压缩系统分区追加区(写入每个消费者的最新位置)
+                ret = (0 == sys_log_compact(rollts_manager));
+            }
+            else
+            {
+                ret = (0 == consumer_entry_write(rollts_manager, consumer));
+            }
+        }
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_unlock();
+#endif
+    return ret;
+}
+
+/**
+ * @func: 查询消费者位置
+ */
+bool rollts_consumer_get(rollts_manager_t *rollts_manager, const char *name, uint64_t *seq)
+{
+    if (MAGIC_VALID != rollts_manager->is_init || NULL == name) 
+    {
+        return false;
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_lock();
+#endif
+    rollts_consumer_t *consumer = consumer_find(rollts_manager, name, false);
+    if (NULL != consumer)
+    {
+        *seq = consumer->seq;
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_unlock();
+#endif
+    return NULL != consumer;
+}
+
+/**
+ * @func: 查询消费者积压条数
+ */
+int64_t rollts_consumer_lag(rollts_manager_t *rollts_manager, const char *name)
+{
+    uint64_t seq = 0;
+    if (!rollts_consumer_get(rollts_manager, name, &seq))
+    {
+        return -1;
+    }
+    uint64_t next_seq = rollts_next_seq(rollts_manager);
+    return (next_seq > seq) ? (int64_t)(next_seq - seq) : 0;
+}
+
+/**
+ * @func: 从消费者位置读取新日志
+ */
+int32_t rollts_consumer_read(rollts_manager_t *rollts_manager, const char *name,
+                             uint8_t *data, uint32_t max_payload_len, rollTsSeqcb cb)
+{
+    uint64_t seq = 0;
+    if (!rollts_consumer_get(rollts_manager, name, &seq))
+    {
+        return -1;
+    }
+    return rollts_read_since(rollts_manager, seq, data, max_payload_len, cb);
+}
+
+/**
+ * @func:选择性读取从旧到新编号，1=最旧，total=最新
+ */
+bool rollts_read_pick(rollts_manager_t *rollts_manager,
+                      uint32_t start_num, 
+                      uint32_t end_num,
+                      uint8_t *data, 
+                      uint32_t max_payload_len,
+                      rollTscb cb)
+{
+    if (MAGIC_VALID != rollts_manager->is_init || start_num == 0 || start_num > end_num) 
+    {
+        return false;
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_lock();
+#endif
+    /* 编号换算为序号，完全落在最新日志缓存内时不读取 Flash */
+    if (NULL != rollts_manager->tail
+        && tail_hit(rollts_manager, rollts_manager->tail->oldest_seq + start_num - 1))
+    {
+        rollts_tail_t *tail = rollts_manager->tail;
+        uint64_t first_seq  = tail->oldest_seq + start_num - 1;
+        uint64_t last_seq   = tail->oldest_seq + end_num - 1;
+        bool found_any      = false;
+        for (uint32_t i = 0; i < tail->count; i++)
+        {
+            const rollts_tail_entry_t *entry = tail_entry(tail, i);
+            if (entry->seq >= first_seq && entry->seq <= last_seq)
+            {
+                found_any = true;
+                cb(data, tail_read(tail, entry, data, max_payload_len));
+            }
+        }
+#ifdef RTOS_MUTEX_ENABLE
+        rollts_manager->flash_ops.mutex_unlock();
+#endif
+        return found_any;
+    }
+    record_pos_t pos;
+    uint32_t block_addr = get_oldest_block(rollts_manager);
+    uint32_t current_number = 0;
+    bool found_any = false;
+
+    while (block_addr != rollts_manager->mem_tab.head_addr) 
+    {
+        /* 整块位于起始编号之前：按块内条数跳过 */
+        uint32_t count = (uint32_t)block_record_count(rollts_manager, block_addr);
+        if (current_number + count < start_num)
+        {
+            current_number += count;
+            block_addr = get_next_block(rollts_manager, block_addr);
+            continue;
+        }
+        uint32_t skip  = (start_num > current_number + 1) ? start_num - current_number - 1 : 0;
+        bool valid     = record_seek_start(rollts_manager, block_addr, skip, &pos);
+        current_number += skip;
+
+        /* 内层遍历当前 block 的链表 */
+        while (valid) 
+        {
+            current_number++;
+
+            if (current_number >= start_num && current_number <= end_num) 
+            {
+                uint32_t copy_len = 0;
+                if (record_read_payload(rollts_manager, &pos, data, max_payload_len, &copy_len))
+                {
+                    found_any = true;
+                    cb(data,copy_len);
+                }
+                // test
+                // data[copy_len - 1] = '\0';
+                // log_info("[PICK %lu] %s", current_number, (char*)data);
+            }
+
+            /* 如果已经超过所需范围，可以提前结束整个遍历(优化) */
+            if (current_number >= end_num) 
+            {
+#ifdef RTOS_MUTEX_ENABLE
+                rollts_manager->flash_ops.mutex_unlock();
+#endif
+                return true;
+            }
+
+            valid = record_next_start(rollts_manager, &pos);
+        }
+
+        /* 跳到下一个 block(顺时针) */
+        block_addr = get_next_block(rollts_manager, block_addr);
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_unlock();
+#endif
+    return found_any;
+}
+
+/**
+ * @func: 聚合查询 从旧到新编号，1=最旧，total=最新
+ */
+bool rollts_aggregate(rollts_manager_t *rollts_manager,
+                      uint32_t start_num, uint32_t end_num,
+                      uint8_t *data, uint32_t max_payload_len, rollts_agg_t *agg)
+{
+    if (MAGIC_VALID != rollts_manager->is_init || NULL == rollts_manager->agg_extract
+        || start_num == 0 || start_num > end_num) 
+    {
+        return false;
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_lock();
+#endif
+    agg_reset(agg);
+    uint32_t block_addr = get_oldest_block(rollts_manager);
+    uint32_t base       = 0;        /* 当前 block 之前的日志条数 */
+
+    while (block_addr != rollts_manager->mem_tab.head_addr && base < end_num) 
+    {
+        uint32_t count = (uint32_t)block_record_count(rollts_manager, block_addr);
+
+        if (count > 0 && base + count >= start_num)
+        {
+            rollts_agg_t block_agg;
+            bool stored = false;
+            /* 完整覆盖的 block 使用已存储的聚合值 */
+            if (start_num <= base + 1 && base + count <= end_num)
+            {
+                if (block_addr == rollts_manager->mem_tab.pre_addr)
+                {
+                    block_agg = rollts_manager->cur_block_agg;
+                    stored    = rollts_manager->cur_block_agg_valid;
+                }
+                else
+                {
+                    block_info_field(rollts_manager, block_addr, offsetof(block_info_t, agg),
+                                                       &block_agg, sizeof(rollts_agg_t));
+                    stored = (0xFFFFFFFF != block_agg.count);
+                }
+            }
+            if (stored)
+            {
+                agg_merge(agg, &block_agg);
+            }
+            else
+            {
+                /* 边缘 block 或未存储聚合值的 block 逐条扫描 */
+                block_agg_scan(rollts_manager, block_addr,
+                               (start_num > base) ? start_num - base : 1, end_num - base,
+                               data, max_payload_len, agg);
+            }
+        }
+        base += count;
+        block_addr = get_next_block(rollts_manager, block_addr);
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_unlock();
+#endif
+    return true;
+}
+
+/**
+ * @brief 日志使用容量 百分比
+ */
+uint8_t rollts_capacity(rollts_manager_t *rollts_manager)
+{
+
+    if (MAGIC_VALID != rollts_manager->is_init) 
+    {
+        return false;
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_lock();
+#endif
+    uint8_t percent = 0;
+    uint32_t used_sectors = 0;
+    uint32_t block_addr = get_oldest_block(rollts_manager);
+
+    while (block_addr != rollts_manager->mem_tab.head_addr) 
+    {
+        if (block_addr == rollts_manager->mem_tab.pre_addr) 
+        {
+            if (rollts_manager->cur_block_data_num > 0) 
+            {
+                used_sectors++;
+            }
+
+        } 
+        else 
+        {
+            int32_t num = 0;
+            ROLLTS_FLASH_READ(rollts_manager, block_addr + offsetof(block_info_t, data_num),
+                                                &num, sizeof(num));
+            if (num > 0) 
+            {
+                used_sectors++;
+            }
+        }
+        block_addr = get_next_block(rollts_manager, block_addr);
+    }
+
+    uint32_t total = ROLLTS_DATA_BLOCK_NUM(rollts_manager) - 2;
+    percent = total ? (used_sectors * 100 + total / 2) / total : 0;  // 四舍五入算法
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_unlock();
+#endif
+    return (100 - percent);
+}
+
+
+uint32_t rollts_capacity_size(rollts_manager_t *rollts_manager)
+{
+    return (rollts_manager->sys_info.rollts_max_block_num * rollts_manager->sys_info.single_block_size - 1) /1024;
+}
+
+/**
+ * @func: 初始化 rollts
+ */
+int rollts_init(rollts_manager_t *rollts_manager)
+{
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_lock();
+#endif
+    int ret = -1;
+    // 新分区序号从 0 开始
+    rollts_manager->cur_block_first_seq = 0;
+    if(check_if_rollts_size_aligned(rollts_manager))
+    {
+        tail_attach(rollts_manager);
+        // 系统分区压缩中掉电时先按备份恢复
+        sys_backup_restore(rollts_manager);
+        bool sys_valid = check_if_sys_aligned(rollts_manager);
+        if(sys_valid)
+        {
+            // 系统分区追加的日志格式更新记录先于定长格式检查加载
+            consumer_load(rollts_manager);
+        }
+        if(sys_valid && (rollts_manager->read_only || !sys_fixed_format_changed(rollts_manager)))
+        {
+            // 日志格式变化时更新系统分区，已有 block 回滚时逐块转换
+            ret = sys_record_format_update(rollts_manager);
+        }
+        else if(rollts_manager->read_only)
+        {
+            log_error(" rollTs invalid! read only, skip format");
+#ifdef RTOS_MUTEX_ENABLE
+            rollts_manager->flash_ops.mutex_unlock();
+#endif
+            return -1;
+        }
+        else
+        {
+            rollts_manager_print(rollts_manager);
+            //重新初始化数据库
+            log_info(" rollTs invalid! reinit...");
+            memset(rollts_manager->consumers, 0, sizeof(rollts_manager->consumers));
+            rollts_manager_init(rollts_manager);
+            ret = rollts_format(rollts_manager, false);
+        }
+    }
+    else
+    {
+        log_error(" rollts size not aligned!");
+#ifdef RTOS_MUTEX_ENABLE
+        rollts_manager->flash_ops.mutex_unlock();
+#endif
+        return -1;
+    }
+    //打印 rollts_manager信息
+    rollts_manager_print(rollts_manager);
+    if(0 == rollts_mem_tab_init(rollts_manager))
+    {
+        rollts_manager->is_init = MAGIC_VALID;
+        legacy_seq_init(rollts_manager);
+    }
+    memset(&rollts_manager->rollts_data,0,sizeof(rollts_data_t));
+    //初始化当前块数据数量
+    data_block_loop(rollts_manager);
+    if(MAGIC_VALID == rollts_manager->is_init)
+    {
+        // 旧布局分区：写入位置转换为当前布局 block
+        legacy_upgrade(rollts_manager);
+        // 重放前置缓冲中上次运行未写入 Flash 的条目
+        burst_open(rollts_manager);
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_unlock();
+#endif
+    return ret;
+}
+
+/**
+ * @func: 清除所有日志数据，之后的日志序号从 first_seq 开始
+ *        rollts_manager_init 递增代号，格式化只擦除 3 个 block，旧 block 按代号判为无效
+ */
+static int rollts_reset(rollts_manager_t *rollts_manager, uint64_t first_seq)
+{
+    int ret = -1;
+    rollts_manager->cur_block_first_seq = first_seq;
+    rollts_manager_print(rollts_manager);
+    //重新初始化数据库
+    log_debug(" rollTs invalid! reinit...");
+    // 旧分区清除时迁移到消费者扇区，已有消费者扇区时保留
+    uint32_t sector = consumer_sector_addr(rollts_manager);
+    rollts_manager_init(rollts_manager);
+    ret = rollts_format(rollts_manager, 0 != sector && sector == consumer_sector_addr(rollts_manager));
+    //打印 rollts_manager信息
+    rollts_manager_print(rollts_manager);
+    if(0 == rollts_mem_tab_init(rollts_manager))
+    {
+        rollts_manager->is_init = MAGIC_VALID;
+    }
+    memset(&rollts_manager->rollts_data,0,sizeof(rollts_data_t));
+    //初始化当前块数据数量
+    data_block_loop(rollts_manager);
+    return ret;
+}
+
+/**
+ * @func: 清除所有日志数据
+ */
+bool rollts_clear(rollts_manager_t *rollts_manager)
+{
+    if(rollts_manager->read_only)
+    {
+        return false;
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_lock();
+#endif
+    // 清除后序号继续递增，增量同步方不会误读旧序号
+    int ret = rollts_reset(rollts_manager, (MAGIC_VALID == rollts_manager->is_init)
+                           ? rollts_manager->cur_block_first_seq + (uint64_t)rollts_manager->cur_block_data_num : 0);
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_unlock();
+#endif
+    return 0 == ret;
+}
+
+/**
+ * @func: 提前擦除已清除的 block
+ *        从 head_backup 之后开始，连续区间优先使用 erase_range(不跨越分区末尾)
+ */
+static uint32_t stale_block_erase(rollts_manager_t *rollts_manager, uint32_t max_blocks)
+{
+    uint32_t erased = 0;
+    if(0 != rollts_manager->mem_tab.live_addr)
+    {
+        uint32_t block_size = rollts_manager->sys_info.single_block_size;
+        uint32_t first      = get_next_block(rollts_manager, rollts_manager->mem_tab.head_backup_addr);
+        uint32_t stale_num  = block_distance(rollts_manager, first, rollts_manager->mem_tab.live_addr);
+        while(rollts_manager->mem_tab.stale_erased_num < stale_num && erased < max_blocks)
+        {
+            uint32_t addr = first;
+            for(uint32_t i = 0; i < rollts_manager->mem_tab.stale_erased_num; i++)
+            {
+                addr = get_next_block(rollts_manager, addr);
+            }
+            uint32_t run = stale_num - rollts_manager->mem_tab.stale_erased_num;
+            if(run > max_blocks - erased)
+            {
+                run = max_blocks - erased;
+            }
+            if(run > (rollts_manager->sys_info.data_end_addr - addr) / block_size + 1)
+            {
+                run = (rollts_manager->sys_info.data_end_addr - addr) / block_size + 1;
+            }
+            if(rollts_manager->flash_ops.erase_range)
+            {
+                if(0 != rollts_manager->flash_ops.erase_range(addr, run * block_size))
+                {
+                    break;
+                }
+            }
+            else
+            {
+                uint32_t i;
+                for(i = 0; i < run; i++)
+                {
+                    if(0 != ROLLTS_FLASH_ERASE(rollts_manager, addr + i * block_size))
+                    {
+                        break;
+                    }
+                }
+                run = i;
+            }
+            rollts_manager->mem_tab.stale_erased_num += run;
+            erased += run;
+            if(0 == run)
+            {
+                break;
+            }
+        }
+        log_debug(" erase stale blocks:%d/%d", rollts_manager->mem_tab.stale_erased_num, stale_num);
+    }
+    return erased;
+}
+
+/**
+ * @func: 空闲时提前擦除已清除的 block
+ */
+int32_t rollts_erase_stale(rollts_manager_t *rollts_manager, uint32_t max_blocks)
+{
+    if(MAGIC_VALID != rollts_manager->is_init || rollts_manager->read_only)
+    {
+        return -1;
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_lock();
+#endif
+    uint32_t erased = stale_block_erase(rollts_manager, max_blocks);
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_unlock();
+#endif
+    return (int32_t)erased;
+}
+
+/**
+ * @func: 巡检 block：按日志链遍历，核对日志条数与块尾偏移表
+ *        日志不含校验和，巡检只检查结构一致性，异常时记录不修改
+ */
+static bool block_scrub(rollts_manager_t *rollts_manager, uint32_t block_addr)
+{
+    block_info_t block_info;
+    const rollts_layout_t *layout = block_info_read(rollts_manager, block_addr, &block_info);
+    if (MAGIC_VALID != block_info.magic_valid || block_info.generation != ROLLTS_BLOCK_GENERATION(rollts_manager->sys_info))
+    {
+        return false;
+    }
+    record_pos_t pos;
+    uint32_t footer_num = record_block_init(rollts_manager, block_addr, &pos);
+    uint32_t num        = 0;
+    bool valid          = record_first_start(rollts_manager, block_addr, &pos);
+    while (valid)
+    {
+        if (num < footer_num)
+        {
+            uint16_t offset = 0xFFFF;
+            ROLLTS_FLASH_READ(rollts_manager, pos.data_end + num * ROLLTS_FOOTER_ENTRY_SIZE, &offset, sizeof(uint16_t));
+            if (offset != pos.data_addr - block_addr)
+            {
+                return false;
+            }
+        }
+        num++;
+        valid = record_next_start(rollts_manager, &pos);
+    }
+    return block_info.data_num < 0 || (NULL != layout && layout->count_walk) || num == (uint32_t)block_info.data_num;
+}
+
+/**
+ * @func: 重建当前块聚合值
+ *        负载读入 agg_buf(未配置时使用汇总层 in_buf，均未配置时使用 ROLLTS_MAINTAIN_BUF_SIZE 字节栈缓冲)，
+ *        有日志超过缓冲长度时放弃重建：聚合值保持失效，封顶时不写入，查询时扫描该块
+ */
+static void maintain_agg_rebuild(rollts_manager_t *rollts_manager)
+{
+    uint8_t  stack_buf[ROLLTS_MAINTAIN_BUF_SIZE];
+    uint8_t *buf      = stack_buf;
+    uint32_t buf_size = sizeof(stack_buf);
+    if (NULL != rollts_manager->agg_buf && 0 != rollts_manager->agg_buf_size)
+    {
+        buf      = rollts_manager->agg_buf;
+        buf_size = rollts_manager->agg_buf_size;
+    }
+    else if (NULL != rollts_manager->rollup && NULL != rollts_manager->rollup->in_buf && 0 != rollts_manager->rollup->in_size)
+    {
+        buf      = rollts_manager->rollup->in_buf;
+        buf_size = rollts_manager->rollup->in_size;
+    }
+    rollts_agg_t agg;
+    agg_reset(&agg);
+    if (!block_agg_scan(rollts_manager, rollts_manager->mem_tab.pre_addr, 1, (uint32_t)rollts_manager->cur_block_data_num,
+                        buf, buf_size, &agg))
+    {
+        log_info(" maintain: record longer than %d bytes, current block aggregate not rebuilt", buf_size);
+        return;
+    }
+    rollts_manager->cur_block_agg       = agg;
+    rollts_manager->cur_block_agg_valid = true;
+}
+
+/**
+ * @func: 执行一步空闲维护，按优先级每次只做一项
+ *        返回 false: 没有待处理的工作(巡检一轮结束)
+ */
+static bool maintain_step(rollts_manager_t *rollts_manager)
+{
+    rollts_maintain_t *maintain = &rollts_manager->maintain;
+    // 1.前置缓冲条目写入 Flash
+    if (burst_flush(rollts_manager, 1) > 0)
+    {
+        return true;
+    }
+    // 2.补写延迟的偏移表
+    if (0 != maintain->footer_addr && !rollts_manager->read_only)
+    {
+        block_footer_flush(rollts_manager);
+        return true;
+    }
+    maintain->footer_addr = 0;
+    // 3.写入块已满(挂载时)：提前切换，擦除不再发生在下一次写入中
+    if (rollts_manager->current_block_full && !rollts_manager->read_only)
+    {
+        block_switch(rollts_manager);
+        return true;
+    }
+    // 4.重建重启后失效的当前块聚合值(每次挂载只尝试一次)
+    if (!rollts_manager->cur_block_agg_valid && !maintain->agg_tried && NULL != rollts_manager->agg_extract)
+    {
+        maintain->agg_tried = true;
+        maintain_agg_rebuild(rollts_manager);
+        return true;
+    }
+    // 5.已封顶 block 预先迁移到冷存储层，回滚时不再拷贝
+    if (cold_premigrate(rollts_manager))
+    {
+        return true;
+    }
+    // 6.提前擦除已清除的 block
+    if (!rollts_manager->read_only && stale_block_erase(rollts_manager, 1) > 0)
+    {
+        return true;
+    }
+    // 7.巡检已封顶 block(最旧 ~ 写入块之前)，一轮结束后从最旧 block 重新开始
+    if (0 == maintain->scrub_addr || !is_live_block(rollts_manager, maintain->scrub_addr))
+    {
+        maintain->scrub_addr = get_oldest_block(rollts_manager);
+    }
+    if (maintain->scrub_addr == rollts_manager->mem_tab.pre_addr)
+    {
+        maintain->scrub_addr = 0;
+        return false;
+    }
+    if (!block_scrub(rollts_manager, maintain->scrub_addr))
+    {
+        log_alt("scrub: block 0x%x inconsistent", maintain->scrub_addr);
+        maintain->scrub_error++;
+    }
+    maintain->scrub_block++;
+    maintain->scrub_addr = get_next_block(rollts_manager, maintain->scrub_addr);
+    return true;
+}
+
+/**
+ * @func: 空闲维护
+ *        budget_us 为 0 时不执行；否则至少执行一步，提供 clock_us 时在 budget_us 内继续执行；流式写入进行中不执行
+ */
+int32_t rollts_maintain(rollts_manager_t *rollts_manager, uint32_t budget_us)
+{
+    if (MAGIC_VALID != rollts_manager->is_init)
+    {
+        return -1;
+    }
+    if (0 == budget_us)
+    {
+        return 0;
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_lock();
+#endif
+    int32_t  steps = 0;
+    uint32_t start = rollts_manager->clock_us ? rollts_manager->clock_us() : 0;
+    while (!rollts_manager->append.active && maintain_step(rollts_manager))
+    {
+        steps++;
+        if (NULL == rollts_manager->clock_us || rollts_manager->clock_us() - start >= budget_us)
+        {
+            break;
+        }
+    }
+#ifdef RTOS_MUTEX_ENABLE
+    rollts_manager->flash_ops.mutex_unlock();
+#endif
+    return steps;
+}
+
+/**
+ * @func: 副本跳到 seq(src 序号不连续)：封顶当前写入块，新写入块从 seq 开始
+ */
+static void replica_skip_to(rollts_manager_t *dst, uint64_t seq)
+{
+    dst->cur_block_first_seq = seq - (uint64_t)dst->cur_block_data_num;
+    block_switch(dst);
+}
+
+/**
+ * @func: 判断 src block 能否整块拷贝
+ *        已封顶、v2/定长格式(日志头不含绝对地址)且与 dst 写入块格式一致，首条不是续片、末条不是未完成的分片
+ */
+static bool replica_block_copyable(rollts_replica_t *replica, uint32_t block_addr, const block_info_t *block_info)
+{
+    rollts_manager_t *src = replica->src;
+    rollts_manager_t *dst = replica->dst;
+    uint8_t format        = block_record_format(block_info);
+    if (block_addr == src->mem_tab.pre_addr || block_info->data_num <= 0 || 0xFFFFFFFF == block_info->last_data_addr
+        || ROLLTS_FMT_V1 == format || format != dst->cur_block_format
+        || (ROLLTS_FMT_FIXED == format && sys_fixed_slot(src) != sys_fixed_slot(dst)))
+    {
+        return false;
+    }
+    record_pos_t  pos;
+    rollts_data_t last;
+    return record_first(src, block_addr, &pos) && IS_RECORD_START(pos.head)
+        && 0 != record_decode_head(src, format, block_info->last_data_addr,
+                                   block_addr + src->sys_info.single_block_size, &last)
+        && ROLLTS_FRAG_FIRST != last.frag && ROLLTS_FRAG_MIDDLE != last.frag;
+}
+
+/**
+ * @func: 拷贝 src 区间到 dst
+ */
+static void replica_copy_range(rollts_replica_t *replica, uint32_t src_addr, uint32_t dst_addr, uint32_t len)
+{
+    while (len > 0)
+    {
+        uint32_t n = (len < replica->buf_size) ? len : replica->buf_size;
+        ROLLTS_FLASH_READ(replica->src, src_addr, replica->buf, n);
+        ROLLTS_FLASH_WRITE(replica->dst, dst_addr, replica->buf, n);
+        src_addr += n;
+        dst_addr += n;
+        len      -= n;
+    }
+}
+
+/**
+ * @func: 整块拷贝到 dst 写入块
+ *        按 block_seal 顺序：日志区 -> 块头封顶字段 -> 块尾偏移表，中断时 dst 挂载按未封顶 block 修复
+ */
+static void replica_block_copy(rollts_replica_t *replica, uint32_t block_addr, const block_info_t *block_info)
+{
+    rollts_manager_t *src = replica->src;
+    rollts_manager_t *dst = replica->dst;
+    uint32_t block_size   = src->sys_info.single_block_size;
+    uint32_t dst_block    = dst->mem_tab.pre_addr;
+    rollts_data_t last;
+    record_decode_head(src, block_record_format(block_info), block_info->last_data_addr, block_addr + block_size, &last);
+
+    // 1.日志区
+    replica_copy_range(replica, block_addr + sizeof(block_info_t), dst_block + sizeof(block_info_t),
+                       last.next_addr - block_addr - sizeof(block_info_t));
+    // 2.封顶
+    uint32_t last_data_addr = block_info->last_data_addr - block_addr + dst_block;
+    ROLLTS_FLASH_WRITE(dst, dst_block + offsetof(block_info_t, tag_bitmap), (void *)&block_info->tag_bitmap, sizeof(uint32_t));
+    ROLLTS_FLASH_WRITE(dst, dst_block + offsetof(block_info_t, agg), (void *)&block_info->agg, sizeof(rollts_agg_t));
+    ROLLTS_FLASH_WRITE(dst, dst_block + offsetof(block_info_t, last_data_addr), &last_data_addr, sizeof(uint32_t));
+    ROLLTS_FLASH_WRITE(dst, dst_block + offsetof(block_info_t, data_num), (void *)&block_info->data_num, sizeof(int32_t));
+    // 3.块尾偏移表(相对 block 起始，直接拷贝)
+    if (HAS_BLOCK_FOOTER((*block_info)))
+    {
+        uint32_t footer_size = ROLLTS_FOOTER_SIZE(block_info->data_num);
+        block_info_t dst_info;
+        replica_copy_range(replica, block_addr + block_size - footer_size, dst_block + block_size - footer_size, footer_size);
+        ROLLTS_FLASH_READ(dst, dst_block + offsetof(block_info_t, status), &dst_info.status, sizeof(uint8_t));
+        SET_BLOCK_FOOTER(dst_info);
+        ROLLTS_FLASH_WRITE(dst, dst_block + offsetof(block_info_t, status), &dst_info.status, sizeof(uint8_t));
+    }
+    dst->cur_block_data_num   = block_info->data_num;
+    dst->cur_block_tag_bitmap = block_info->tag_bitmap;
+    dst->current_block_full   = true;
+    block_switch(dst);
+    // 整块拷贝的日志不经过写入路径，最新日志缓存重新开始
+    tail_reset(dst);
+}
+
+/**
+ * @func: 逐条流式复制一条日志(分片日志沿后续 block 读取)
+ */
+static bool replica_record_copy(rollts_replica_t *replica, const record_pos_t *pos, uint32_t payload_len)
+{
+    rollts_manager_t *dst = replica->dst;
+    if (!append_start(dst, pos->head.tag, payload_len))
+    {
+        return false;
+    }
+    bool     ok     = true;
+    uint32_t offset = 0;
+    while (ok && offset < payload_len)
+    {
+        uint32_t len      = payload_len - offset;
+        uint32_t copy_len = 0;
+        if (len > replica->buf_size)
+        {
+            len = replica->buf_size;
+        }
+        ok = record_read_range(replica->src, pos, offset, replica->buf, len, &copy_len) && copy_len > 0
+          && append_write(dst, replica->buf, copy_len);
+        offset += copy_len;
+    }
+    ok = ok && append_finish(dst);
+    // 失败时日志保持未提交状态
+    append_cancel(dst);
+    return ok;
+}
+
+/**
+ * @func: 从 dst 的下一个序号开始复制 src 日志，直到 end_seq(不含)或达到 max_records
+ *        调用方持有 src、dst 锁并已确认 dst 序号落在 src 保留范围内
+ */
+static int32_t replica_run(rollts_replica_t *replica, uint64_t end_seq, uint32_t max_records)
+{
+    rollts_manager_t *src = replica->src;
+    rollts_manager_t *dst = replica->dst;
+    int32_t  copied   = 0;
+    uint64_t next     = dst->cur_block_first_seq + (uint64_t)dst->cur_block_data_num;
+    while (next < end_seq && (uint32_t)copied < max_records)
+    {
+        uint32_t block_addr = 0;
+        uint64_t first_seq  = 0;
+        if (ROLLTS_SEQ_GAP == block_find_seq(src, next, &block_addr, &first_seq))
+        {
+            break;
+        }
+        block_info_t block_info;
+        // 旧布局 block 头长度不同，逐条复制
+        const rollts_layout_t *layout = block_info_read(src, block_addr, &block_info);
+        if (first_seq == next && NULL == layout && replica_block_copyable(replica, block_addr, &block_info))
+        {
+            // dst 写入块已有日志时先切换，之后 dst block 与 src block 一一对齐
+            if (dst->current_block_full || 0 != dst->cur_block_data_num
+                || dst->rollts_data.cur_addr != dst->mem_tab.pre_addr + sizeof(block_info_t))
+            {
+                block_switch(dst);
+            }
+            replica_block_copy(replica, block_addr, &block_info);
+            replica->block_copied++;
+            copied += block_info.data_num;
+            next   += (uint64_t)block_info.data_num;
+            continue;
+        }
+        record_pos_t pos;
+        uint32_t payload_len = 0;
+        if (!record_seek_start(src, block_addr, (uint32_t)(next - first_seq), &pos))
+        {
+            // 块内没有该序号(序号不连续)：跳到下一个 block
+            if (block_addr == src->mem_tab.pre_addr)
+            {
+                break;
+            }
+            next = block_first_seq(src, get_next_block(src, block_addr));
+            replica_skip_to(dst, next);
+            continue;
+        }
+        if (!record_total_len(src, &pos, &payload_len))
         {
-            log_error(" rollts_add: something wrong when find_the_last_position_and_calc");
-#ifdef RTOS_MUTEX_ENABLE
-            rollts_manager->flash_ops.mutex_unlock();
-#endif
-            return false;
+            // 分片不完整的日志在 src 中不可见，副本同样跳过该序号
+            next++;
+            replica_skip_to(dst, next);
+            continue;
         }
+        if (!replica_record_copy(replica, &pos, payload_len))
+        {
+            log_alt("replica: copy seq %d failed", (int)next);
+            break;
+        }
+        replica->record_copied++;
+        copied++;
+        next++;
     }
-
-    // 空间足够写入当前数据
-    // WAL机制
-    // 1.写入magic + offset + 数据len
-    rollts_manager->flash_ops.write_data(rollts_manager->rollts_data.cur_addr,&rollts_manager->rollts_data,sizeof(rollts_data_t));
-    // 2.写入数据
-    rollts_manager->flash_ops.write_data(rollts_manager->rollts_data.cur_addr + sizeof(rollts_data_t),data,payload_len);
-    // test
-    // {
-    //     uint8_t data_test[110] = {0};
-    //     memset(data_test,0x00,sizeof(data));
-    //     rollts_manager->flash_ops.read_data(rollts_manager->rollts_data.cur_addr + sizeof(rollts_data_t), 
-    //                                         &data_test, 100);
-    // }
-    // 3.更新数据信息
-    rollts_manager->rollts_data.pre_addr = rollts_manager->rollts_data.cur_addr;
-    rollts_manager->rollts_data.cur_addr = rollts_manager->rollts_data.next_addr;
-#ifdef RTOS_MUTEX_ENABLE
-    rollts_manager->flash_ops.mutex_unlock();
-#endif
-    return true;
+    return copied;
 }
 
-
 /**
- * @func: 获取总日志条数
- *
+ * @func: 复制 src 新增日志到 dst
+ *        dst 的下一个序号即复制位置；落后于 src 保留范围或超前时清除 dst 并从 src 最旧日志重新开始
+ *        整块拷贝按 block 内日志数计入，可能超过 max_records；src 流式写入进行中时不复制
  */
-int32_t rollts_get_total_record_number(rollts_manager_t *rollts_manager)
+int32_t rollts_replicate(rollts_replica_t *replica, uint32_t max_records)
 {
-    if (MAGIC_VALID != rollts_manager->is_init) 
+    rollts_manager_t *src = replica->src;
+    rollts_manager_t *dst = replica->dst;
+    if (src == dst || MAGIC_VALID != src->is_init || MAGIC_VALID != dst->is_init || dst->read_only
+        || NULL == replica->buf || 0 == replica->buf_size)
     {
         return -1;
     }
 #ifdef RTOS_MUTEX_ENABLE
-    rollts_manager->flash_ops.mutex_lock();
+    src->flash_ops.mutex_lock();
+    dst->flash_ops.mutex_lock();
 #endif
-    int32_t total = 0;
-
-    /* 当前写入 block(pre_addr)始终参与计数 */
-    total += rollts_manager->cur_block_data_num;
-
-    /* 满的 block：从 pre 的上一个 block 逆向遍历到 oldest_block 的上一个 */
-    uint32_t cur_block = get_pre_block(rollts_manager, rollts_manager->mem_tab.pre_addr); /* 刚满的那个 block */
-
-    while (cur_block != get_oldest_block(rollts_manager)) 
+    int32_t  copied   = 0;
+    uint64_t src_next = src->cur_block_first_seq + (uint64_t)src->cur_block_data_num;
+    uint64_t next     = dst->cur_block_first_seq + (uint64_t)dst->cur_block_data_num;
+    uint64_t oldest   = block_first_seq(src, get_oldest_block(src));
+    if (!src->append.active && !dst->append.active)
     {
-        int32_t num = -1;
-        rollts_manager->flash_ops.read_data(cur_block + offsetof(block_info_t, data_num),
-                                            &num, sizeof(num));
-
-        if (num >= 0)
+        if (next > src_next || next < oldest)
         {
-            total += num;
+            log_alt("replica: next seq %d out of source range [%d, %d], resync", (int)next, (int)oldest, (int)src_next);
+            rollts_reset(dst, oldest);
+            replica->resync++;
         }
-        cur_block = get_pre_block(rollts_manager, cur_block);
+        copied = replica_run(replica, src_next, max_records);
     }
 #ifdef RTOS_MUTEX_ENABLE
-    rollts_manager->flash_ops.mutex_unlock();
+    dst->flash_ops.mutex_unlock();
+    src->flash_ops.mutex_unlock();
 #endif
-    return total;
+    return copied;
 }
 
 /**
- * @func:整体读取所有日志
+ * @func: 冷存储层是否可用(冷层已初始化、可写且配置了拷贝缓冲)
  */
-bool rollts_get_all(rollts_manager_t *rollts_manager, uint8_t *data, uint32_t max_payload_len,rollTscb cb)
+static bool cold_ready(rollts_manager_t *rollts_manager)
 {
-    if (MAGIC_VALID != rollts_manager->is_init) 
-    {
-        return false;
-    }
+    rollts_replica_t *cold = rollts_manager->cold;
+    return NULL != cold && NULL != cold->dst && cold->dst != rollts_manager && MAGIC_VALID == cold->dst->is_init
+        && !cold->dst->read_only && NULL != cold->buf && 0 != cold->buf_size;
+}
+
+/**
+ * @func: 复制热层日志到冷层，直到 end_seq(不含)或达到 max_records(调用方持有热层锁)
+ *        冷层落后于热层保留范围时跳过已回收的序号；返回冷层的下一个序号
+ */
+static uint64_t cold_copy(rollts_manager_t *rollts_manager, uint64_t end_seq, uint32_t max_records)
+{
+    rollts_replica_t *cold = rollts_manager->cold;
+    rollts_manager_t *dst  = cold->dst;
+    cold->src = rollts_manager;
 #ifdef RTOS_MUTEX_ENABLE
-    rollts_manager->flash_ops.mutex_lock();
+    dst->flash_ops.mutex_lock();
 #endif
-    rollts_data_t tmp;
-    /* 最旧 block = head_backup 的下一个 */
-    uint32_t current_block_addr = get_oldest_block(rollts_manager);  
-
-    /* 循环直到遇到 head */
-    while (current_block_addr != rollts_manager->mem_tab.head_addr) 
+    uint64_t oldest = block_first_seq(rollts_manager, get_oldest_block(rollts_manager));
+    uint64_t next   = dst->cur_block_first_seq + (uint64_t)dst->cur_block_data_num;
+    if (!dst->append.active && ROLLTS_SEQ_NONE != oldest && next < end_seq)
     {
-        uint32_t data_addr = current_block_addr + sizeof(block_info_t);
-
-        /* 正向遍历当前 block 的链表 */
-        while (data_addr + sizeof(rollts_data_t) <= current_block_addr + rollts_manager->sys_info.single_block_size) 
+        if (next < oldest)
         {
-            rollts_manager->flash_ops.read_data(data_addr, &tmp, sizeof(rollts_data_t));
-
-            if (tmp.magic_valid != MAGIC_DATA_VALID) 
-            {
-                break;   /* 本 block 数据结束 */
-            }
-
-            uint32_t copy_len = (tmp.payload_len <= max_payload_len) ? tmp.payload_len : max_payload_len;
-
-            rollts_manager->flash_ops.read_data(data_addr + sizeof(rollts_data_t),
-                                                data, copy_len);
-            cb(data,copy_len);
-            // test
-            // data[copy_len - 1] = '\0';
-            // log_info("%s", (char*)data);
-
-            data_addr = tmp.next_addr;
+            log_alt("cold: next seq %d behind hot oldest %d, skip", (int)next, (int)oldest);
+            replica_skip_to(dst, oldest);
+            cold->resync++;
         }
-
-        /* 下一个 block */
-        current_block_addr = get_next_block(rollts_manager, current_block_addr);
+        replica_run(cold, end_seq, max_records);
+        next = dst->cur_block_first_seq + (uint64_t)dst->cur_block_data_num;
     }
 #ifdef RTOS_MUTEX_ENABLE
-    rollts_manager->flash_ops.mutex_unlock();
+    dst->flash_ops.mutex_unlock();
 #endif
-    return true;
+    return next;
 }
 
 /**
- * @func:选择性读取从旧到新编号，1=最旧，total=最新
+ * @func: 空闲时把已封顶 block 预先迁移到冷层(每次最多一个 block 或一条日志)
+ *        返回 false: 没有待迁移的日志
  */
-bool rollts_read_pick(rollts_manager_t *rollts_manager,
-                      uint32_t start_num, 
-                      uint32_t end_num,
-                      uint8_t *data, 
-                      uint32_t max_payload_len,
-                      rollTscb cb)
+static bool cold_premigrate(rollts_manager_t *rollts_manager)
 {
-    if (MAGIC_VALID != rollts_manager->is_init || start_num == 0 || start_num > end_num) 
+    if (!cold_ready(rollts_manager) || 0 != rollts_manager->mem_tab.live_addr)
     {
         return false;
     }
-#ifdef RTOS_MUTEX_ENABLE
-    rollts_manager->flash_ops.mutex_lock();
-#endif
-    rollts_data_t tmp;
-    uint32_t block_addr = get_oldest_block(rollts_manager);
-    uint32_t current_number = 0;
-    bool found_any = false;
+    rollts_manager_t *dst = rollts_manager->cold->dst;
+    uint64_t end_seq      = rollts_manager->cur_block_first_seq;
+    uint64_t next         = dst->cur_block_first_seq + (uint64_t)dst->cur_block_data_num;
+    return next < end_seq && cold_copy(rollts_manager, end_seq, 1) != next;
+}
 
-    while (block_addr != rollts_manager->mem_tab.head_addr) 
+/**
+ * @func: 冷存储层迁移 热层最旧 block 回收前调用(已持有热层锁)
+ *        只复制 rollts_maintain 尚未预迁移的部分，到最旧 block 之后一个 block 的第一条日志为止；
+ *        冷层不可用或复制中断时回收照常进行，未迁移的日志计入 cold->lost
+ */
+static void cold_migrate(rollts_manager_t *rollts_manager)
+{
+    rollts_replica_t *cold = rollts_manager->cold;
+    if (NULL == cold || 0 != rollts_manager->mem_tab.live_addr)
     {
-        uint32_t data_addr = block_addr + sizeof(block_info_t);
-
-        /* 内层遍历当前 block 的链表 */
-        while (data_addr + sizeof(rollts_data_t) <= block_addr + rollts_manager->sys_info.single_block_size) 
-        {
-            rollts_manager->flash_ops.read_data(data_addr, &tmp, sizeof(rollts_data_t));
-
-            if (tmp.magic_valid != MAGIC_DATA_VALID) 
-            {
-                break;  /* 本 block 数据结束，跳出内层循环，继续下一个 block */
-            }
-
-            current_number++;
+        return;
+    }
+    uint32_t oldest_addr = get_oldest_block(rollts_manager);
+    uint64_t oldest      = block_first_seq(rollts_manager, oldest_addr);
+    uint64_t end_seq     = block_first_seq(rollts_manager, get_next_block(rollts_manager, oldest_addr));
+    if (ROLLTS_SEQ_NONE == oldest || ROLLTS_SEQ_NONE == end_seq || end_seq <= oldest)
+    {
+        return;
+    }
+    uint64_t next = cold_ready(rollts_manager) ? cold_copy(rollts_manager, end_seq, 0xFFFFFFFF) : oldest;
+    if (next < end_seq)
+    {
+        uint64_t lost = end_seq - ((next > oldest) ? next : oldest);
+        log_alt("cold: %d records of block 0x%x reclaimed without migration", (int)lost, oldest_addr);
+        cold->lost += (uint32_t)lost;
+    }
+}
 
-            if (current_number >= start_num && current_number <= end_num) 
-            {
-                uint32_t copy_len = (tmp.payload_len <= max_payload_len) ? tmp.payload_len : max_payload_len;
-                rollts_manager->flash_ops.read_data(data_addr + sizeof(rollts_data_t), data, copy_len);
+/**
+ * @func: 副本落后的日志条数(负数:副本序号超前，下次复制时重新对齐)
+ */
+int64_t rollts_replica_lag(rollts_replica_t *replica)
+{
+    if (MAGIC_VALID != replica->src->is_init || MAGIC_VALID != replica->dst->is_init)
+    {
+        return -1;
+    }
+    return (int64_t)(rollts_next_seq(replica->src) - rollts_next_seq(replica->dst));
+}
 
-                found_any = true;
-                cb(data,copy_len);
-                // test
-                // data[copy_len - 1] = '\0';
-                // log_info("[PICK %lu] %s", current_number, (char*)data);
-            }
+/**
+ * @func: 合并读取：挂载该实例的预读窗口(调用方持锁)
+ *        窗口填充后发生回滚或清除时丢弃；游标位于已封顶 block 且不在窗口内时从游标位置整段预读
+ */
+static void merge_window_attach(rollts_merge_src_t *src)
+{
+    rollts_manager_t *mgr    = src->mgr;
+    rollts_window_t  *window = &src->window;
+    uint32_t block_size      = mgr->sys_info.single_block_size;
+    uint32_t block_addr      = src->cursor.block_addr;
+    uint32_t data_addr       = src->cursor.data_addr;
+    if (window->head_addr != mgr->mem_tab.head_addr || window->generation != mgr->sys_info.generation)
+    {
+        window->len = 0;
+    }
+    mgr->window = window;
+    uint32_t window_end = window->addr + window->len;
+    if (NULL == src->buf || !is_live_block(mgr, block_addr) || block_addr == mgr->mem_tab.pre_addr
+        || data_addr < block_addr + sizeof(block_info_t) || data_addr >= block_addr + block_size
+        || (data_addr >= window->addr && data_addr < window_end
+            && (data_addr + sizeof(rollts_data_t) <= window_end || window_end == block_addr + block_size)))
+    {
+        return;
+    }
+    /* 缓冲不小于 block 时连同 block 头整块读取 */
+    uint32_t start = (src->buf_size >= block_size) ? block_addr : data_addr;
+    uint32_t len   = block_addr + block_size - start;
+    len = (len > src->buf_size) ? src->buf_size : len;
+    window->buf        = src->buf;
+    window->addr       = start;
+    window->len        = len;
+    window->head_addr  = mgr->mem_tab.head_addr;
+    window->generation = mgr->sys_info.generation;
+    ROLLTS_FLASH_READ(mgr, start, window->buf, len);
+}
 
-            /* 如果已经超过所需范围，可以提前结束整个遍历(优化) */
-            if (current_number >= end_num) 
-            {
+/**
+ * @func: 合并读取：该实例游标前进一条并提取排序键
+ *        返回 false: 该实例已读完
+ */
+static bool merge_load(rollts_merge_t *merge, uint32_t index)
+{
+    rollts_merge_src_t *src = &merge->src[index];
+    rollts_manager_t   *mgr = src->mgr;
+    uint8_t  prefix[ROLLTS_MERGE_KEY_SIZE];
 #ifdef RTOS_MUTEX_ENABLE
-                rollts_manager->flash_ops.mutex_unlock();
+    mgr->flash_ops.mutex_lock();
 #endif
-                return true;
-            }
-
-            data_addr = tmp.next_addr;
+    merge_window_attach(src);
+    bool ret = cursor_step(mgr, &src->cursor, &src->info);
+    if (ret)
+    {
+        uint32_t len = (src->info.payload_len > sizeof(prefix)) ? sizeof(prefix) : src->info.payload_len;
+        int32_t  n   = record_read_handle(mgr, src->info.handle, 0, prefix, len);
+        uint64_t key = 0;
+        if (n >= 0 && merge->key(src->info.tag, prefix, (uint32_t)n, &key))
+        {
+            src->key = key;
         }
-
-        /* 跳到下一个 block(顺时针) */
-        block_addr = get_next_block(rollts_manager, block_addr);
     }
+    mgr->window = NULL;
 #ifdef RTOS_MUTEX_ENABLE
-    rollts_manager->flash_ops.mutex_unlock();
+    mgr->flash_ops.mutex_unlock();
 #endif
-    return found_any;
+    return ret;
 }
 
 /**
- * @brief 日志使用容量 百分比
+ * @func: 合并读取：读取该实例待输出日志的负载
+ *        返回 -1: 日志在两次读取之间已被回收
  */
-uint8_t rollts_capacity(rollts_manager_t *rollts_manager)
+static int32_t merge_read(rollts_merge_src_t *src, uint8_t *data, uint32_t max_payload_len)
 {
-
-    if (MAGIC_VALID != rollts_manager->is_init) 
-    {
-        return false;
-    }
+    rollts_manager_t *mgr = src->mgr;
+    int32_t ret = -1;
 #ifdef RTOS_MUTEX_ENABLE
-    rollts_manager->flash_ops.mutex_lock();
+    mgr->flash_ops.mutex_lock();
 #endif
-    uint8_t percent = 0;
-    uint32_t used_sectors = 0;
-    uint32_t block_addr = get_oldest_block(rollts_manager);
-
-    while (block_addr != rollts_manager->mem_tab.head_addr) 
+    merge_window_attach(src);
+    uint32_t handle     = src->info.handle;
+    uint32_t block_addr = handle - (handle - mgr->sys_info.data_start_addr) % mgr->sys_info.single_block_size;
+    /* 句柄所在 block 被回收后重新写入时序号变大，不能按地址读取 */
+    if (is_live_block(mgr, block_addr) && block_first_seq(mgr, block_addr) <= src->info.seq)
     {
-        if (block_addr == rollts_manager->mem_tab.pre_addr) 
-        {
-            if (rollts_manager->cur_block_data_num > 0) 
-            {
-                used_sectors++;
-            }
-
-        } 
-        else 
-        {
-            int32_t num = 0;
-            rollts_manager->flash_ops.read_data(block_addr + offsetof(block_info_t, data_num),
-                                                &num, sizeof(num));
-            if (num > 0) 
-            {
-                used_sectors++;
-            }
-        }
-        block_addr = get_next_block(rollts_manager, block_addr);
+        uint32_t len = (src->info.payload_len > max_payload_len) ? max_payload_len : src->info.payload_len;
+        ret = record_read_handle(mgr, handle, 0, data, len);
     }
-
-    uint32_t total = rollts_manager->sys_info.rollts_max_block_num - 3;
-    percent = total ? (used_sectors * 100 + total / 2) / total : 0;  // 四舍五入算法
+    mgr->window = NULL;
 #ifdef RTOS_MUTEX_ENABLE
-    rollts_manager->flash_ops.mutex_unlock();
+    mgr->flash_ops.mutex_unlock();
 #endif
-    return (100 - percent);
+    return ret;
 }
 
-
-uint32_t rollts_capacity_size(rollts_manager_t *rollts_manager)
+/**
+ * @func: 合并读取：堆中 a 是否先于 b 输出
+ */
+static bool merge_less(rollts_merge_t *merge, uint8_t a, uint8_t b)
 {
-    return (rollts_manager->sys_info.rollts_max_block_num * rollts_manager->sys_info.single_block_size - 1) /1024;
+    uint64_t key_a = merge->src[a].key;
+    uint64_t key_b = merge->src[b].key;
+    return key_a < key_b || (key_a == key_b && a < b);
 }
 
 /**
- * @func: 初始化 rollts
+ * @func: 合并读取：从 pos 向下调整小根堆
  */
-int rollts_init(rollts_manager_t *rollts_manager)
+static void merge_sift_down(rollts_merge_t *merge, uint32_t pos)
 {
-#ifdef RTOS_MUTEX_ENABLE
-    rollts_manager->flash_ops.mutex_lock();
-#endif
-    int ret = -1;
-    if(check_if_rollts_size_aligned())
+    while (true)
     {
-        if(check_if_sys_aligned(rollts_manager))
+        uint32_t least = pos;
+        uint32_t left  = 2 * pos + 1;
+        uint32_t right = 2 * pos + 2;
+        if (left < merge->heap_num && merge_less(merge, merge->heap[left], merge->heap[least]))
         {
-            ret = 0;
+            least = left;
         }
-        else
+        if (right < merge->heap_num && merge_less(merge, merge->heap[right], merge->heap[least]))
         {
-            rollts_manager_print(rollts_manager);
-            //重新初始化数据库
-            log_info(" rollTs invalid! reinit...");
-            rollts_manager_init(rollts_manager);
-            ret = rollts_format(rollts_manager);
+            least = right;
         }
+        if (least == pos)
+        {
+            return;
+        }
+        uint8_t tmp        = merge->heap[pos];
+        merge->heap[pos]   = merge->heap[least];
+        merge->heap[least] = tmp;
+        pos                = least;
     }
-    //打印 rollts_manager信息
-    rollts_manager_print(rollts_manager);
-    if(0 == rollts_mem_tab_init(rollts_manager))
-    {
-        rollts_manager->is_init = MAGIC_VALID;
-    }
-    memset(&rollts_manager->rollts_data,0,sizeof(rollts_data_t));
-    //初始化当前块数据数量
-    data_block_loop(rollts_manager);
-#ifdef RTOS_MUTEX_ENABLE
-    rollts_manager->flash_ops.mutex_unlock();
-#endif
-    return ret;
 }
 
 /**
- * @func: 清除所有日志数据
+ * @func: 按排序键合并读取多个实例
+ *        每个实例只保留一条待输出日志，内存占用为各实例预读缓冲之和；读取期间各实例仍可写入
  */
-bool rollts_clear(rollts_manager_t *rollts_manager)
+int32_t rollts_merge_read(rollts_merge_t *merge, uint8_t *data, uint32_t max_payload_len, rollTsMergecb cb)
 {
-#ifdef RTOS_MUTEX_ENABLE
-    rollts_manager->flash_ops.mutex_lock();
-#endif
-    int ret = -1;
-    rollts_manager_print(rollts_manager);
-    //重新初始化数据库
-    log_debug(" rollTs invalid! reinit...");
-    rollts_manager_init(rollts_manager);
-    ret = rollts_format(rollts_manager);
-    //打印 rollts_manager信息
-    rollts_manager_print(rollts_manager);
-    if(0 == rollts_mem_tab_init(rollts_manager))
+    if (NULL == merge->src || 0 == merge->src_num || merge->src_num > ROLLTS_MERGE_MAX || NULL == merge->key)
     {
-        rollts_manager->is_init = MAGIC_VALID;
+        return -1;
     }
-    memset(&rollts_manager->rollts_data,0,sizeof(rollts_data_t));
-    //初始化当前块数据数量
-    data_block_loop(rollts_manager);
-#ifdef RTOS_MUTEX_ENABLE
-    rollts_manager->flash_ops.mutex_unlock();
-#endif
-    return ret;
+    for (uint32_t i = 0; i < merge->src_num; i++)
+    {
+        if (MAGIC_VALID != merge->src[i].mgr->is_init)
+        {
+            return -1;
+        }
+    }
+
+    merge->heap_num = 0;
+    for (uint32_t i = 0; i < merge->src_num; i++)
+    {
+        rollts_merge_src_t *src = &merge->src[i];
+        rollts_cursor_init(&src->cursor);
+        memset(&src->window, 0, sizeof(rollts_window_t));
+        src->key = 0;
+        if (merge_load(merge, i))
+        {
+            merge->heap[merge->heap_num++] = (uint8_t)i;
+        }
+    }
+    for (uint32_t i = merge->heap_num / 2; i-- > 0;)
+    {
+        merge_sift_down(merge, i);
+    }
+
+    int32_t count = 0;
+    while (merge->heap_num > 0)
+    {
+        uint8_t             index = merge->heap[0];
+        rollts_merge_src_t *src   = &merge->src[index];
+        int32_t             len   = merge_read(src, data, max_payload_len);
+        if (len >= 0)
+        {
+            count++;
+            if (!cb(index, &src->info, data, (uint32_t)len))
+            {
+                break;
+            }
+        }
+        if (!merge_load(merge, index))
+        {
+            merge->heap[0] = merge->heap[--merge->heap_num];
+        }
+        merge_sift_down(merge, 0);
+    }
+    return count;
 }
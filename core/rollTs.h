@@ -65,6 +65,66 @@ extern "C" {
 
 // 最小编程粒度 -字节数
 #define MIN_WRITE_UNIT_SIZE     (1)
+
+// 条带化(rollStripe.c) 连续 block 数，block 号到器件号映射
+#define ROLLTS_STRIPE_UNIT      2
+#define ROLLTS_STRIPE_DEV(block, dev_num)     ((block) / ROLLTS_STRIPE_UNIT % (dev_num))
+/*---------------------------------------------------------------------------*/
+/*******************
+ * 配置项 Flash 访问 
+ *******************/
+
+// 静态 Flash 后端(可选)：编译 rollTs.c 前定义以下三个宏，Flash 访问直接调用后端函数，
+// 不经 flash_ops_t 函数指针，后端为同一编译单元可见的 inline 函数时可内联。
+// 宏对所有实例生效，冷存储层/复制目标位于其他器件时需按 mgr 区分；默认使用 flash_ops_t
+#ifndef ROLLTS_FLASH_ERASE
+#define ROLLTS_FLASH_ERASE(mgr, addr)                 ((mgr)->flash_ops.erase_sector(addr))
+#endif
+#ifndef ROLLTS_FLASH_WRITE
+#define ROLLTS_FLASH_WRITE(mgr, addr, data, len)      ((mgr)->flash_ops.write_data((addr), (data), (len)))
+#endif
+#ifndef ROLLTS_FLASH_READ
+#define ROLLTS_FLASH_READ(mgr, addr, data, len)       ((mgr)->flash_ops.read_data((addr), (data), (len)))
+#endif
+/*---------------------------------------------------------------------------*/
+/*******************
+ * 配置项 日志格式 
+ *******************/
+
+// 新写入 block 使用的日志格式(ROLLTS_FMT_V1 / ROLLTS_FMT_V2)
+#define ROLLTS_RECORD_FORMAT    ROLLTS_FMT_V2
+/*---------------------------------------------------------------------------*/
+/*******************
+ * 配置项 块尾偏移表 
+ *******************/
+
+// block 封顶时在块尾写入日志起始偏移表，块内按序号定位只需一次读取(1:启用 0:关闭)
+#define ROLLTS_FOOTER_ENABLE    1
+/*---------------------------------------------------------------------------*/
+/*******************
+ * 配置项 消费者 
+ *******************/
+
+// 持久化消费者数量
+#define ROLLTS_CONSUMER_MAX     4
+// 消费者名称最大长度(含结束符)
+#define ROLLTS_CONSUMER_NAME_LEN 12
+/*---------------------------------------------------------------------------*/
+/*******************
+ * 配置项 空闲维护 
+ *******************/
+
+// rollts_maintain 重建当前块聚合值的栈缓冲长度(未配置 agg_buf/汇总层 in_buf 时使用，有更长的日志时不重建)
+#define ROLLTS_MAINTAIN_BUF_SIZE 64
+/*---------------------------------------------------------------------------*/
+/*******************
+ * 配置项 合并读取
+ *******************/
+
+// 合并读取最多的实例数量
+#define ROLLTS_MERGE_MAX        8
+// 提取排序键时读取的负载长度(排序键回调只看到前缀)
+#define ROLLTS_MERGE_KEY_SIZE   16
 /*---------------------------------------------------------------------------*/
 /*******************
  * 自动配置
@@ -72,8 +132,29 @@ extern "C" {
 
 // 数据库BLOCK数量
 #define ROLLTS_MAX_BLOCK_NUM   (ROLLTS_MAX_SIZE/MIN_ERASE_UNIT_SIZE)
+
+#if ROLLTS_FOOTER_ENABLE && (SINGLE_BLOCK_SIZE > 0x10000)
+#error "ROLLTS_FOOTER_ENABLE requires SINGLE_BLOCK_SIZE <= 64KB (16-bit offsets)"
+#endif
 /* typedef-------------------------------------------------------------------*/
 #define ROLLDB_VERSION         "1.0.1"
+// 存储布局版本号(rollts_sys_t/block_info_t/rollts_data_t 结构变化时递增)
+#define ROLLTS_LAYOUT_VERSION  5
+
+// 记录标签数量(标签取值 0 ~ ROLLTS_TAG_NUM-1)
+#define ROLLTS_TAG_NUM         32
+#define ROLLTS_TAG_MASK(tag)   ((uint32_t)1 << (tag))
+#define ROLLTS_TAG_ALL         0xFFFFFFFF
+
+// 日志序号未写入
+#define ROLLTS_SEQ_NONE        0xFFFFFFFFFFFFFFFFull
+
+#define MAGIC_VALID       0x20251204 // 定义一个有效的魔数，用于验证系统分区的有效性
+#define MAGIC_DATA_VALID  0x20251205
+#define MAGIC_CONSUMER_VALID 0x20251206
+#define MAGIC_BURST_VALID 0x20251209
+#define MAGIC_FORMAT_VALID 0x2025120A
+#define MAGIC_SYS_BACKUP_VALID 0x2025120B
 
 /**
  * 系统分区结构体
@@ -92,13 +173,48 @@ typedef struct
     uint32_t           rollts_max_block_num;
     uint32_t                data_start_addr;
     uint32_t                  data_end_addr;
+    uint32_t                 layout_version;               // 存储布局版本
+    uint32_t                  record_format;               // 新 block 使用的日志格式(0xFFFFFFFF:v1 旧分区追加字段为擦除值，定长格式 bit[31:8] 为负载长度)
+    uint32_t                     generation;               // 数据分区代号(格式化/清除时递增，取值 0~0xFFFE，代号不一致的 block 视为已清除；旧分区为擦除值，与旧 block 的擦除值一致)
 } rollts_sys_t;
 #define SYSINFO_SIZE     sizeof(rollts_sys_t)
+
+/**
+ * 消费者位置日志
+ * 位于独立的消费者扇区(数据分区之后的最后一个 block)，追加写入，写满后只擦除该扇区并压缩为每个消费者一条
+ * 旧分区(数据分区延伸到最后一个 block)没有消费者扇区，记录追加在系统分区 rollts_sys_t 之后
+ * 先写名称与序号，最后写 magic 提交
+ * 系统分区 rollts_sys_t 之后同时追加日志格式更新记录：magic 为 MAGIC_FORMAT_VALID，seq 为新的 record_format，
+ * 系统分区只在格式化/清除与追加区写满压缩时擦除
+ */
+typedef struct
+{
+    char      name[ROLLTS_CONSUMER_NAME_LEN];
+    uint32_t                    magic_valid;              // MAGIC_CONSUMER_VALID:已提交
+    uint64_t                            seq;              // 下一条待处理日志序号
+} rollts_consumer_entry_t;
+#define ROLLTS_CONSUMER_AREA_ADDR  ((SYSINFO_SIZE + 15) / 16 * 16)
+
+/**
+ * 系统分区压缩备份
+ * 追加区写满时系统信息原样保留，追加区压缩为每个消费者一条(没有消费者扇区时)与日志格式记录；
+ * 擦除系统分区前新内容先写入 head_backup block 的空闲区(按 ROLLTS_SYS_BACKUP_SLOT 依次使用)，
+ * 先写长度与校验，再写内容，最后写 magic 提交；系统分区重写完成后 magic 清零
+ * 挂载时发现已提交的备份且系统分区与其不一致(压缩中掉电)，按备份重写系统分区
+ */
+typedef struct
+{
+    uint32_t                    magic_valid;              // MAGIC_SYS_BACKUP_VALID:已提交 0:已失效
+    uint32_t                            len;              // 系统分区内容长度
+    uint32_t                          check;              // 内容校验(crc_simple)
+} rollts_sys_backup_t;
+#define ROLLTS_SYS_BACKUP_MAX      (ROLLTS_CONSUMER_AREA_ADDR + (ROLLTS_CONSUMER_MAX + 1) * sizeof(rollts_consumer_entry_t))
+#define ROLLTS_SYS_BACKUP_SLOT     (sizeof(rollts_sys_backup_t) + ROLLTS_SYS_BACKUP_MAX)
 /**
  * 块区信息头
  * 
- * 位索引:   7   6    5    4    3    2    1    0
- * 内容:   is_head | reserved[5:0]
+ * 位索引:   7   6    5    4    3      2    1    0
+ * 内容:   is_head | format  | footer | reserved[2:0]
  */
 
 #define SET_HEAD(status)          status.is_head      = 0  // 00
@@ -110,10 +226,67 @@ typedef struct
 #define IS_BACKUP(status)       (status.is_head      == 1) // 01
 #define IS_NOT_HEAD(status)     (status.is_head      == 3) // 11
 
+/**
+ * 日志格式 block 成为写入块时写入 block_status bit[5:4]
+ * 旧版本写入的 block 该位为擦除值，按 v1 解析
+ */
+#define ROLLTS_FMT_V1             3  // 11: rollts_data_t 完整日志头
+#define ROLLTS_FMT_V2             2  // 10: 紧凑日志头
+#define ROLLTS_FMT_FIXED          1  // 01: 定长日志，只有 1 字节提交标记
+#define ROLLTS_FMT_V1_BASE        0  // 00: 初始版本 v1 日志头(无标签/分片)，只用于读取旧布局 block，不写入 Flash
+
+#define GET_BLOCK_FORMAT(status)       ((status.block_status >> 4) & 0x03)
+#define SET_BLOCK_FORMAT(status, fmt)  status.block_status = (status.block_status & 0x0F) | ((fmt) << 4)
+
+/**
+ * 块尾偏移表 block 封顶时写入，写完后清除 block_status bit[3]
+ * 块尾 data_num 个 uint16_t，按日志起始顺序记录相对 block 起始地址的偏移
+ * 写入时预留空间：每条日志起始占用 ROLLTS_FOOTER_ENTRY_SIZE 字节
+ */
+#define ROLLTS_FOOTER_ENTRY_SIZE       sizeof(uint16_t)
+#define ROLLTS_FOOTER_SIZE(num)        (ROLLTS_FOOTER_ENABLE ? (uint32_t)(num) * ROLLTS_FOOTER_ENTRY_SIZE : 0)
+
+#define HAS_BLOCK_FOOTER(status)       (0 == ((status.block_status >> 3) & 0x01))
+#define SET_BLOCK_FOOTER(status)       status.block_status = status.block_status & 0x37
+
+/**
+ * v2 紧凑日志头
+ * byte0   : 提交标记 0xFF 未提交 / ROLLTS_V2_COMMIT 已提交(负载写完后最后写入)
+ * byte1   : bit7 固定为 0(0xFF 表示空位)，bit[6:5] 分片标记，bit[4:0] 标签
+ * byte2.. : 负载长度 varint(每字节 7 位，低位在前，bit7 为续位)，1~3 字节
+ */
+#define ROLLTS_V2_COMMIT          0xA5
+#define ROLLTS_V2_HDR_MIN         3
+#define ROLLTS_V2_HDR_MAX         5
+
+/**
+ * 定长日志
+ * 日志按 [提交标记][负载] 紧密排列，第 k 条位于 block + sizeof(block_info_t) + k * (1 + 负载长度)
+ * 提交标记 0xFF 空位 / ROLLTS_FIXED_COMMIT | 标签(负载写完后最后写入)
+ * 写入中断的空位不复用，挂载时直接封顶该 block，因此 block 内不存在空洞
+ */
+#define ROLLTS_FIXED_COMMIT       0xA0
+#define ROLLTS_FIXED_COMMIT_MASK  0xE0
+#define ROLLTS_SYS_FIXED_FORMAT(size)  ((uint32_t)ROLLTS_FMT_FIXED | ((uint32_t)(size) << 8))
+
+/**
+ * 数值聚合结构体
+ */
+typedef struct
+{
+    uint32_t                          count;            // 0xFFFFFFFF:块内未存储聚合值
+    int32_t                             min;
+    int32_t                             max;
+    int64_t                             sum;
+} rollts_agg_t;
+
 typedef struct 
 {
     uint32_t                 last_data_addr;            // 0xFFFFFFFF:存储区未满 num:最后一个数据地址
     int32_t                        data_num;            // -1:未写满，不更新      num: 数据条数
+    uint32_t                     tag_bitmap;            // 0xFFFFFFFF:未封顶  bit n: 块内存在标签 n 的数据
+    rollts_agg_t                        agg;            // 封顶时写入的块内聚合值
+    uint64_t                      first_seq;            // 块内第一条日志序号(成为写入块时写入)
     uint32_t                    magic_valid;
 
     union 
@@ -125,8 +298,49 @@ typedef struct
         };
         uint8_t                status;
     };
+    uint16_t                     generation;            // 写入块头时的数据分区代号低 16 位(占用原填充字节，旧 block 为擦除值 0xFFFF)
 
 } block_info_t;
+// block 头中保存的数据分区代号
+#define ROLLTS_BLOCK_GENERATION(sys)  ((uint16_t)(sys).generation)
+
+/**
+ * 旧布局 block 头
+ * 旧版本固件写入的 block 升级后原地保留，按系统分区的布局版本逐块解析，不重新格式化；
+ * 回滚成为写入块的 block 按当前布局写入，新旧 block 在同一分区内并存，直到旧 block 全部回收或清除
+ * 各布局 last_data_addr/data_num 均位于偏移 0/4；字段偏移为 0 表示该布局没有此字段：
+ * 标签位图/聚合值按未封顶处理(查询时扫描该块)，first_seq 按日志条数推算，代号与系统分区一致
+ */
+typedef struct
+{
+    uint8_t                        hdr_size;            // block 头长度(日志区起始偏移，0:不支持的布局)
+    uint8_t                      tag_bitmap;
+    uint8_t                             agg;
+    uint8_t                       first_seq;
+    uint8_t                     magic_valid;
+    uint8_t                      generation;            // 32 位代号
+    uint8_t                          status;
+    uint8_t                      v1_base;               // 1: 日志头为初始版本 v1(ROLLTS_FMT_V1_BASE)
+    uint8_t                   count_walk;               // 1: data_num 不可靠(重新挂载后写入块首条日志未计数)，按链表统计
+} rollts_layout_t;
+
+// 按布局版本索引 layout 1: 初始版本(16 字节，日志头 20 字节)  layout 2: 日志头加入标签(24 字节)
+// layout 3: 加入标签位图(20 字节)  layout 4: 加入聚合值(48 字节)  layout 6: first_seq + 32 位代号(64 字节)
+#define ROLLTS_LEGACY_LAYOUTS                                       \
+{                                                                   \
+    {  0, 0,  0,  0,  0,  0,  0, 0, 0 },                            \
+    { 16, 0,  0,  0,  8,  0, 12, 1, 1 },                            \
+    { 16, 0,  0,  0,  8,  0, 12, 0, 1 },                            \
+    { 20, 8,  0,  0, 12,  0, 16, 0, 0 },                            \
+    { 48, 8, 16,  0, 40,  0, 44, 0, 0 },                            \
+    {  0, 0,  0,  0,  0,  0,  0, 0, 0 },                            \
+    { 64, 8, 16, 40, 48, 52, 56, 0, 0 },                            \
+}
+#define ROLLTS_LEGACY_LAYOUT_NUM      7
+// 初始版本系统分区没有 layout_version 字段(擦除值)，按 layout 1 解析
+#define ROLLTS_LAYOUT_BASE            1
+// 旧布局 block 头最大长度
+#define ROLLTS_LEGACY_HDR_MAX         64
 /**
  * 数据结构体
  */
@@ -138,7 +352,23 @@ typedef struct
     uint32_t                       cur_addr;            // 当前日志地址
     uint32_t                      next_addr;            // 下一个日志地址
     uint32_t                    payload_len;            // payload
+    uint8_t                             tag;            // 记录标签(类型/等级)
+    uint8_t                            frag;            // 分片标记
+    uint8_t                     reserved[2];
 } rollts_data_t;
+// 初始版本 v1 日志头长度(没有 tag/frag，解析时按标签 0、完整日志处理)
+#define ROLLTS_V1_BASE_HDR_LEN    offsetof(rollts_data_t, tag)
+
+/**
+ * 分片标记
+ * 超过单个 block 的日志按 FIRST/MIDDLE/LAST 分片，续片总是位于下一个 block 的第一条
+ */
+#define ROLLTS_FRAG_NONE          0  // 完整日志
+#define ROLLTS_FRAG_FIRST         1
+#define ROLLTS_FRAG_MIDDLE        2
+#define ROLLTS_FRAG_LAST          3
+
+#define IS_RECORD_START(data)   ((data).frag == ROLLTS_FRAG_NONE || (data).frag == ROLLTS_FRAG_FIRST)
 
 
 /* function-------------------------------------------------------------------*/
@@ -151,6 +381,7 @@ typedef struct
     void                                         (*mutex_lock)(void);
     void                                       (*mutex_unlock)(void);
 #endif
+    int      (*erase_range)(uint32_t address, uint32_t length);   // 可选：连续多 block 擦除(后端按 32/64KB 块擦除对齐部分)
 } flash_ops_t;
 
 typedef struct 
@@ -166,22 +397,251 @@ typedef struct
     uint32_t                              pre_addr;     // 用于数据库数据写入block地址
     uint32_t                             head_addr;     // 数据库起始地址
     uint32_t                      head_backup_addr;     // 数据库备份起始地址
+    uint32_t                             live_addr;     // 最旧有效 block(0:head_backup 的下一个)，之前为已清除待回收的 block
+    uint32_t                      stale_erased_num;     // head_backup 之后已提前擦除的已清除 block 数
 } rollts_memtab_t;
 
 
 
-typedef struct 
+// 聚合值提取回调 返回 true 表示该条日志参与聚合
+typedef bool (*rollTsExtract)(uint8_t tag, uint8_t *buf, uint32_t len, int32_t *value);
+
+/**
+ * 分散写入描述
+ */
+typedef struct
+{
+    uint8_t                               *data;
+    uint32_t                                len;
+} rollts_iovec_t;
+
+/**
+ * 流式写入状态
+ */
+typedef struct
+{
+    bool                                 active;
+    uint8_t                                 tag;
+    uint32_t                        payload_len;       // 日志总长
+    uint32_t                             offset;       // 已写入长度
+    uint32_t                          head_addr;       // 当前分片日志头地址
+    uint32_t                         write_addr;       // 当前分片负载写入地址
+    uint32_t                          frag_left;       // 当前分片剩余负载长度
+    uint32_t                        start_block;       // 日志起始 block
+    uint32_t                         start_addr;       // 日志起始(首片)日志头地址
+} rollts_append_t;
+
+/**
+ * 日志头信息(不含负载)
+ */
+typedef struct
+{
+    uint64_t                                seq;       // 日志序号(全局单调递增，回滚后不变)
+    uint32_t                             handle;       // 日志句柄(起始日志头地址)，用于 rollts_read_record
+    uint32_t                        payload_len;       // 负载总长(分片日志为各分片之和)
+    uint8_t                                 tag;
+    uint8_t                                frag;       // 起始分片标记(NONE/FIRST)
+} rollts_record_info_t;
+
+/**
+ * 日志遍历游标(从最旧到最新，只读取日志头)
+ * 所在 block 被回收后从最旧日志重新开始
+ */
+typedef struct
+{
+    uint32_t                         block_addr;       // 当前 block (0:未开始)
+    uint32_t                          data_addr;       // 下一条日志头地址
+    uint64_t                                seq;       // 下一条日志序号
+} rollts_cursor_t;
+
+/**
+ * 消费者位置(内存缓存)
+ */
+typedef struct
+{
+    bool                                   used;
+    char      name[ROLLTS_CONSUMER_NAME_LEN];
+    uint64_t                                seq;       // 下一条待处理日志序号
+} rollts_consumer_t;
+
+/**
+ * 汇总层配置
+ * block 被回收前将其日志压缩为汇总记录写入 target 实例
+ * begin/feed/end 为空时使用内置汇总：每个 block 生成一条 rollts_agg_t 记录(依赖 agg_extract)
+ * 汇总在触发回滚的写入中同步执行，写入失败不阻止回收，计入 failed 并输出告警
+ */
+typedef struct rollts_manager rollts_manager_t;
+
+/**
+ * 最新日志缓存条目
+ */
+typedef struct
+{
+    uint64_t                                seq;
+    uint32_t                             offset;       // 负载在 buf 中的起始位置(环形)
+    uint32_t                                len;
+    uint8_t                                 tag;
+} rollts_tail_entry_t;
+
+/**
+ * 最新日志缓存
+ * 写入时顺带缓存最近 entry_num 条、总长不超过 buf_size 的日志，
+ * 完全落在缓存窗口内的 rollts_read_since / rollts_read_pick 不读取 Flash
+ * 超过 buf_size 的日志不缓存并清空窗口，保证窗口内序号连续
+ */
+typedef struct
+{
+    rollts_tail_entry_t                  *entry;       // 条目数组(调用方提供)
+    uint32_t                          entry_num;
+    uint8_t                                *buf;       // 负载环形缓冲(调用方提供)
+    uint32_t                           buf_size;
+    // 以下由库维护
+    uint32_t                              first;       // 最旧条目下标
+    uint32_t                              count;       // 缓存条数
+    uint32_t                               head;       // buf 下一个写入位置
+    uint32_t                               used;       // 已缓存负载字节数
+    uint32_t                            pending;       // 写入中日志的起始位置
+    bool                               overflow;       // 写入中日志超过 buf_size
+    uint64_t                         oldest_seq;       // 最旧 block 第一条日志序号(rollts_read_pick 编号换算)
+    uint32_t                                hit;       // 命中次数
+    uint32_t                               miss;
+} rollts_tail_t;
+
+/**
+ * 日志复制
+ * 将 src 新增的日志复制到 dst，dst 日志序号与 src 保持一致，重启后按 dst 的下一个序号继续
+ * 已封顶的 v2/定长 block 整块拷贝，其余逐条流式复制
+ *
+ * 冷存储层复用该结构(rollts_manager_t.cold)：src 为热层实例(迁移时自动设置)，dst 为容量更大的冷层实例
+ * - rollts_maintain 空闲时把已封顶 block 预先迁移到冷层(可整块拷贝时整块拷贝)，冷层按自身环形空间回滚
+ * - 热层最旧 block 回收前只补迁移尚未迁移的部分；冷层不可用或复制中断时回收照常进行，未迁移的日志计入 lost
+ * - rollts_read_since / rollts_get_all / rollts_get_by_tag / 日志条数 先读冷层再读热层，序号连续
+ * - 冷层未初始化期间回收的日志无法迁移，冷层跳过这些序号(resync 计数)而不清除已有日志
+ */
+typedef struct
+{
+    rollts_manager_t                       *src;
+    rollts_manager_t                       *dst;       // 副本实例(需使用独立的互斥锁)
+    uint8_t                                *buf;       // 拷贝缓冲
+    uint32_t                           buf_size;
+    // 以下由库维护
+    uint32_t                       block_copied;       // 整块拷贝的 block 数
+    uint32_t                      record_copied;       // 逐条复制的日志数
+    uint32_t                             resync;       // 副本落后于 src 保留范围或序号超前时重新对齐的次数
+    uint32_t                               lost;       // 冷存储层：未迁移即被热层回收的日志数
+} rollts_replica_t;
+
+/**
+ * 掉电保持 RAM 前置缓冲头部(位于调用方提供区域的起始，其后为环形数据区)
+ * 区域放在热复位不清零的 RAM 段(如 .noinit)，头部校验通过时保留上次运行未写入 Flash 的条目
+ */
+typedef struct
+{
+    uint32_t                        magic_valid;       // MAGIC_BURST_VALID
+    uint32_t                               size;       // 数据区大小(4 字节对齐)
+    uint32_t                              check;       // magic_valid/size 校验
+    volatile uint32_t                      head;       // 最旧条目偏移(只由写入 Flash 一侧修改)
+    volatile uint32_t                      tail;       // 下一条目偏移(只由 rollts_burst_add 修改)
+    uint32_t                            dropped;       // 缓冲已满丢弃的条目数
+} rollts_burst_t;
+
+/**
+ * 前置缓冲条目 条目头+负载一次性写入 RAM，按 4 字节对齐
+ */
+typedef struct
+{
+    uint16_t                                len;       // 负载长度(ROLLTS_BURST_WRAP:回绕到数据区起始)
+    uint8_t                                 tag;
+    uint8_t                            reserved;
+    uint32_t                              check;       // 条目头(check 为 0)+负载校验
+} rollts_burst_entry_t;
+
+#define ROLLTS_BURST_WRAP           0xFFFF
+#define ROLLTS_BURST_ENTRY_SIZE(len) ((sizeof(rollts_burst_entry_t) + (len) + 3) / 4 * 4)
+
+/**
+ * 日志区预读窗口
+ * 缓存已封顶 block 的一段日志区，窗口内的日志头/负载读取不访问 Flash
+ * 只在持锁的合并读取步骤内挂到管理单元，回滚或清除后失效
+ */
+typedef struct
+{
+    uint8_t                                *buf;
+    uint32_t                               addr;       // 窗口起始地址
+    uint32_t                                len;       // 有效长度(0:空)
+    uint32_t                          head_addr;       // 填充时的 head 位置
+    uint32_t                         generation;       // 填充时的数据分区代号
+} rollts_window_t;
+
+/**
+ * 空闲维护状态
+ */
+typedef struct
+{
+    uint32_t                        footer_addr;       // 待补写偏移表的 block (0:无)
+    uint32_t                         scrub_addr;       // 下一个巡检 block (0:从最旧 block 开始)
+    uint32_t                        scrub_block;       // 已巡检 block 数
+    uint32_t                        scrub_error;       // 巡检发现的异常 block 数
+    bool                              agg_tried;       // 本次挂载已尝试重建当前块聚合值
+} rollts_maintain_t;
+
+typedef struct
+{
+    rollts_manager_t                    *target;       // 汇总记录写入实例(需使用独立的互斥锁)
+    uint8_t                                 tag;       // 汇总记录标签
+    uint8_t                             *in_buf;       // 读取被回收日志负载的缓冲
+    uint32_t                            in_size;
+    uint8_t                            *out_buf;       // 生成汇总记录的缓冲
+    uint32_t                           out_size;
+    void                            (*begin)(void);
+    // 返回需要立即写入的汇总记录长度(0:不写入)
+    uint32_t (*feed)(uint8_t tag, uint8_t *buf, uint32_t len, uint8_t *out, uint32_t out_max);
+    uint32_t                  (*end)(uint8_t *out, uint32_t out_max);
+    uint32_t                            max_out;       // 每个回收 block 最多写入的 feed 汇总记录数(0:不限制)，限制回滚中的写入量
+    // 以下由库维护
+    uint32_t                             failed;       // 写入 target 失败的汇总记录数
+    uint32_t                            skipped;       // 达到 max_out 后未汇总的日志数
+} rollts_rollup_t;
+
+struct rollts_manager
 { 
     uint32_t                        is_init;
     rollts_sys_t                   sys_info;           // 系统分区信息
     rollts_memtab_t                 mem_tab;           // 目录结构-工作区
     rollts_data_t               rollts_data;           // block 数据结构
     int32_t              cur_block_data_num;           // 当前块数据条数
+    uint32_t           cur_block_tag_bitmap;           // 当前块标签位图
+    rollts_agg_t              cur_block_agg;           // 当前块聚合值
+    bool                cur_block_agg_valid;           // 当前块聚合值是否完整(重启后未重建时为 false)
     uint32_t           last_valid_data_addr;           // 最后一个有效数据地址
     bool                 current_block_full;
 
     flash_ops_t                  flash_ops;
-} rollts_manager_t;
+    rollTsExtract              agg_extract;            // 聚合值提取回调(可选，init 前设置)
+    uint8_t                         *agg_buf;          // rollts_maintain 重建当前块聚合值的负载缓冲(可选，需容纳最长日志)
+    uint32_t                    agg_buf_size;
+    uint32_t               rollts_max_size;            // 实例数据库大小(可选，0:ROLLTS_MAX_SIZE)
+    rollts_rollup_t                *rollup;            // 汇总层(可选)
+    rollts_tail_t                    *tail;            // 最新日志缓存(可选，init 前设置)
+    rollts_replica_t                 *cold;            // 冷存储层(可选)：最旧 block 回收前迁移到 cold->dst
+    rollts_append_t                 append;            // 流式写入状态
+    uint8_t                  record_format;            // 新 block 日志格式(可选，0:ROLLTS_RECORD_FORMAT)，v1 分区挂载时逐块转换
+    uint16_t                    fixed_size;            // 定长日志负载长度(可选，非 0 时使用定长格式，写入长度必须一致)
+    bool                         read_only;            // 只读挂载(可选)：不格式化、不修复、不转换，写入接口返回 false
+    uint8_t               cur_block_format;            // 当前写入 block 的日志格式
+    uint64_t           cur_block_first_seq;            // 当前写入 block 第一条日志序号
+    rollts_consumer_t consumers[ROLLTS_CONSUMER_MAX];   // 消费者位置
+    uint32_t             consumer_log_addr;            // 消费者位置日志下一个空位
+    uint32_t                  sys_log_addr;            // 系统分区追加记录下一个空位
+    uint8_t                  legacy_layout;            // 系统分区的旧布局版本(0:当前布局)，该分区内可能存在按旧布局写入的 block
+    uint64_t                    legacy_seq;            // 最旧 block 为无 first_seq 的旧布局 block 时其第一条日志序号
+    uint32_t                 (*clock_us)(void);        // 微秒时钟(可选)：rollts_maintain 按预算计时，为空时每次只执行一步
+    bool                    maintain_defer;            // 封顶偏移表交给 rollts_maintain 补写(可选)
+    rollts_maintain_t             maintain;            // 空闲维护状态
+    rollts_window_t                *window;            // 预读窗口(库内部使用)
+    rollts_burst_t                  *burst;            // 掉电保持 RAM 前置缓冲(可选，init 前设置，4 字节对齐)
+    uint32_t                    burst_size;            // 前置缓冲区域大小(含头部)
+};
 
 typedef struct
 {
@@ -193,6 +653,51 @@ typedef struct
 // 日志数据接收回调
 typedef bool (*rollTscb)(uint8_t *buf,uint32_t len);
 
+// 日志头过滤回调(读取负载前调用) 返回 true 读取该条日志
+typedef bool (*rollTsFilter)(uint8_t tag, uint32_t payload_len);
+
+// 带序号的日志数据接收回调 返回 false 停止读取
+typedef bool (*rollTsSeqcb)(uint64_t seq, uint8_t *buf, uint32_t len);
+
+// rollts_read_since 返回值：请求的序号已被回滚，从最旧日志开始读取
+#define ROLLTS_SEQ_GAP         1
+
+// 排序键提取回调(buf 为负载前 ROLLTS_MERGE_KEY_SIZE 字节) 返回 false 时沿用同一实例上一条日志的键
+typedef bool (*rollTsKey)(uint8_t tag, uint8_t *buf, uint32_t len, uint64_t *key);
+
+// 合并读取接收回调 src 为实例下标 返回 false 停止读取
+typedef bool (*rollTsMergecb)(uint32_t src, const rollts_record_info_t *info, uint8_t *buf, uint32_t len);
+
+/**
+ * 合并读取源
+ * 每个实例一个游标，已封顶 block 按 buf_size 整段预读(不小于 SINGLE_BLOCK_SIZE 时每个 block 一次 Flash 读)
+ */
+typedef struct
+{
+    rollts_manager_t                       *mgr;
+    uint8_t                                *buf;       // 预读缓冲(调用方提供)
+    uint32_t                           buf_size;
+    // 以下由库维护
+    rollts_cursor_t                      cursor;
+    rollts_window_t                      window;
+    rollts_record_info_t                   info;       // 待输出的日志
+    uint64_t                                key;
+} rollts_merge_src_t;
+
+/**
+ * 多实例合并读取
+ * 各实例内按序号，实例间按排序键(如时间戳)从小到大输出，键相同时下标小的实例先输出
+ */
+typedef struct
+{
+    rollts_merge_src_t                     *src;
+    uint32_t                            src_num;       // 不超过 ROLLTS_MERGE_MAX
+    rollTsKey                               key;
+    // 以下由库维护
+    uint8_t             heap[ROLLTS_MERGE_MAX];        // 按 (key, 实例下标) 排列的小根堆
+    uint32_t                           heap_num;
+} rollts_merge_t;
+
 /**
  * @func: 数据库初始化
  */
@@ -200,14 +705,75 @@ extern int rollts_init(rollts_manager_t *rollts_manager);
 
 /**
  * @func: 清除所有日志数据
+ *        递增数据分区代号，只擦除写入块/head/backup，其余 block 回滚时擦除
  */
 extern bool rollts_clear(rollts_manager_t *rollts_manager);
 
+/**
+ * @func: 空闲时提前擦除已清除的 block(最多 max_blocks 个)，返回擦除的 block 数
+ *        已提前擦除的 block 回滚时不再擦除
+ */
+extern int32_t rollts_erase_stale(rollts_manager_t *rollts_manager, uint32_t max_blocks);
+
+/**
+ * @func: 空闲维护(在空闲任务中调用)，预算 budget_us 微秒内逐步执行，返回执行的步数(0:本轮无待处理工作或 budget_us 为 0)
+ *        补写偏移表、提前切换已满写入块、重建当前块聚合值、预迁移冷存储层、提前擦除已清除 block、巡检 block
+ */
+extern int32_t rollts_maintain(rollts_manager_t *rollts_manager, uint32_t budget_us);
+
+/**
+ * @func: 复制 src 新增日志到 dst(最多 max_records 条)，返回复制的日志数，-1:失败
+ */
+extern int32_t rollts_replicate(rollts_replica_t *replica, uint32_t max_records);
+
+/**
+ * @func: 副本落后的日志条数
+ */
+extern int64_t rollts_replica_lag(rollts_replica_t *replica);
+
+/**
+ * @func: 按排序键合并读取多个实例的全部日志，返回输出的日志数，-1:失败
+ */
+extern int32_t rollts_merge_read(rollts_merge_t *merge, uint8_t *data, uint32_t max_payload_len, rollTsMergecb cb);
+
+/**
+ * @brief 前置缓冲写入 只写 RAM，不获取互斥锁、不访问 Flash(回滚擦除进行中也不阻塞)
+ *        单生产者：多个任务写入时由调用方串行化；缓冲已满返回 false
+ *        热复位后 rollts_init 之前也可写入；条目在 rollts_init / rollts_maintain / 下一次写入时按序写入 Flash
+ */
+extern bool rollts_burst_add(rollts_manager_t *rollts_manager, uint8_t tag, const uint8_t *data, uint32_t len);
+
+/**
+ * @func: 前置缓冲条目写入 Flash 返回写入的条目数
+ */
+extern int32_t rollts_burst_flush(rollts_manager_t *rollts_manager);
+
 /**
  * @func: 数据库添加数据
  */
 extern bool rollts_add(rollts_manager_t *rollts_manager, uint8_t *data, uint32_t payload_len);
 
+/**
+ * @func: 数据库添加带标签的数据
+ */
+extern bool rollts_add_tag(rollts_manager_t *rollts_manager, uint8_t tag, uint8_t *data, uint32_t payload_len);
+
+/**
+ * @func: 分散写入一条日志(无需调用方拼接连续缓冲)
+ */
+extern bool rollts_addv(rollts_manager_t *rollts_manager, uint8_t tag,
+                        const rollts_iovec_t *iov, uint32_t iov_cnt);
+
+/**
+ * @func: 流式写入 开始/追加/提交
+ *        负载直接写入 Flash，提交时最后写入 magic，未提交的日志掉电后不可见
+ *        流式写入期间其他写入接口返回 false
+ */
+extern bool rollts_append_begin(rollts_manager_t *rollts_manager, uint8_t tag, uint32_t payload_len);
+extern bool rollts_append_chunk(rollts_manager_t *rollts_manager, uint8_t *data, uint32_t len);
+extern bool rollts_append_commit(rollts_manager_t *rollts_manager);
+extern void rollts_append_abort(rollts_manager_t *rollts_manager);
+
 /**
  * @brief 日志整体读取
  * 
@@ -215,6 +781,52 @@ extern bool rollts_add(rollts_manager_t *rollts_manager, uint8_t *data, uint32_t
 extern bool rollts_get_all(rollts_manager_t *rollts_manager, 
                            uint8_t *data, uint32_t max_payload_len,rollTscb cb);
 
+/**
+ * @brief 按标签过滤读取
+ *        标签掩码与过滤回调在读取负载前判断，不匹配的日志不读取负载
+ */
+extern bool rollts_get_by_tag(rollts_manager_t *rollts_manager, uint32_t tag_mask, rollTsFilter filter,
+                              uint8_t *data, uint32_t max_payload_len, rollTscb cb);
+
+/**
+ * @brief 日志游标 只读取日志头(句柄/长度/标签)，不读取负载
+ *        rollts_cursor_next 无更多日志时返回 false，游标停在写入位置，之后新写入的日志可继续读取
+ */
+extern void rollts_cursor_init(rollts_cursor_t *cursor);
+extern bool rollts_cursor_next(rollts_manager_t *rollts_manager, rollts_cursor_t *cursor,
+                               rollts_record_info_t *info);
+
+/**
+ * @brief 按句柄读取日志负载 [offset, offset + len)
+ *        返回实际拷贝长度，句柄无效(日志已被回收)或分片不完整时返回 -1
+ */
+extern int32_t rollts_read_record(rollts_manager_t *rollts_manager, uint32_t handle,
+                                  uint32_t offset, uint8_t *data, uint32_t len);
+
+/**
+ * @brief 按序号增量读取 读取序号 >= seq 的日志
+ *        按 block 头 first_seq 二分定位，返回 0 成功，ROLLTS_SEQ_GAP 请求的日志已被回滚(从最旧日志开始)，-1 失败
+ */
+extern int32_t rollts_read_since(rollts_manager_t *rollts_manager, uint64_t seq,
+                                 uint8_t *data, uint32_t max_payload_len, rollTsSeqcb cb);
+
+/**
+ * @brief 下一条写入日志的序号
+ */
+extern uint64_t rollts_next_seq(rollts_manager_t *rollts_manager);
+
+/**
+ * @brief 消费者位置 提交/查询/积压/读取
+ *        seq 为下一条待处理日志序号(已处理日志序号 + 1)，重启后保持
+ *        rollts_consumer_lag 返回未处理日志条数(含已被回滚的)，未知消费者返回 -1
+ *        rollts_consumer_read 从消费者位置读取新日志，返回值同 rollts_read_since，处理完成后调用方提交
+ */
+extern bool rollts_consumer_commit(rollts_manager_t *rollts_manager, const char *name, uint64_t seq);
+extern bool rollts_consumer_get(rollts_manager_t *rollts_manager, const char *name, uint64_t *seq);
+extern int64_t rollts_consumer_lag(rollts_manager_t *rollts_manager, const char *name);
+extern int32_t rollts_consumer_read(rollts_manager_t *rollts_manager, const char *name,
+                                    uint8_t *data, uint32_t max_payload_len, rollTsSeqcb cb);
+
 /**
  * @brief 日志条数读取
  */
@@ -228,6 +840,14 @@ extern bool rollts_read_pick(rollts_manager_t *rollts_manager,
                              uint32_t start_num, uint32_t end_num,
                              uint8_t *data, uint32_t max_payload_len,rollTscb cb);
 
+/**
+ * @brief 日志聚合查询 编号范围同 rollts_read_pick
+ *        完整覆盖的 block 直接合并封顶时写入的聚合值，仅扫描边缘 block
+ */
+extern bool rollts_aggregate(rollts_manager_t *rollts_manager,
+                             uint32_t start_num, uint32_t end_num,
+                             uint8_t *data, uint32_t max_payload_len, rollts_agg_t *agg);
+
 /**
  * @brief 日志剩余容量 百分比
  */
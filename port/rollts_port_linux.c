@@ -0,0 +1,584 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE                 // O_DIRECT
+#endif
+#include "rollts_port_linux.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * 后端实例
+ */
+typedef struct
+{
+    bool                             in_use;
+    int                                  fd;
+    rollts_linux_cfg_t                  cfg;
+    uint8_t                            *map;               // MMAP 映射基址(已加 offset 页内偏移)
+    uint8_t                        *map_base;              // MMAP 映射起始(页对齐)
+    size_t                         map_len;
+    uint8_t                         *bounce;               // DIRECT 对齐缓冲
+    uint64_t                     bounce_off;               // 对齐缓冲中的数据区间(所有写入经过缓冲，内容与设备一致)
+    uint64_t                     bounce_end;
+    pthread_mutex_t                   mutex;
+    uint64_t                         io_cnt;               // 写入/擦除次数(PERIODIC)
+    uint64_t                       sync_cnt;               // 上次落盘完成时的 io_cnt
+    bool                           sync_run;               // 周期落盘线程运行中
+    pthread_t                   sync_thread;
+    pthread_mutex_t              sync_mutex;               // 保护 io_cnt/sync_cnt/sync_run
+    pthread_cond_t                sync_cond;
+} rollts_port_t;
+
+// DIRECT 单次读写最大长度
+#define PORT_BOUNCE_SIZE        ((MIN_ERASE_UNIT_SIZE + ROLLTS_LINUX_DIRECT_ALIGN - 1) / ROLLTS_LINUX_DIRECT_ALIGN * ROLLTS_LINUX_DIRECT_ALIGN)
+// 擦除/扩展文件时的 0xFF 填充长度
+#define PORT_FILL_SIZE          4096
+
+static rollts_port_t port_tab[ROLLTS_LINUX_PORT_MAX];
+static pthread_mutex_t port_tab_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint8_t port_fill[PORT_FILL_SIZE];
+
+/* function-------------------------------------------------------------------*/
+
+/**
+ * @func: 完整读写(处理短读写与 EINTR)
+ */
+static int port_pread_full(int fd, void *data, size_t len, uint64_t off)
+{
+    uint8_t *p = (uint8_t *)data;
+    while (len > 0)
+    {
+        ssize_t n = pread(fd, p, len, (off_t)off);
+        if (n < 0 && EINTR == errno)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return -1;
+        }
+        p   += n;
+        off += (uint64_t)n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static int port_pwrite_full(int fd, const void *data, size_t len, uint64_t off)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    while (len > 0)
+    {
+        ssize_t n = pwrite(fd, p, len, (off_t)off);
+        if (n < 0 && EINTR == errno)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return -1;
+        }
+        p   += n;
+        off += (uint64_t)n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+/**
+ * @func: 落盘 MMAP 模式 len 为 0 时同步整个映射
+ */
+static int port_sync_range(rollts_port_t *port, uint32_t address, uint32_t length)
+{
+    int ret;
+    uint64_t io_cnt;
+    pthread_mutex_lock(&port->sync_mutex);
+    io_cnt = port->io_cnt;
+    pthread_mutex_unlock(&port->sync_mutex);
+    if (ROLLTS_LINUX_IO_MMAP == port->cfg.io)
+    {
+        uint8_t *start = port->map_base;
+        size_t len     = port->map_len;
+        if (length)
+        {
+            size_t page = (size_t)sysconf(_SC_PAGESIZE);
+            uintptr_t s = (uintptr_t)(port->map + address) & ~(uintptr_t)(page - 1);
+            uintptr_t e = (uintptr_t)(port->map + address + length);
+            start = (uint8_t *)s;
+            len   = e - s;
+        }
+        ret = msync(start, len, MS_SYNC);
+    }
+    else
+    {
+        ret = fdatasync(port->fd);
+    }
+    if (0 == ret && 0 == length)
+    {
+        // 落盘期间的写入留给下一周期
+        pthread_mutex_lock(&port->sync_mutex);
+        port->sync_cnt = io_cnt;
+        pthread_mutex_unlock(&port->sync_mutex);
+    }
+    return ret ? -1 : 0;
+}
+
+/**
+ * @func: 按落盘策略在写入/擦除后落盘
+ */
+static int port_after_io(rollts_port_t *port, bool is_erase, uint32_t address, uint32_t length)
+{
+    switch (port->cfg.sync)
+    {
+    case ROLLTS_LINUX_SYNC_WRITE:
+        return is_erase ? 0 : port_sync_range(port, address, length);
+    case ROLLTS_LINUX_SYNC_ERASE:
+        return is_erase ? port_sync_range(port, 0, 0) : 0;
+    case ROLLTS_LINUX_SYNC_PERIODIC:
+        // 由周期落盘线程落盘，写入不阻塞
+        pthread_mutex_lock(&port->sync_mutex);
+        port->io_cnt++;
+        pthread_mutex_unlock(&port->sync_mutex);
+        return 0;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @func: DIRECT 模式读写 对齐区间整体覆盖或已在缓冲中时不回读，否则读-改-写
+ *        data 为 NULL 时以 0xFF 填充(擦除)
+ */
+static int port_direct_io(rollts_port_t *port, uint32_t address, uint8_t *data, uint32_t length, bool is_write)
+{
+    uint64_t pos = port->cfg.offset + address;
+    uint64_t end = pos + length;
+    while (pos < end)
+    {
+        uint64_t cs  = pos / ROLLTS_LINUX_DIRECT_ALIGN * ROLLTS_LINUX_DIRECT_ALIGN;
+        uint64_t ce  = cs + PORT_BOUNCE_SIZE;
+        uint32_t len;
+        if (ce > end)
+        {
+            ce = (end + ROLLTS_LINUX_DIRECT_ALIGN - 1) / ROLLTS_LINUX_DIRECT_ALIGN * ROLLTS_LINUX_DIRECT_ALIGN;
+        }
+        len = (uint32_t)((ce < end ? ce : end) - pos);
+        if ((port->bounce_off != cs || port->bounce_end != ce)
+            && (!is_write || pos != cs || pos + len != ce))
+        {
+            port->bounce_end = 0;
+            if (port_pread_full(port->fd, port->bounce, (size_t)(ce - cs), cs))
+            {
+                return -1;
+            }
+        }
+        port->bounce_off = cs;
+        port->bounce_end = ce;
+        if (is_write)
+        {
+            if (data)
+            {
+                memcpy(port->bounce + (pos - cs), data, len);
+            }
+            else
+            {
+                memset(port->bounce + (pos - cs), 0xFF, len);
+            }
+            if (port_pwrite_full(port->fd, port->bounce, (size_t)(ce - cs), cs))
+            {
+                port->bounce_end = 0;
+                return -1;
+            }
+        }
+        else
+        {
+            memcpy(data, port->bounce + (pos - cs), len);
+        }
+        if (data)
+        {
+            data += len;
+        }
+        pos += len;
+    }
+    return 0;
+}
+
+/**
+ * @func: 擦除 以 0xFF 覆盖一个擦除单元
+ */
+static int port_erase(rollts_port_t *port, uint32_t address)
+{
+    uint32_t done;
+    if (address % MIN_ERASE_UNIT_SIZE || (uint64_t)address + MIN_ERASE_UNIT_SIZE > port->cfg.size)
+    {
+        return -1;
+    }
+    switch (port->cfg.io)
+    {
+    case ROLLTS_LINUX_IO_MMAP:
+        memset(port->map + address, 0xFF, MIN_ERASE_UNIT_SIZE);
+        break;
+    case ROLLTS_LINUX_IO_DIRECT:
+        if (port_direct_io(port, address, NULL, MIN_ERASE_UNIT_SIZE, true))
+        {
+            return -1;
+        }
+        break;
+    default:
+        for (done = 0; done < MIN_ERASE_UNIT_SIZE; done += PORT_FILL_SIZE)
+        {
+            uint32_t len = MIN_ERASE_UNIT_SIZE - done < PORT_FILL_SIZE ? MIN_ERASE_UNIT_SIZE - done : PORT_FILL_SIZE;
+            if (port_pwrite_full(port->fd, port_fill, len, port->cfg.offset + address + done))
+            {
+                return -1;
+            }
+        }
+        break;
+    }
+    return port_after_io(port, true, address, MIN_ERASE_UNIT_SIZE);
+}
+
+/**
+ * @func: 写入
+ */
+static int port_write(rollts_port_t *port, uint32_t address, void *data, uint32_t length)
+{
+    if ((uint64_t)address + length > port->cfg.size)
+    {
+        return -1;
+    }
+    switch (port->cfg.io)
+    {
+    case ROLLTS_LINUX_IO_MMAP:
+        memcpy(port->map + address, data, length);
+        break;
+    case ROLLTS_LINUX_IO_DIRECT:
+        if (port_direct_io(port, address, (uint8_t *)data, length, true))
+        {
+            return -1;
+        }
+        break;
+    default:
+        if (port_pwrite_full(port->fd, data, length, port->cfg.offset + address))
+        {
+            return -1;
+        }
+        break;
+    }
+    return port_after_io(port, false, address, length);
+}
+
+/**
+ * @func: 读取
+ */
+static int port_read(rollts_port_t *port, uint32_t address, void *data, uint32_t length)
+{
+    if ((uint64_t)address + length > port->cfg.size)
+    {
+        return -1;
+    }
+    switch (port->cfg.io)
+    {
+    case ROLLTS_LINUX_IO_MMAP:
+        memcpy(data, port->map + address, length);
+        return 0;
+    case ROLLTS_LINUX_IO_DIRECT:
+        return port_direct_io(port, address, (uint8_t *)data, length, false);
+    default:
+        return port_pread_full(port->fd, data, length, port->cfg.offset + address);
+    }
+}
+
+/**
+ * 每个实例一组静态入口，绑定到 flash_ops_t
+ */
+#define PORT_ENTRY(n)                                                                                   \
+static int  port_erase_##n(uint32_t a)                  { return port_erase(&port_tab[n], a); }        \
+static int  port_write_##n(uint32_t a, void *d, uint32_t l) { return port_write(&port_tab[n], a, d, l); } \
+static int  port_read_##n(uint32_t a, void *d, uint32_t l)  { return port_read(&port_tab[n], a, d, l); }  \
+static void port_lock_##n(void)                         { pthread_mutex_lock(&port_tab[n].mutex); }    \
+static void port_unlock_##n(void)                       { pthread_mutex_unlock(&port_tab[n].mutex); }
+
+PORT_ENTRY(0)
+PORT_ENTRY(1)
+PORT_ENTRY(2)
+PORT_ENTRY(3)
+
+#if ROLLTS_LINUX_PORT_MAX != 4
+#error "ROLLTS_LINUX_PORT_MAX changed: update PORT_ENTRY list and port_entry_tab"
+#endif
+
+typedef struct
+{
+    int  (*erase_sector)(uint32_t address);
+    int  (*write_data)(uint32_t address, void *data, uint32_t length);
+    int  (*read_data)(uint32_t address, void *data, uint32_t length);
+    void (*mutex_lock)(void);
+    void (*mutex_unlock)(void);
+} port_entry_t;
+
+#define PORT_ENTRY_REF(n) { port_erase_##n, port_write_##n, port_read_##n, port_lock_##n, port_unlock_##n }
+
+static const port_entry_t port_entry_tab[ROLLTS_LINUX_PORT_MAX] =
+{
+    PORT_ENTRY_REF(0), PORT_ENTRY_REF(1), PORT_ENTRY_REF(2), PORT_ENTRY_REF(3),
+};
+
+/**
+ * @func: 周期落盘线程 每 sync_period_ms 检查一次，期间有写入/擦除则落盘
+ *        最后一次写入之后的数据最迟一个周期后落盘
+ */
+static void *port_sync_main(void *arg)
+{
+    rollts_port_t *port = (rollts_port_t *)arg;
+    struct timespec ts;
+    pthread_mutex_lock(&port->sync_mutex);
+    while (port->sync_run)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        ts.tv_sec  += port->cfg.sync_period_ms / 1000;
+        ts.tv_nsec += (long)(port->cfg.sync_period_ms % 1000) * 1000000;
+        if (ts.tv_nsec >= 1000000000)
+        {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000;
+        }
+        while (port->sync_run && ETIMEDOUT != pthread_cond_timedwait(&port->sync_cond, &port->sync_mutex, &ts))
+        {
+        }
+        if (port->sync_run && port->io_cnt != port->sync_cnt)
+        {
+            pthread_mutex_unlock(&port->sync_mutex);
+            port_sync_range(port, 0, 0);
+            pthread_mutex_lock(&port->sync_mutex);
+        }
+    }
+    pthread_mutex_unlock(&port->sync_mutex);
+    return NULL;
+}
+
+/**
+ * @func: 启动周期落盘线程
+ */
+static int port_sync_start(rollts_port_t *port)
+{
+    pthread_condattr_t attr;
+    int ret;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&port->sync_cond, &attr);
+    pthread_condattr_destroy(&attr);
+    port->sync_run = true;
+    ret = pthread_create(&port->sync_thread, NULL, port_sync_main, port);
+    if (ret)
+    {
+        port->sync_run = false;
+        pthread_cond_destroy(&port->sync_cond);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @func: 停止周期落盘线程
+ */
+static void port_sync_stop(rollts_port_t *port)
+{
+    if (!port->sync_run)
+    {
+        return;
+    }
+    pthread_mutex_lock(&port->sync_mutex);
+    port->sync_run = false;
+    pthread_cond_signal(&port->sync_cond);
+    pthread_mutex_unlock(&port->sync_mutex);
+    pthread_join(port->sync_thread, NULL);
+    pthread_cond_destroy(&port->sync_cond);
+}
+
+/**
+ * @func: 确保文件/设备覆盖 offset+size 普通文件不足时以 0xFF 扩展
+ */
+static int port_prepare_file(rollts_port_t *port)
+{
+    struct stat st;
+    uint64_t need = port->cfg.offset + port->cfg.size;
+    uint64_t cur;
+    if (fstat(port->fd, &st))
+    {
+        return -1;
+    }
+    if (!S_ISREG(st.st_mode))
+    {
+        off_t dev_size = lseek(port->fd, 0, SEEK_END);
+        return (dev_size < 0 || (uint64_t)dev_size < need) ? -1 : 0;
+    }
+    for (cur = (uint64_t)st.st_size; cur < need; )
+    {
+        size_t len = need - cur < PORT_FILL_SIZE ? (size_t)(need - cur) : PORT_FILL_SIZE;
+        if (port_pwrite_full(port->fd, port_fill, len, cur))
+        {
+            return -1;
+        }
+        cur += len;
+    }
+    return 0;
+}
+
+/**
+ * @func: 释放实例资源
+ */
+static void port_release(rollts_port_t *port)
+{
+    port_sync_stop(port);
+    if (port->map_base)
+    {
+        munmap(port->map_base, port->map_len);
+    }
+    free(port->bounce);
+    if (port->fd >= 0)
+    {
+        close(port->fd);
+    }
+    pthread_mutex_destroy(&port->mutex);
+    pthread_mutex_destroy(&port->sync_mutex);
+    memset(port, 0, sizeof(*port));
+}
+
+/**
+ * @func: 打开后端并填充 flash_ops
+ */
+int rollts_port_linux_open(const rollts_linux_cfg_t *cfg, flash_ops_t *flash_ops)
+{
+    rollts_port_t *port = NULL;
+    int id;
+    int ret = -1;
+
+    if (NULL == cfg || NULL == cfg->path || NULL == flash_ops
+        || 0 == cfg->size || cfg->size % MIN_ERASE_UNIT_SIZE)
+    {
+        return -1;
+    }
+    if (ROLLTS_LINUX_IO_DIRECT == cfg->io && cfg->offset % ROLLTS_LINUX_DIRECT_ALIGN)
+    {
+        return -1;
+    }
+    if (ROLLTS_LINUX_SYNC_PERIODIC == cfg->sync && 0 == cfg->sync_period_ms)
+    {
+        return -1;
+    }
+
+    pthread_mutex_lock(&port_tab_mutex);
+    memset(port_fill, 0xFF, sizeof(port_fill));
+    for (id = 0; id < ROLLTS_LINUX_PORT_MAX; id++)
+    {
+        if (!port_tab[id].in_use)
+        {
+            port = &port_tab[id];
+            break;
+        }
+    }
+    if (NULL == port)
+    {
+        goto out;
+    }
+    memset(port, 0, sizeof(*port));
+    port->in_use = true;
+    port->cfg    = *cfg;
+    pthread_mutex_init(&port->mutex, NULL);
+    pthread_mutex_init(&port->sync_mutex, NULL);
+
+    port->fd = open(cfg->path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (port->fd < 0 || port_prepare_file(port))
+    {
+        goto fail;
+    }
+
+    if (ROLLTS_LINUX_IO_DIRECT == cfg->io)
+    {
+        // 填充/扩展完成后重新以 O_DIRECT 打开
+        int fd = open(cfg->path, O_RDWR | O_DIRECT | O_CLOEXEC);
+        if (fd < 0 || posix_memalign((void **)&port->bounce, ROLLTS_LINUX_DIRECT_ALIGN, PORT_BOUNCE_SIZE))
+        {
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+            port->bounce = NULL;
+            goto fail;
+        }
+        close(port->fd);
+        port->fd = fd;
+    }
+    else if (ROLLTS_LINUX_IO_MMAP == cfg->io)
+    {
+        uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+        uint64_t base = cfg->offset / page * page;
+        void *map;
+        port->map_len = (size_t)(cfg->offset - base + cfg->size);
+        map = mmap(NULL, port->map_len, PROT_READ | PROT_WRITE, MAP_SHARED, port->fd, (off_t)base);
+        if (MAP_FAILED == map)
+        {
+            goto fail;
+        }
+        port->map_base = (uint8_t *)map;
+        port->map      = port->map_base + (cfg->offset - base);
+    }
+
+    if (ROLLTS_LINUX_SYNC_PERIODIC == cfg->sync && port_sync_start(port))
+    {
+        goto fail;
+    }
+    flash_ops->erase_sector = port_entry_tab[id].erase_sector;
+    flash_ops->write_data   = port_entry_tab[id].write_data;
+    flash_ops->read_data    = port_entry_tab[id].read_data;
+#ifdef RTOS_MUTEX_ENABLE
+    flash_ops->mutex_lock   = port_entry_tab[id].mutex_lock;
+    flash_ops->mutex_unlock = port_entry_tab[id].mutex_unlock;
+#endif
+    ret = id;
+    goto out;
+
+fail:
+    port_release(port);
+out:
+    pthread_mutex_unlock(&port_tab_mutex);
+    return ret;
+}
+
+/**
+ * @func: 落盘
+ */
+int rollts_port_linux_sync(int port)
+{
+    int ret;
+    if (port < 0 || port >= ROLLTS_LINUX_PORT_MAX || !port_tab[port].in_use)
+    {
+        return -1;
+    }
+    pthread_mutex_lock(&port_tab[port].mutex);
+    ret = port_sync_range(&port_tab[port], 0, 0);
+    pthread_mutex_unlock(&port_tab[port].mutex);
+    return ret;
+}
+
+/**
+ * @func: 落盘并关闭后端
+ */
+void rollts_port_linux_close(int port)
+{
+    if (port < 0 || port >= ROLLTS_LINUX_PORT_MAX || !port_tab[port].in_use)
+    {
+        return;
+    }
+    pthread_mutex_lock(&port_tab_mutex);
+    port_sync_stop(&port_tab[port]);
+    port_sync_range(&port_tab[port], 0, 0);
+    port_release(&port_tab[port]);
+    pthread_mutex_unlock(&port_tab_mutex);
+}
@@ -0,0 +1,111 @@
+/**
+  ******************************************************************************
+  * @file           : rollts_port_linux.h
+  * @brief          : rollTs Linux 文件/块设备后端
+  *
+  * 将 erase_sector/write_data/read_data 映射到普通文件或裸块设备(/dev/mmcblk0p3 等)：
+  * - ROLLTS_LINUX_IO_PREAD ：pread/pwrite，走页缓存
+  * - ROLLTS_LINUX_IO_DIRECT：O_DIRECT，按页对齐的缓冲区读-改-写，绕过页缓存
+  * - ROLLTS_LINUX_IO_MMAP  ：mmap 共享映射，memcpy 读写，msync 落盘
+  *
+  * 擦除以 0xFF 覆盖整个擦除单元，写入直接覆盖(块设备无 NOR 的位与语义，
+  * rollTs 只写入擦除态区域，两者结果一致)。
+  *
+  * 落盘策略：
+  * - ROLLTS_LINUX_SYNC_NONE    ：不主动落盘，由内核回写
+  * - ROLLTS_LINUX_SYNC_WRITE   ：每次写入后落盘(日志提交字节最后写入，等效逐条落盘)
+  * - ROLLTS_LINUX_SYNC_ERASE   ：擦除时落盘(block 封顶后切换 block 时触发)
+  * - ROLLTS_LINUX_SYNC_PERIODIC：后台线程每 sync_period_ms 检查一次，期间有写入/擦除则落盘，
+  *                               写入不阻塞，最后一次写入最迟一个周期后落盘
+  * 任意策略下均可调用 rollts_port_linux_sync 手动落盘。
+  *
+  * 使用示例：
+  *   rollts_linux_cfg_t cfg = { "/data/rollts.img", 0, ROLLTS_MAX_SIZE,
+  *                              ROLLTS_LINUX_IO_PREAD, ROLLTS_LINUX_SYNC_ERASE, 0 };
+  *   int port = rollts_port_linux_open(&cfg, &mgr.flash_ops);
+  *   rollts_init(&mgr);
+  *   ...
+  *   rollts_port_linux_close(port);
+  *
+  * @version        : 1.0.2
+  * @date           : 2025-12-10
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2025 ARSTUDIO.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+#ifndef ROLLTS_PORT_LINUX_H
+#define ROLLTS_PORT_LINUX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include "rollTs.h"
+/*---------------------------------------------------------------------------*/
+/********************
+ * 配置项 Linux 后端
+ *******************/
+
+// 最多同时打开的后端实例数(flash_ops_t 无上下文参数，每个实例占用一组静态入口)
+#define ROLLTS_LINUX_PORT_MAX   4
+// O_DIRECT 对齐单位 -字节数(不小于设备逻辑块大小)
+#define ROLLTS_LINUX_DIRECT_ALIGN  4096
+/*---------------------------------------------------------------------------*/
+
+typedef enum
+{
+    ROLLTS_LINUX_IO_PREAD = 0,
+    ROLLTS_LINUX_IO_DIRECT,
+    ROLLTS_LINUX_IO_MMAP,
+} rollts_linux_io_t;
+
+typedef enum
+{
+    ROLLTS_LINUX_SYNC_NONE = 0,
+    ROLLTS_LINUX_SYNC_WRITE,
+    ROLLTS_LINUX_SYNC_ERASE,
+    ROLLTS_LINUX_SYNC_PERIODIC,
+} rollts_linux_sync_t;
+
+/**
+ * 后端配置
+ */
+typedef struct
+{
+    const char                        *path;               // 文件或块设备路径，文件不存在时创建
+    uint64_t                         offset;               // 数据库在文件/设备内的起始偏移(DIRECT/MMAP 需按页对齐)
+    uint32_t                           size;               // 数据库大小 -字节数，与 rollts_max_size 一致
+    rollts_linux_io_t                    io;
+    rollts_linux_sync_t                sync;
+    uint32_t                 sync_period_ms;               // ROLLTS_LINUX_SYNC_PERIODIC 落盘周期(不能为 0)
+} rollts_linux_cfg_t;
+
+/**
+ * @func: 打开后端并填充 flash_ops，返回实例号，失败返回 -1
+ *        普通文件小于 offset+size 时扩展并以 0xFF 填充
+ *        ROLLTS_LINUX_SYNC_PERIODIC 时启动周期落盘线程，close 时停止
+ */
+extern int rollts_port_linux_open(const rollts_linux_cfg_t *cfg, flash_ops_t *flash_ops);
+
+/**
+ * @func: 落盘 成功返回 0
+ */
+extern int rollts_port_linux_sync(int port);
+
+/**
+ * @func: 落盘并关闭后端
+ */
+extern void rollts_port_linux_close(int port);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ROLLTS_PORT_LINUX_H
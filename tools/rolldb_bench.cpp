@@ -0,0 +1,239 @@
+/**
+  ******************************************************************************
+  * @file           : rolldb_bench.cpp
+  * @brief          : C 接口与 rolldb::Log 封装、函数指针后端与静态后端的写入/遍历开销对比(主机端)
+  *
+  * - Flash 为 RAM 模拟的 NOR(擦除填 0xFF，写入按位与)，排除器件耗时，只测软件开销
+  * - rollTs.c 与本文件在同一编译单元编译，静态后端的 Flash 函数可内联
+  * - 默认编译：Flash 访问经 flash_ops_t 函数指针；定义 ROLLDB_BENCH_STATIC 时
+  *   经 ROLLTS_FLASH_* 宏直接调用 RamFlash 静态函数
+  * - 分别测量 C 接口(rollts_add / rollts_cursor_next + rollts_read_record)
+  *   与 rolldb::Log(append / 范围 for)每条日志的耗时
+  *
+  * 编译：
+  *   g++ -O2 -std=c++11 -Icore tools/rolldb_bench.cpp -o rolldb_bench_ptr
+  *   g++ -O2 -std=c++11 -Icore -DROLLDB_BENCH_STATIC tools/rolldb_bench.cpp -o rolldb_bench_static
+  * 用法：
+  *   rolldb_bench_ptr [records] [rounds]
+  *
+  ******************************************************************************
+  */
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <unistd.h>
+
+// 数据库 block 数(含系统分区)
+#define BENCH_BLOCK_NUM     64
+#define BENCH_BLOCK_SIZE    (4 * 1024)
+
+/**
+ * RAM 模拟 NOR Flash
+ */
+struct RamFlash
+{
+    static uint8_t mem[BENCH_BLOCK_NUM * BENCH_BLOCK_SIZE];
+
+    static inline int erase(uint32_t addr)
+    {
+        memset(mem + addr, 0xFF, BENCH_BLOCK_SIZE);
+        return 0;
+    }
+    static inline int write(uint32_t addr, void *data, uint32_t len)
+    {
+        const uint8_t *src = static_cast<const uint8_t *>(data);
+        for (uint32_t i = 0; i < len; i++)
+        {
+            mem[addr + i] &= src[i];
+        }
+        return 0;
+    }
+    static inline int read(uint32_t addr, void *data, uint32_t len)
+    {
+        memcpy(data, mem + addr, len);
+        return 0;
+    }
+    static inline void lock() {}
+    static inline void unlock() {}
+};
+uint8_t RamFlash::mem[BENCH_BLOCK_NUM * BENCH_BLOCK_SIZE];
+
+// 静态后端：必须在首次包含 rollTs.h 之前定义
+#ifdef ROLLDB_BENCH_STATIC
+#define ROLLTS_FLASH_ERASE(mgr, addr)                 RamFlash::erase(addr)
+#define ROLLTS_FLASH_WRITE(mgr, addr, data, len)      RamFlash::write((addr), (data), (len))
+#define ROLLTS_FLASH_READ(mgr, addr, data, len)       RamFlash::read((addr), (data), (len))
+#define BENCH_BACKEND_NAME                            "static (ROLLTS_FLASH_*)"
+#else
+#define BENCH_BACKEND_NAME                            "flash_ops_t pointers"
+#endif
+
+#include "rollDb.hpp"
+#include "rollTs.c"
+
+static_assert(BENCH_BLOCK_SIZE == SINGLE_BLOCK_SIZE, "BENCH_BLOCK_SIZE must match SINGLE_BLOCK_SIZE");
+
+struct Sample
+{
+    uint32_t ts;
+    int16_t  temp;
+    uint16_t flags;
+    uint32_t value[2];
+};
+
+typedef rolldb::Log<RamFlash, rolldb::Geometry<BENCH_BLOCK_NUM>, Sample> bench_log_t;
+
+static volatile uint32_t bench_sink;
+
+static double bench_now_ns()
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @func: C 接口 写入 n 条，返回每条耗时 ns
+ */
+static double bench_c_append(rollts_manager_t *mgr, uint32_t n)
+{
+    Sample s = {};
+    double t0 = bench_now_ns();
+    for (uint32_t i = 0; i < n; i++)
+    {
+        s.ts = i;
+        if (!rollts_add_tag(mgr, 0, reinterpret_cast<uint8_t *>(&s), sizeof(s)))
+        {
+            return -1;
+        }
+    }
+    return (bench_now_ns() - t0) / n;
+}
+
+/**
+ * @func: C 接口 从最旧到最新遍历，返回每条耗时 ns
+ */
+static double bench_c_iterate(rollts_manager_t *mgr)
+{
+    rollts_cursor_t cursor;
+    rollts_record_info_t info;
+    Sample s;
+    uint32_t num = 0;
+    double t0 = bench_now_ns();
+    rollts_cursor_init(&cursor);
+    while (rollts_cursor_next(mgr, &cursor, &info))
+    {
+        if (info.payload_len == sizeof(Sample)
+            && sizeof(Sample) == rollts_read_record(mgr, info.handle, 0, reinterpret_cast<uint8_t *>(&s), sizeof(s)))
+        {
+            bench_sink += s.ts;
+            num++;
+        }
+    }
+    return num ? (bench_now_ns() - t0) / num : -1;
+}
+
+/**
+ * @func: rolldb::Log 写入 n 条，返回每条耗时 ns
+ */
+static double bench_log_append(bench_log_t &log, uint32_t n)
+{
+    Sample s = {};
+    double t0 = bench_now_ns();
+    for (uint32_t i = 0; i < n; i++)
+    {
+        s.ts = i;
+        if (!log.append(s))
+        {
+            return -1;
+        }
+    }
+    return (bench_now_ns() - t0) / n;
+}
+
+/**
+ * @func: rolldb::Log 范围 for 遍历，返回每条耗时 ns
+ */
+static double bench_log_iterate(bench_log_t &log)
+{
+    uint32_t num = 0;
+    double t0 = bench_now_ns();
+    for (const auto &e : log)
+    {
+        bench_sink += e.value.ts;
+        num++;
+    }
+    return num ? (bench_now_ns() - t0) / num : -1;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t records = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : 1000000;
+    uint32_t rounds  = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 0) : 5;
+    double best[4]   = { 1e30, 1e30, 1e30, 1e30 };
+    if (0 == records || 0 == rounds)
+    {
+        fprintf(stderr, "usage: %s [records] [rounds]\n", argv[0]);
+        return 1;
+    }
+
+    // 结果写到原 stdout，rollDB 日志丢弃
+    FILE *out = fdopen(dup(STDOUT_FILENO), "w");
+    if (NULL == out || NULL == freopen("/dev/null", "w", stdout))
+    {
+        return 1;
+    }
+
+    for (uint32_t r = 0; r < rounds; r++)
+    {
+        double t[4];
+        // C 接口
+        memset(RamFlash::mem, 0xFF, sizeof(RamFlash::mem));
+        {
+            rollts_manager_t mgr;
+            memset(&mgr, 0, sizeof(mgr));
+            mgr.flash_ops.erase_sector = &RamFlash::erase;
+            mgr.flash_ops.write_data   = &RamFlash::write;
+            mgr.flash_ops.read_data    = &RamFlash::read;
+#ifdef RTOS_MUTEX_ENABLE
+            mgr.flash_ops.mutex_lock   = &RamFlash::lock;
+            mgr.flash_ops.mutex_unlock = &RamFlash::unlock;
+#endif
+            mgr.rollts_max_size        = BENCH_BLOCK_NUM * BENCH_BLOCK_SIZE;
+            if (rollts_init(&mgr) < 0)
+            {
+                return 1;
+            }
+            t[0] = bench_c_append(&mgr, records);
+            t[1] = bench_c_iterate(&mgr);
+        }
+        // rolldb::Log
+        memset(RamFlash::mem, 0xFF, sizeof(RamFlash::mem));
+        {
+            bench_log_t log;
+            if (log.init() < 0)
+            {
+                return 1;
+            }
+            t[2] = bench_log_append(log, records);
+            t[3] = bench_log_iterate(log);
+        }
+        for (int i = 0; i < 4; i++)
+        {
+            if (t[i] < 0)
+            {
+                return 1;
+            }
+            best[i] = t[i] < best[i] ? t[i] : best[i];
+        }
+    }
+
+    fprintf(out, "backend %s, %u records of %u B, best of %u rounds (ns/record)\n",
+            BENCH_BACKEND_NAME, records, (unsigned)sizeof(Sample), rounds);
+    fprintf(out, "%-12s %10s %10s\n", "", "append", "iterate");
+    fprintf(out, "%-12s %10.1f %10.1f\n", "C API", best[0], best[1]);
+    fprintf(out, "%-12s %10.1f %10.1f\n", "rolldb::Log", best[2], best[3]);
+    fclose(out);
+    return 0;
+}
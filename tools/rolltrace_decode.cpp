@@ -0,0 +1,337 @@
+/**
+  ******************************************************************************
+  * @file           : rolltrace_decode.cpp
+  * @brief          : rollDB 二进制跟踪缓冲解码工具(主机端)
+  *
+  * - 读取 rolltrace_snapshot 导出(或调试器读取 rolltrace_ring)的跟踪缓冲
+  * - 扫描源文件中的 log_debug/log_info/log_alt/log_error 调用，
+  *   按 ROLLTRACE_FILE_ID + 行号 找到格式字符串
+  * - 从最旧到最新输出，参数按 %d/%u/%x 等整数格式还原
+  *
+  * 源码需与固件版本一致，行号不一致时输出原始参数。
+  *
+  * 编译：
+  *   g++ -O2 -std=c++11 -Icore tools/rolltrace_decode.cpp -o rolltrace_decode
+  * 用法：
+  *   rolltrace_decode <trace.bin> core/rollTs.c core/rollKv.c ...
+  *
+  ******************************************************************************
+  */
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "rollTrace.h"
+
+struct trace_site_t
+{
+    std::string file;
+    uint32_t    line;           // 调用起始行
+    std::string fmt;
+};
+
+static const char *trace_level_name[] = { "DEBUG", "INFO", "ALT", "ERROR" };
+
+/**
+ * @func: 解析 C 字符串字面量(不含引号)中的转义
+ */
+static std::string unescape(const std::string &s)
+{
+    std::string out;
+    for (size_t i = 0; i < s.size(); i++)
+    {
+        if ('\\' != s[i] || i + 1 >= s.size())
+        {
+            out += s[i];
+            continue;
+        }
+        char c = s[++i];
+        switch (c)
+        {
+        case 'n':  out += '\n'; break;
+        case 'r':  out += '\r'; break;
+        case 't':  out += '\t'; break;
+        default:   out += c;    break;
+        }
+    }
+    return out;
+}
+
+/**
+ * @func: 扫描源文件 记录日志调用所跨的每一行
+ *        跳过注释与字符串内容，第一个参数为(相邻拼接的)字符串字面量
+ */
+static bool scan_source(const char *path, std::map<uint32_t, trace_site_t> &sites, int *file_id)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+    std::stringstream ss;
+    ss << in.rdbuf();
+    const std::string src = ss.str();
+    const size_t n = src.size();
+
+    *file_id = -1;
+    uint32_t line = 1;
+    size_t i = 0;
+    while (i < n)
+    {
+        char c = src[i];
+        if ('\n' == c)
+        {
+            line++;
+            i++;
+        }
+        else if ('/' == c && i + 1 < n && '/' == src[i + 1])
+        {
+            while (i < n && '\n' != src[i])
+            {
+                i++;
+            }
+        }
+        else if ('/' == c && i + 1 < n && '*' == src[i + 1])
+        {
+            for (i += 2; i + 1 < n && !('*' == src[i] && '/' == src[i + 1]); i++)
+            {
+                line += ('\n' == src[i]);
+            }
+            i += 2;
+        }
+        else if ('"' == c || '\'' == c)
+        {
+            for (i++; i < n && c != src[i]; i++)
+            {
+                if ('\\' == src[i])
+                {
+                    i++;
+                }
+            }
+            i++;
+        }
+        else if ('#' == c && 0 == src.compare(i, 25, "#define ROLLTRACE_FILE_ID"))
+        {
+            *file_id = atoi(src.c_str() + i + 25);
+            i += 25;
+        }
+        else if (isalpha((unsigned char)c) || '_' == c)
+        {
+            size_t start = i;
+            while (i < n && (isalnum((unsigned char)src[i]) || '_' == src[i]))
+            {
+                i++;
+            }
+            std::string ident = src.substr(start, i - start);
+            if ("log_debug" != ident && "log_info" != ident && "log_alt" != ident && "log_error" != ident)
+            {
+                continue;
+            }
+            size_t j = i;
+            while (j < n && isspace((unsigned char)src[j]) && '\n' != src[j])
+            {
+                j++;
+            }
+            if (j >= n || '(' != src[j])
+            {
+                continue;
+            }
+            // 格式字符串与调用结束行
+            trace_site_t site;
+            site.file = path;
+            site.line = line;
+            uint32_t end_line = line;
+            int depth = 0;
+            bool in_fmt = true;
+            for (; j < n; j++)
+            {
+                char d = src[j];
+                if ('\n' == d)
+                {
+                    end_line++;
+                }
+                else if ('"' == d)
+                {
+                    size_t k = j + 1;
+                    for (; k < n && '"' != src[k]; k++)
+                    {
+                        if ('\\' == src[k])
+                        {
+                            k++;
+                        }
+                    }
+                    if (in_fmt)
+                    {
+                        site.fmt += unescape(src.substr(j + 1, k - j - 1));
+                    }
+                    j = k;
+                }
+                else if ('(' == d)
+                {
+                    depth++;
+                }
+                else if (')' == d && 0 == --depth)
+                {
+                    break;
+                }
+                else if (',' == d && 1 == depth)
+                {
+                    in_fmt = false;
+                }
+            }
+            for (uint32_t l = line; l <= end_line; l++)
+            {
+                sites[l] = site;
+            }
+            line = end_line;
+            i    = j + 1;
+        }
+        else
+        {
+            i++;
+        }
+    }
+    if (*file_id < 0)
+    {
+        fprintf(stderr, "%s: ROLLTRACE_FILE_ID not defined, skipped\n", path);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @func: 按格式字符串还原日志 只支持整数转换
+ */
+static std::string format_event(const std::string &fmt, const rolltrace_entry_t &e)
+{
+    std::string out;
+    uint32_t argc = ROLLTRACE_ARGC(e.info);
+    uint32_t next = 0;
+    for (size_t i = 0; i < fmt.size(); i++)
+    {
+        if ('%' != fmt[i])
+        {
+            out += fmt[i];
+            continue;
+        }
+        size_t k = i + 1;
+        std::string spec = "%";
+        while (k < fmt.size() && strchr("-+ #0123456789.", fmt[k]))
+        {
+            spec += fmt[k++];
+        }
+        while (k < fmt.size() && strchr("hlzjt", fmt[k]))
+        {
+            k++;
+        }
+        if (k >= fmt.size())
+        {
+            break;
+        }
+        char conv = fmt[k];
+        char buf[64];
+        if ('%' == conv)
+        {
+            out += '%';
+        }
+        else if (next < argc && strchr("diuxXoc", conv))
+        {
+            spec += conv;
+            if ('d' == conv || 'i' == conv)
+            {
+                snprintf(buf, sizeof(buf), spec.c_str(), (int32_t)e.arg[next]);
+            }
+            else
+            {
+                snprintf(buf, sizeof(buf), spec.c_str(), (uint32_t)e.arg[next]);
+            }
+            next++;
+            out += buf;
+        }
+        else
+        {
+            out += "?";
+        }
+        i = k;
+    }
+    return out;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <trace.bin> [source.c ...]\n", argv[0]);
+        return 1;
+    }
+
+    std::map<int, std::map<uint32_t, trace_site_t> > files;
+    for (int a = 2; a < argc; a++)
+    {
+        std::map<uint32_t, trace_site_t> sites;
+        int id;
+        if (scan_source(argv[a], sites, &id))
+        {
+            files[id] = sites;
+        }
+    }
+
+    rolltrace_ring_t ring;
+    FILE *fp = fopen(argv[1], "rb");
+    if (NULL == fp || sizeof(ring) != fread(&ring, 1, sizeof(ring), fp))
+    {
+        fprintf(stderr, "cannot read %s\n", argv[1]);
+        return 1;
+    }
+    fclose(fp);
+    if (MAGIC_TRACE_VALID != ring.magic_valid || sizeof(rolltrace_entry_t) != ring.entry_size
+        || ROLLTRACE_NUM != ring.entry_num)
+    {
+        fprintf(stderr, "trace buffer invalid (magic 0x%x, entry %u x %u)\n",
+                ring.magic_valid, ring.entry_size, ring.entry_num);
+        return 1;
+    }
+
+    uint32_t first = ring.count > ROLLTRACE_NUM ? ring.count - ROLLTRACE_NUM : 0;
+    if (first > 0)
+    {
+        printf("# %u earlier events overwritten\n", first);
+    }
+    for (uint32_t s = first; s != ring.count; s++)
+    {
+        const rolltrace_entry_t &e = ring.entries[s & (ROLLTRACE_NUM - 1)];
+        const char *level = trace_level_name[ROLLTRACE_LEVEL(e.info)];
+        const trace_site_t *site = NULL;
+        std::map<int, std::map<uint32_t, trace_site_t> >::const_iterator f = files.find(e.file);
+        if (f != files.end())
+        {
+            std::map<uint32_t, trace_site_t>::const_iterator it = f->second.find(e.line);
+            if (it != f->second.end())
+            {
+                site = &it->second;
+            }
+        }
+        if (site)
+        {
+            printf("%10u %-5s %s:%u %s\n", e.ts, level, site->file.c_str(), site->line,
+                   format_event(site->fmt, e).c_str());
+        }
+        else
+        {
+            printf("%10u %-5s file%u:%u", e.ts, level, e.file, e.line);
+            for (uint32_t k = 0; k < ROLLTRACE_ARGC(e.info); k++)
+            {
+                printf(" 0x%x", e.arg[k]);
+            }
+            printf("\n");
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,669 @@
+/**
+  ******************************************************************************
+  * @file           : rollts_dump.cpp
+  * @brief          : rollDB Flash 镜像离线解析/导出工具(主机端)
+  *
+  * - mmap 方式打开整片 Flash 镜像，按地址 0 处的 rollts_sys_t 恢复几何参数
+  * - block 之间相互独立(block_info_t + 块内链表)，多线程并行解析
+  * - 根据 head/backup 标记恢复循环顺序，从最旧到最新输出
+  * - 分片日志沿后续 block 拼接后输出，续片不完整的日志丢弃
+  * - 未提交(magic 未写入)的日志跳过
+  * - 按 block 头中的日志格式分别解析 v1(rollts_data_t) / v2(紧凑日志头)
+  * - 旧布局分区(ROLLTS_LEGACY_LAYOUTS)按系统分区布局版本逐块解析，没有 first_seq 的 block 按日志条数推算序号
+  * - 输出格式：csv / jsonl / bin([u32 len][u8 tag][payload])
+  *
+  * 编译：
+  *   g++ -O2 -std=c++11 -pthread -Icore tools/rollts_dump.cpp -o rollts_dump
+  * 用法：
+  *   rollts_dump <image> [-f csv|jsonl|bin] [-o out] [-j threads]
+  *
+  ******************************************************************************
+  */
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rollTs.h"
+
+enum dump_format_t
+{
+    DUMP_CSV,
+    DUMP_JSONL,
+    DUMP_BIN,
+};
+
+struct dump_image_t
+{
+    const uint8_t       *base;
+    size_t               size;
+    rollts_sys_t         sys;
+    const rollts_layout_t *legacy;  // 旧布局分区的 block 头布局，NULL: 当前布局
+    std::vector<uint32_t> order;   // 从最旧到最新的 block 地址
+    std::vector<uint64_t> first_seq; // 与 order 对应的 block 第一条日志序号
+};
+
+static const rollts_layout_t dump_legacy_layouts[ROLLTS_LEGACY_LAYOUT_NUM] = ROLLTS_LEGACY_LAYOUTS;
+
+/**
+ * @func: 读取镜像中的结构体(越界时返回 false)
+ */
+template <typename T>
+static bool image_read(const dump_image_t &img, uint32_t addr, T *out)
+{
+    if ((size_t)addr + sizeof(T) > img.size)
+    {
+        return false;
+    }
+    memcpy(out, img.base + addr, sizeof(T));
+    return true;
+}
+
+/**
+ * @func: 校验系统分区并恢复几何参数
+ */
+static bool image_load_sys(dump_image_t &img)
+{
+    if (!image_read(img, 0, &img.sys))
+    {
+        return false;
+    }
+    // 初始版本系统分区没有 layout_version 字段
+    if (0xFFFFFFFF == img.sys.layout_version)
+    {
+        img.sys.layout_version = ROLLTS_LAYOUT_BASE;
+    }
+    const rollts_sys_t &sys = img.sys;
+    img.legacy = (sys.layout_version < ROLLTS_LEGACY_LAYOUT_NUM && 0 != dump_legacy_layouts[sys.layout_version].hdr_size)
+               ? &dump_legacy_layouts[sys.layout_version] : NULL;
+    if (MAGIC_VALID != sys.magic_valid || (ROLLTS_LAYOUT_VERSION != sys.layout_version && NULL == img.legacy))
+    {
+        fprintf(stderr, "sys sector invalid (magic 0x%x, layout %u)\n", sys.magic_valid, sys.layout_version);
+        return false;
+    }
+    if (0 == sys.single_block_size || sys.rollts_max_block_num < 5
+        || (size_t)sys.rollts_max_block_num * sys.single_block_size > img.size
+        || 1 != sys.data_start_block_num || sys.data_end_block_num >= sys.rollts_max_block_num
+        || sys.data_end_block_num < sys.data_start_block_num + 3)
+    {
+        fprintf(stderr, "geometry does not fit the image\n");
+        return false;
+    }
+    // 加入代号之前的 layout 5 分区追加记录紧接 48 字节系统信息(同 rollTs.c sys_log_start)，没有代号
+    uint32_t log_start = ROLLTS_CONSUMER_AREA_ADDR;
+    for (uint32_t addr = SYSINFO_SIZE; addr < ROLLTS_CONSUMER_AREA_ADDR; addr++)
+    {
+        if (0xFF != img.base[addr])
+        {
+            log_start          = offsetof(rollts_sys_t, generation);
+            img.sys.generation = 0xFFFFFFFF;
+            break;
+        }
+    }
+    // 系统分区之后追加的日志格式更新记录覆盖 record_format
+    for (uint32_t addr = log_start; addr + sizeof(rollts_consumer_entry_t) <= sys.single_block_size;
+         addr += sizeof(rollts_consumer_entry_t))
+    {
+        rollts_consumer_entry_t entry;
+        rollts_consumer_entry_t empty;
+        memset(&empty, 0xFF, sizeof(empty));
+        if (!image_read(img, addr, &entry) || 0 == memcmp(&entry, &empty, sizeof(entry)))
+        {
+            break;
+        }
+        if (MAGIC_FORMAT_VALID == entry.magic_valid)
+        {
+            img.sys.record_format = (uint32_t)entry.seq;
+        }
+    }
+    return true;
+}
+
+/**
+ * @func: 判断 block 头是否按旧布局写入(同 rollTs.c block_layout)
+ *        layout 1~3 先检查旧布局 magic；其余布局当前布局 magic 有效时优先按当前布局解析，
+ *        layout 6 以 status 之后的代号字节区分
+ */
+static const rollts_layout_t *image_block_layout(const dump_image_t &img, const uint8_t *raw)
+{
+    uint32_t magic = 0;
+    if (img.legacy->magic_valid < offsetof(block_info_t, agg))
+    {
+        memcpy(&magic, raw + img.legacy->magic_valid, sizeof(uint32_t));
+        if (MAGIC_VALID == magic)
+        {
+            return img.legacy;
+        }
+    }
+    memcpy(&magic, raw + offsetof(block_info_t, magic_valid), sizeof(uint32_t));
+    if (MAGIC_VALID == magic)
+    {
+        return (offsetof(block_info_t, magic_valid) == img.legacy->magic_valid
+                && 0xFF != raw[offsetof(block_info_t, status) + 1]) ? img.legacy : NULL;
+    }
+    memcpy(&magic, raw + img.legacy->magic_valid, sizeof(uint32_t));
+    return (MAGIC_VALID == magic) ? img.legacy : NULL;
+}
+
+/**
+ * @func: 读取 block 头(同 rollTs.c block_info_read)，旧布局 block 转换为当前布局
+ *        layout 返回旧布局，NULL: 当前布局
+ */
+static bool image_block_info(const dump_image_t &img, uint32_t block_addr, block_info_t *info,
+                             const rollts_layout_t **layout = NULL)
+{
+    uint8_t raw[ROLLTS_LEGACY_HDR_MAX];
+    const rollts_layout_t *found = NULL;
+    if (layout)
+    {
+        *layout = NULL;
+    }
+    if (NULL == img.legacy)
+    {
+        return image_read(img, block_addr, info);
+    }
+    if (!image_read(img, block_addr, &raw))
+    {
+        return false;
+    }
+    found = image_block_layout(img, raw);
+    if (NULL == found)
+    {
+        memcpy(info, raw, sizeof(block_info_t));
+        return true;
+    }
+    memset(info, 0xFF, sizeof(block_info_t));
+    memcpy(&info->last_data_addr, raw + offsetof(block_info_t, last_data_addr), sizeof(uint32_t));
+    memcpy(&info->data_num, raw + offsetof(block_info_t, data_num), sizeof(int32_t));
+    if (0 != found->first_seq)
+    {
+        memcpy(&info->first_seq, raw + found->first_seq, sizeof(uint64_t));
+    }
+    info->magic_valid = MAGIC_VALID;
+    info->status      = raw[found->status];
+    if (found->v1_base)
+    {
+        SET_BLOCK_FORMAT((*info), ROLLTS_FMT_V1_BASE);
+    }
+    info->generation  = ROLLTS_BLOCK_GENERATION(img.sys);
+    if (0 != found->generation)
+    {
+        uint32_t generation = 0;
+        memcpy(&generation, raw + found->generation, sizeof(uint32_t));
+        if (generation != img.sys.generation)
+        {
+            info->generation = (uint16_t)~info->generation;
+        }
+    }
+    if (layout)
+    {
+        *layout = found;
+    }
+    return true;
+}
+
+/**
+ * @func: block 日志区起始地址
+ */
+static uint32_t block_data_start(const dump_image_t &img, uint32_t block_addr)
+{
+    block_info_t info;
+    const rollts_layout_t *layout = NULL;
+    image_block_info(img, block_addr, &info, &layout);
+    return block_addr + (layout ? layout->hdr_size : sizeof(block_info_t));
+}
+
+/**
+ * @func: 按 head 标记恢复 block 循环顺序(同 scan_head_block)
+ */
+static bool image_order_blocks(dump_image_t &img)
+{
+    const rollts_sys_t &sys = img.sys;
+    uint32_t block_num  = sys.data_end_block_num - sys.data_start_block_num + 1;
+    uint32_t head_addr  = 0;
+    bool     found      = false;
+    bool     head_first = false;
+    bool     head_last  = false;
+
+    for (uint32_t i = 0; i < block_num; i++)
+    {
+        uint32_t addr = sys.data_start_addr + sys.single_block_size * i;
+        block_info_t info;
+        if (!image_block_info(img, addr, &info) || MAGIC_VALID != info.magic_valid || !IS_HEAD(info)
+            || ROLLTS_BLOCK_GENERATION(sys) != info.generation)
+        {
+            continue;
+        }
+        head_first = head_first || (0 == i);
+        head_last  = (block_num - 1 == i);
+        head_addr  = addr;
+        found      = true;
+    }
+    // 迁移中断时新旧 head 同时存在，取靠后的一个；回绕时首块为新 head
+    if (head_first && head_last)
+    {
+        head_addr = sys.data_start_addr;
+    }
+    if (!found)
+    {
+        fprintf(stderr, "head block not found\n");
+        return false;
+    }
+
+    // 最旧 block = head_backup 的下一个，直到 head 之前(跳过清除后代号不一致的 block)
+    uint32_t addr = head_addr;
+    for (int step = 0; step < 2; step++)
+    {
+        addr = (addr + sys.single_block_size > sys.data_end_addr) ? sys.data_start_addr : addr + sys.single_block_size;
+    }
+    while (addr != head_addr)
+    {
+        block_info_t info;
+        if (img.order.empty() && (!image_block_info(img, addr, &info) || ROLLTS_BLOCK_GENERATION(sys) != info.generation))
+        {
+            addr = (addr + sys.single_block_size > sys.data_end_addr) ? sys.data_start_addr : addr + sys.single_block_size;
+            continue;
+        }
+        img.order.push_back(addr);
+        addr = (addr + sys.single_block_size > sys.data_end_addr) ? sys.data_start_addr : addr + sys.single_block_size;
+    }
+    return true;
+}
+
+/**
+ * @func: 读取 block 日志格式
+ */
+static uint8_t block_format(const dump_image_t &img, uint32_t block_addr)
+{
+    block_info_t info;
+    if (!image_block_info(img, block_addr, &info))
+    {
+        return ROLLTS_FMT_V1;
+    }
+    uint8_t format = GET_BLOCK_FORMAT(info);
+    return (ROLLTS_FMT_V2 == format || ROLLTS_FMT_FIXED == format || ROLLTS_FMT_V1_BASE == format) ? format : ROLLTS_FMT_V1;
+}
+
+/**
+ * @func: 计算 block 日志区结束地址(有块尾偏移表时为偏移表起始)
+ */
+static uint32_t block_data_end(const dump_image_t &img, uint32_t block_addr)
+{
+    block_info_t info;
+    uint32_t block_end = block_addr + img.sys.single_block_size;
+    if (!image_block_info(img, block_addr, &info) || !HAS_BLOCK_FOOTER(info) || info.data_num <= 0
+        || ROLLTS_FOOTER_SIZE(info.data_num) > img.sys.single_block_size)
+    {
+        return block_end;
+    }
+    return block_end - ROLLTS_FOOTER_SIZE(info.data_num);
+}
+
+/**
+ * @func: 解码日志头(同 rollTs.c record_decode_head)
+ *        返回日志头长度，0: 空位或越界
+ */
+static uint32_t decode_head(const dump_image_t &img, uint8_t format, uint32_t data_addr, uint32_t block_end,
+                            rollts_data_t *head)
+{
+    if (ROLLTS_FMT_FIXED == format)
+    {
+        // 定长日志：负载长度保存在 sys.record_format bit[31:8]
+        uint32_t slot = 1 + (img.sys.record_format >> 8);
+        if (data_addr + slot > block_end || (size_t)block_end > img.size
+            || ROLLTS_FIXED_COMMIT != (img.base[data_addr] & ROLLTS_FIXED_COMMIT_MASK))
+        {
+            return 0;
+        }
+        memset(head, 0, sizeof(rollts_data_t));
+        head->magic_valid = MAGIC_DATA_VALID;
+        head->cur_addr    = data_addr;
+        head->next_addr   = data_addr + slot;
+        head->payload_len = slot - 1;
+        head->tag         = img.base[data_addr] & 0x1F;
+        return 1;
+    }
+    if (ROLLTS_FMT_V1_BASE == format)
+    {
+        // 初始版本 v1 日志头没有 tag/frag
+        if (data_addr + ROLLTS_V1_BASE_HDR_LEN > block_end || (size_t)data_addr + ROLLTS_V1_BASE_HDR_LEN > img.size)
+        {
+            return 0;
+        }
+        memset(head, 0, sizeof(rollts_data_t));
+        memcpy(head, img.base + data_addr, ROLLTS_V1_BASE_HDR_LEN);
+        return ROLLTS_V1_BASE_HDR_LEN;
+    }
+    if (ROLLTS_FMT_V2 != format)
+    {
+        if (data_addr + sizeof(rollts_data_t) > block_end || !image_read(img, data_addr, head))
+        {
+            return 0;
+        }
+        return sizeof(rollts_data_t);
+    }
+    if (data_addr + ROLLTS_V2_HDR_MIN > block_end || (size_t)block_end > img.size)
+    {
+        return 0;
+    }
+    const uint8_t *buf = img.base + data_addr;
+    uint32_t n = std::min<uint32_t>(block_end - data_addr, ROLLTS_V2_HDR_MAX);
+    if (buf[1] & 0x80)
+    {
+        return 0;
+    }
+    uint32_t len = 0;
+    uint32_t i   = 2;
+    do
+    {
+        if (i >= n)
+        {
+            return 0;
+        }
+        len |= (uint32_t)(buf[i] & 0x7F) << (7 * (i - 2));
+    } while (buf[i++] & 0x80);
+
+    memset(head, 0, sizeof(rollts_data_t));
+    head->magic_valid = (ROLLTS_V2_COMMIT == buf[0]) ? MAGIC_DATA_VALID : (0xFF == buf[0]) ? 0xFFFFFFFF : 0;
+    head->cur_addr    = data_addr;
+    head->next_addr   = data_addr + i + len;
+    head->payload_len = len;
+    head->tag         = buf[1] & 0x1F;
+    head->frag        = (buf[1] >> 5) & 0x03;
+    return i;
+}
+
+/**
+ * @func: 输出单条记录
+ */
+static void emit_record(std::string &out, dump_format_t format, uint32_t block_addr, uint32_t index,
+                        uint64_t seq, uint32_t addr, uint8_t tag, const uint8_t *payload, uint32_t len)
+{
+    static const char hex[] = "0123456789abcdef";
+    char head[128];
+    switch (format)
+    {
+    case DUMP_CSV:
+        snprintf(head, sizeof(head), "0x%x,%u,%llu,0x%x,%u,%u,", block_addr, index, (unsigned long long)seq, addr, tag, len);
+        out += head;
+        break;
+    case DUMP_JSONL:
+        snprintf(head, sizeof(head), "{\"block\":%u,\"index\":%u,\"seq\":%llu,\"addr\":%u,\"tag\":%u,\"len\":%u,\"data\":\"",
+                 block_addr, index, (unsigned long long)seq, addr, tag, len);
+        out += head;
+        break;
+    case DUMP_BIN:
+        out.append((const char *)&len, sizeof(len));
+        out.append((const char *)&tag, sizeof(tag));
+        out.append((const char *)payload, len);
+        return;
+    }
+    size_t pos = out.size();
+    out.resize(pos + len * 2);
+    for (uint32_t i = 0; i < len; i++)
+    {
+        out[pos + i * 2]     = hex[payload[i] >> 4];
+        out[pos + i * 2 + 1] = hex[payload[i] & 0x0F];
+    }
+    out += (DUMP_CSV == format) ? "\n" : "\"}\n";
+}
+
+/**
+ * @func: 读取 block 内第一条日志头，hdr_len 返回日志头长度
+ */
+static bool first_record(const dump_image_t &img, uint32_t block_addr, rollts_data_t *tmp, uint32_t *hdr_len)
+{
+    *hdr_len = decode_head(img, block_format(img, block_addr), block_data_start(img, block_addr),
+                           block_data_end(img, block_addr), tmp);
+    return 0 != *hdr_len && MAGIC_DATA_VALID == tmp->magic_valid;
+}
+
+/**
+ * @func: 拼接分片日志(续片位于后续 block 的第一条)
+ *        返回 false: 分片不完整
+ */
+static bool gather_fragments(const dump_image_t &img, size_t order_index, const rollts_data_t &first,
+                             uint32_t payload_addr, std::string &payload)
+{
+    payload.assign((const char *)img.base + payload_addr, first.payload_len);
+    for (size_t i = order_index + 1; i < img.order.size(); i++)
+    {
+        uint32_t block_addr = img.order[i];
+        uint32_t data_addr  = block_data_start(img, block_addr);
+        uint32_t hdr_len    = 0;
+        rollts_data_t tmp;
+        if (!first_record(img, block_addr, &tmp, &hdr_len) || IS_RECORD_START(tmp)
+            || tmp.payload_len > block_addr + img.sys.single_block_size - data_addr - hdr_len)
+        {
+            return false;
+        }
+        payload.append((const char *)img.base + data_addr + hdr_len, tmp.payload_len);
+        if (ROLLTS_FRAG_LAST == tmp.frag)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @func: 解析单个 block 为输出文本
+ *        只输出起始于本 block 的日志，上一 block 日志的续片跳过
+ *        返回起始于本 block 的日志条数
+ */
+static uint32_t decode_block(const dump_image_t &img, size_t order_index, dump_format_t format, std::string &out)
+{
+    uint32_t block_addr = img.order[order_index];
+    uint32_t block_end  = block_data_end(img, block_addr);
+    uint32_t data_addr  = block_data_start(img, block_addr);
+    uint32_t index      = 0;
+    uint8_t  rec_format = block_format(img, block_addr);
+    uint64_t first_seq  = img.first_seq[order_index];
+    uint32_t hdr_len    = 0;
+    rollts_data_t tmp;
+    std::string payload;
+
+    while (0 != (hdr_len = decode_head(img, rec_format, data_addr, block_end, &tmp)))
+    {
+        if (MAGIC_DATA_VALID != tmp.magic_valid)
+        {
+            // 未提交的日志(写入中断)：头部已写入但 magic 未写，跳过占用的空间
+            if (0xFFFFFFFF == tmp.magic_valid && data_addr == tmp.cur_addr
+                && tmp.next_addr > data_addr && tmp.next_addr <= block_end)
+            {
+                data_addr = tmp.next_addr;
+                continue;
+            }
+            break;
+        }
+        uint32_t payload_addr = data_addr + hdr_len;
+        if (tmp.payload_len > block_end - payload_addr || tmp.next_addr <= data_addr)
+        {
+            fprintf(stderr, "block 0x%x: corrupt record at 0x%x\n", block_addr, data_addr);
+            break;
+        }
+        if (ROLLTS_FRAG_NONE == tmp.frag)
+        {
+            emit_record(out, format, block_addr, index, first_seq + index, data_addr, tmp.tag,
+                        img.base + payload_addr, tmp.payload_len);
+            index++;
+        }
+        else if (ROLLTS_FRAG_FIRST == tmp.frag)
+        {
+            if (gather_fragments(img, order_index, tmp, payload_addr, payload))
+            {
+                emit_record(out, format, block_addr, index, first_seq + index, data_addr, tmp.tag,
+                            (const uint8_t *)payload.data(), (uint32_t)payload.size());
+            }
+            index++;
+        }
+        data_addr = tmp.next_addr;
+    }
+    return index;
+}
+
+/**
+ * @func: 恢复各 block 第一条日志序号
+ *        没有 first_seq 的旧布局 block 位于最旧一侧，以之后第一个带 first_seq 的 block 为基准
+ *        减去之前各 block 的日志条数(同 rollTs.c legacy_seq_init)，没有基准时从 0 开始
+ */
+static void image_block_seqs(dump_image_t &img)
+{
+    img.first_seq.assign(img.order.size(), 0);
+    uint64_t count = 0;
+    size_t   i     = 0;
+    for (; i < img.order.size(); i++)
+    {
+        block_info_t info;
+        const rollts_layout_t *layout = NULL;
+        image_block_info(img, img.order[i], &info, &layout);
+        if (NULL == layout || 0 != layout->first_seq)
+        {
+            break;
+        }
+        img.first_seq[i] = count;
+        if (info.data_num >= 0 && !layout->count_walk)
+        {
+            count += (uint64_t)info.data_num;
+        }
+        else
+        {
+            std::string scratch;
+            count += decode_block(img, i, DUMP_BIN, scratch);
+        }
+    }
+    uint64_t base = 0;
+    if (i < img.order.size())
+    {
+        block_info_t info;
+        image_block_info(img, img.order[i], &info);
+        base = (ROLLTS_SEQ_NONE != info.first_seq && info.first_seq >= count) ? info.first_seq - count : 0;
+    }
+    for (size_t k = 0; k < i; k++)
+    {
+        img.first_seq[k] += base;
+    }
+    for (; i < img.order.size(); i++)
+    {
+        block_info_t info;
+        image_block_info(img, img.order[i], &info);
+        img.first_seq[i] = info.first_seq;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char   *image_path  = NULL;
+    const char   *output_path = NULL;
+    dump_format_t format      = DUMP_CSV;
+    unsigned      threads     = std::thread::hardware_concurrency();
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (0 == strcmp(argv[i], "-f") && i + 1 < argc)
+        {
+            const char *f = argv[++i];
+            format = (0 == strcmp(f, "jsonl")) ? DUMP_JSONL : (0 == strcmp(f, "bin")) ? DUMP_BIN : DUMP_CSV;
+        }
+        else if (0 == strcmp(argv[i], "-o") && i + 1 < argc)
+        {
+            output_path = argv[++i];
+        }
+        else if (0 == strcmp(argv[i], "-j") && i + 1 < argc)
+        {
+            threads = (unsigned)atoi(argv[++i]);
+        }
+        else
+        {
+            image_path = argv[i];
+        }
+    }
+    if (NULL == image_path)
+    {
+        fprintf(stderr, "usage: %s <image> [-f csv|jsonl|bin] [-o out] [-j threads]\n", argv[0]);
+        return 1;
+    }
+    if (0 == threads)
+    {
+        threads = 1;
+    }
+
+    int fd = open(image_path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || 0 != fstat(fd, &st) || 0 == st.st_size)
+    {
+        perror(image_path);
+        return 1;
+    }
+    dump_image_t img;
+    img.size = (size_t)st.st_size;
+    img.base = (const uint8_t *)mmap(NULL, img.size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (MAP_FAILED == img.base)
+    {
+        perror("mmap");
+        return 1;
+    }
+    madvise((void *)img.base, img.size, MADV_SEQUENTIAL);
+
+    if (!image_load_sys(img) || !image_order_blocks(img))
+    {
+        return 1;
+    }
+    image_block_seqs(img);
+
+    FILE *out = output_path ? fopen(output_path, "wb") : stdout;
+    if (NULL == out)
+    {
+        perror(output_path);
+        return 1;
+    }
+    if (DUMP_CSV == format)
+    {
+        fputs("block,index,seq,addr,tag,len,data\n", out);
+    }
+
+    // 按窗口并行解析，窗口内按循环顺序输出，内存占用与窗口大小成正比
+    const size_t window = (size_t)threads * 8;
+    std::vector<std::string> results(window);
+    for (size_t base = 0; base < img.order.size(); base += window)
+    {
+        size_t count = std::min(window, img.order.size() - base);
+        std::atomic<size_t> next(0);
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < threads && t < count; t++)
+        {
+            workers.emplace_back([&]() {
+                for (size_t i = next++; i < count; i = next++)
+                {
+                    results[i].clear();
+                    decode_block(img, base + i, format, results[i]);
+                }
+            });
+        }
+        for (std::thread &w : workers)
+        {
+            w.join();
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            fwrite(results[i].data(), 1, results[i].size(), out);
+        }
+    }
+
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+    munmap((void *)img.base, img.size);
+    close(fd);
+    return 0;
+}
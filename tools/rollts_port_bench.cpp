@@ -0,0 +1,189 @@
+/**
+  ******************************************************************************
+  * @file           : rollts_port_bench.cpp
+  * @brief          : Linux 后端各读写方式/落盘策略吞吐测试(主机端)
+  *
+  * - 依次以 PREAD / MMAP / DIRECT 读写方式和 NONE / ERASE / WRITE / PERIODIC 落盘策略
+  *   打开同一路径，格式化后连续写入定长日志，输出每种组合的条/s
+  * - 每种组合写满 -n 条或运行 -t 秒后停止(逐条落盘在慢设备上很慢)
+  * - 关闭后端(含最后一次落盘)的耗时计入结果
+  * - 测试会覆盖目标文件/设备 offset 0 起 -s 大小的内容
+  * - rollDB 日志(ROLLDB_PRINTF)输出到 stdout，测试期间丢弃，结果表单独输出
+  *
+  * 编译：
+  *   g++ -O2 -std=c++11 -pthread -Icore -Iport -x c++ core/rollTs.c port/rollts_port_linux.c \
+  *       tools/rollts_port_bench.cpp -o rollts_port_bench
+  * 用法：
+  *   rollts_port_bench <path> [-s size_kb] [-r record_bytes] [-n records] [-t seconds] [-p period_ms]
+  *
+  ******************************************************************************
+  */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <unistd.h>
+
+#include "rollTs.h"
+#include "rollts_port_linux.h"
+
+struct bench_cfg_t
+{
+    const char *path;
+    uint32_t    size;
+    uint32_t    record;
+    uint32_t    records;
+    double      seconds;
+    uint32_t    period_ms;
+};
+
+/**
+ * @func: 单个组合 返回条/s，打开/初始化失败返回负数
+ */
+static double bench_run(const bench_cfg_t &cfg, rollts_linux_io_t io, rollts_linux_sync_t sync)
+{
+    rollts_manager_t mgr;
+    rollts_linux_cfg_t port_cfg;
+    std::vector<uint8_t> rec(cfg.record, 0x5A);
+    memset(&mgr, 0, sizeof(mgr));
+    memset(&port_cfg, 0, sizeof(port_cfg));
+    port_cfg.path           = cfg.path;
+    port_cfg.offset         = 0;
+    port_cfg.size           = cfg.size;
+    port_cfg.io             = io;
+    port_cfg.sync           = sync;
+    port_cfg.sync_period_ms = cfg.period_ms;
+
+    int port = rollts_port_linux_open(&port_cfg, &mgr.flash_ops);
+    if (port < 0)
+    {
+        return -1;
+    }
+    mgr.rollts_max_size = cfg.size;
+    if (rollts_init(&mgr) < 0 || !rollts_clear(&mgr))
+    {
+        rollts_port_linux_close(port);
+        return -1;
+    }
+    rollts_port_linux_sync(port);
+
+    auto start     = std::chrono::steady_clock::now();
+    auto limit     = start + std::chrono::duration<double>(cfg.seconds);
+    uint32_t count = 0;
+    while (count < cfg.records)
+    {
+        memcpy(rec.data(), &count, cfg.record < sizeof(count) ? cfg.record : sizeof(count));
+        if (!rollts_add(&mgr, rec.data(), cfg.record))
+        {
+            break;
+        }
+        count++;
+        if (0 == (count & 63) && std::chrono::steady_clock::now() >= limit)
+        {
+            break;
+        }
+    }
+    rollts_port_linux_close(port);
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return count / sec;
+}
+
+/**
+ * @func: 格式化吞吐 条/s
+ */
+static void bench_print(FILE *out, double rate)
+{
+    if (rate < 0)
+    {
+        fprintf(out, " %14s", "open failed");
+    }
+    else
+    {
+        fprintf(out, " %14.0f", rate);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bench_cfg_t cfg = { NULL, 256 * 1024, 32, 2000000, 3.0, 100 };
+    for (int i = 1; i < argc; i++)
+    {
+        if (0 == strcmp(argv[i], "-s") && i + 1 < argc)
+        {
+            cfg.size = (uint32_t)strtoul(argv[++i], NULL, 0) * 1024;
+        }
+        else if (0 == strcmp(argv[i], "-r") && i + 1 < argc)
+        {
+            cfg.record = (uint32_t)strtoul(argv[++i], NULL, 0);
+        }
+        else if (0 == strcmp(argv[i], "-n") && i + 1 < argc)
+        {
+            cfg.records = (uint32_t)strtoul(argv[++i], NULL, 0);
+        }
+        else if (0 == strcmp(argv[i], "-t") && i + 1 < argc)
+        {
+            cfg.seconds = atof(argv[++i]);
+        }
+        else if (0 == strcmp(argv[i], "-p") && i + 1 < argc)
+        {
+            cfg.period_ms = (uint32_t)strtoul(argv[++i], NULL, 0);
+        }
+        else if (NULL == cfg.path && '-' != argv[i][0])
+        {
+            cfg.path = argv[i];
+        }
+        else
+        {
+            cfg.path = NULL;
+            break;
+        }
+    }
+    if (NULL == cfg.path || 0 == cfg.record || 0 == cfg.size || cfg.size % MIN_ERASE_UNIT_SIZE)
+    {
+        fprintf(stderr, "usage: %s <path> [-s size_kb] [-r record_bytes] [-n records] [-t seconds] [-p period_ms]\n", argv[0]);
+        return 1;
+    }
+
+    static const struct { rollts_linux_io_t io; const char *name; } ios[] =
+    {
+        { ROLLTS_LINUX_IO_PREAD,  "PREAD"  },
+        { ROLLTS_LINUX_IO_MMAP,   "MMAP"   },
+        { ROLLTS_LINUX_IO_DIRECT, "DIRECT" },
+    };
+    static const struct { rollts_linux_sync_t sync; const char *name; } syncs[] =
+    {
+        { ROLLTS_LINUX_SYNC_NONE,     "NONE"     },
+        { ROLLTS_LINUX_SYNC_ERASE,    "ERASE"    },
+        { ROLLTS_LINUX_SYNC_WRITE,    "WRITE"    },
+        { ROLLTS_LINUX_SYNC_PERIODIC, "PERIODIC" },
+    };
+
+    // 结果表写到原 stdout，rollDB 日志丢弃
+    FILE *out = fdopen(dup(STDOUT_FILENO), "w");
+    if (NULL == out || NULL == freopen("/dev/null", "w", stdout))
+    {
+        return 1;
+    }
+    fprintf(out, "path %s, size %u KB, record %u B, period %u ms (records/s)\n",
+            cfg.path, cfg.size / 1024, cfg.record, cfg.period_ms);
+    fprintf(out, "%-8s", "io");
+    for (const auto &s : syncs)
+    {
+        fprintf(out, " %14s", s.name);
+    }
+    fprintf(out, "\n");
+    for (const auto &io : ios)
+    {
+        fprintf(out, "%-8s", io.name);
+        for (const auto &s : syncs)
+        {
+            bench_print(out, bench_run(cfg, io.io, s.sync));
+            fflush(out);
+        }
+        fprintf(out, "\n");
+    }
+    fclose(out);
+    return 0;
+}
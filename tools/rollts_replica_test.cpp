@@ -0,0 +1,306 @@
+/**
+  ******************************************************************************
+  * @file           : rollts_replica_test.cpp
+  * @brief          : 日志复制测试(主机端)：同一进程内两个 RAM 模拟 Flash 实例
+  *
+  * - src/dst 各使用一片 RAM 模拟 NOR(擦除填 0xFF，写入按位与)，统计读写次数
+  * - 整块拷贝：已封顶 block 整块复制，dst 写入次数远少于日志条数
+  * - 逐条复制：写入块中的新日志逐条复制，只复制上次同步之后的部分
+  * - 复制预算与落后条数：max_records 限制单次复制条数，rollts_replica_lag 返回剩余条数
+  * - 重启续传：两个实例重新 rollts_init 后按 dst 下一个序号继续复制
+  * - 每步比较 src/dst 同序号日志内容一致，dst 最旧序号之后的 src 日志全部存在
+  *
+  * 编译：
+  *   g++ -O2 -std=c++11 -Icore -x c++ core/rollTs.c tools/rollts_replica_test.cpp -o rollts_replica_test
+  * 用法：
+  *   rollts_replica_test          # 全部通过返回 0，否则输出失败位置并返回 1
+  *
+  ******************************************************************************
+  */
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <vector>
+
+#include <unistd.h>
+
+#include "rollTs.h"
+
+// 单个实例大小
+#define TEST_FLASH_SIZE     ROLLTS_MAX_SIZE
+
+static FILE *test_out;
+
+#define TEST_CHECK(cond)                                                            \
+    do                                                                              \
+    {                                                                               \
+        if (!(cond))                                                                \
+        {                                                                           \
+            fprintf(test_out, "FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);       \
+            return false;                                                           \
+        }                                                                           \
+    } while (0)
+
+/**
+ * RAM 模拟 NOR Flash
+ */
+struct test_flash_t
+{
+    uint8_t  mem[TEST_FLASH_SIZE];
+    uint32_t erases;
+    uint32_t writes;
+    uint32_t reads;
+};
+
+static test_flash_t test_flash[2];
+
+template <int N>
+struct TestFlash
+{
+    static int erase(uint32_t addr)
+    {
+        if (addr % MIN_ERASE_UNIT_SIZE || addr + MIN_ERASE_UNIT_SIZE > TEST_FLASH_SIZE)
+        {
+            return -1;
+        }
+        memset(test_flash[N].mem + addr, 0xFF, MIN_ERASE_UNIT_SIZE);
+        test_flash[N].erases++;
+        return 0;
+    }
+    static int write(uint32_t addr, void *data, uint32_t len)
+    {
+        const uint8_t *src = static_cast<const uint8_t *>(data);
+        if ((uint64_t)addr + len > TEST_FLASH_SIZE)
+        {
+            return -1;
+        }
+        for (uint32_t i = 0; i < len; i++)
+        {
+            test_flash[N].mem[addr + i] &= src[i];
+        }
+        test_flash[N].writes++;
+        return 0;
+    }
+    static int read(uint32_t addr, void *data, uint32_t len)
+    {
+        if ((uint64_t)addr + len > TEST_FLASH_SIZE)
+        {
+            return -1;
+        }
+        memcpy(data, test_flash[N].mem + addr, len);
+        test_flash[N].reads++;
+        return 0;
+    }
+    static void lock() {}
+    static void unlock() {}
+
+    /**
+     * @func: 绑定到实例并挂载(不擦除 Flash 内容，重复调用即模拟重启)
+     */
+    static bool mount(rollts_manager_t *mgr)
+    {
+        memset(mgr, 0, sizeof(*mgr));
+        mgr->flash_ops.erase_sector = &erase;
+        mgr->flash_ops.write_data   = &write;
+        mgr->flash_ops.read_data    = &read;
+#ifdef RTOS_MUTEX_ENABLE
+        mgr->flash_ops.mutex_lock   = &lock;
+        mgr->flash_ops.mutex_unlock = &unlock;
+#endif
+        mgr->rollts_max_size        = TEST_FLASH_SIZE;
+        return rollts_init(mgr) >= 0;
+    }
+};
+
+/* function-------------------------------------------------------------------*/
+typedef std::map<uint64_t, std::vector<uint8_t> > test_records_t;
+
+static test_records_t *test_collect;
+static uint8_t test_read_buf[16 * 1024];
+static uint8_t test_copy_buf[SINGLE_BLOCK_SIZE];
+
+static bool test_collect_cb(uint64_t seq, uint8_t *data, uint32_t len)
+{
+    (*test_collect)[seq] = std::vector<uint8_t>(data, data + len);
+    return true;
+}
+
+/**
+ * @func: 读取实例全部日志 序号 -> 负载
+ */
+static test_records_t test_dump(rollts_manager_t *mgr)
+{
+    test_records_t records;
+    test_collect = &records;
+    rollts_read_since(mgr, 0, test_read_buf, sizeof(test_read_buf), test_collect_cb);
+    test_collect = NULL;
+    return records;
+}
+
+/**
+ * @func: 比较 src/dst：同序号内容一致，dst 最旧序号之后的 src 日志均已复制，下一个序号一致
+ */
+static bool test_same(rollts_manager_t *src, rollts_manager_t *dst)
+{
+    test_records_t a = test_dump(src);
+    test_records_t b = test_dump(dst);
+    TEST_CHECK(!b.empty());
+    for (test_records_t::const_iterator it = b.begin(); it != b.end(); ++it)
+    {
+        test_records_t::const_iterator found = a.find(it->first);
+        TEST_CHECK(found == a.end() || found->second == it->second);
+    }
+    for (test_records_t::const_iterator it = a.lower_bound(b.begin()->first); it != a.end(); ++it)
+    {
+        TEST_CHECK(b.count(it->first));
+    }
+    TEST_CHECK(rollts_next_seq(src) == rollts_next_seq(dst));
+    return true;
+}
+
+/**
+ * @func: 写入一条 内容由编号和长度决定
+ */
+static bool test_add(rollts_manager_t *mgr, uint32_t id, uint32_t len)
+{
+    std::vector<uint8_t> payload(len);
+    for (uint32_t k = 0; k < len; k++)
+    {
+        payload[k] = (uint8_t)(id * 13 + k);
+    }
+    TEST_CHECK(rollts_add_tag(mgr, (uint8_t)(id % 5), payload.data(), len));
+    return true;
+}
+
+static bool test_replica(void)
+{
+    static rollts_manager_t src;
+    static rollts_manager_t dst;
+    uint32_t id = 0;
+
+    memset(test_flash, 0, sizeof(test_flash));
+    memset(test_flash[0].mem, 0xFF, TEST_FLASH_SIZE);
+    memset(test_flash[1].mem, 0xFF, TEST_FLASH_SIZE);
+    TEST_CHECK(TestFlash<0>::mount(&src));
+    TEST_CHECK(TestFlash<1>::mount(&dst));
+
+    rollts_replica_t replica;
+    memset(&replica, 0, sizeof(replica));
+    replica.src      = &src;
+    replica.dst      = &dst;
+    replica.buf      = test_copy_buf;
+    replica.buf_size = sizeof(test_copy_buf);
+
+    // 1. 首次复制：已封顶 block 整块拷贝
+    for (; id < 4000; id++)
+    {
+        TEST_CHECK(test_add(&src, id, 8 + id % 90));
+    }
+    int64_t lag = rollts_replica_lag(&replica);
+    TEST_CHECK(lag > 0);
+    uint32_t writes = test_flash[1].writes;
+    int32_t copied  = rollts_replicate(&replica, 1u << 30);
+    TEST_CHECK(copied > 0 && copied == lag);
+    TEST_CHECK(replica.block_copied > 0);
+    TEST_CHECK(test_flash[1].writes - writes < (uint32_t)copied / 4);
+    TEST_CHECK(0 == rollts_replica_lag(&replica));
+    TEST_CHECK(test_same(&src, &dst));
+    fprintf(test_out, "initial: %d records, %u blocks copied, %u records streamed, %u dst writes\n",
+            copied, replica.block_copied, replica.record_copied, test_flash[1].writes - writes);
+
+    // 2. 增量：写入块内的新日志逐条复制，只复制新增部分
+    uint32_t blocks  = replica.block_copied;
+    uint32_t records = replica.record_copied;
+    for (int k = 0; k < 100; k++, id++)
+    {
+        TEST_CHECK(test_add(&src, id, 20));
+    }
+    TEST_CHECK(100 == rollts_replica_lag(&replica));
+    TEST_CHECK(100 == rollts_replicate(&replica, 1000));
+    TEST_CHECK(blocks == replica.block_copied);
+    TEST_CHECK(records + 100 == replica.record_copied);
+    TEST_CHECK(0 == rollts_replicate(&replica, 1000));
+    TEST_CHECK(test_same(&src, &dst));
+
+    // 3. 复制预算与落后条数
+    for (int k = 0; k < 50; k++, id++)
+    {
+        TEST_CHECK(test_add(&src, id, 30));
+    }
+    TEST_CHECK(10 == rollts_replicate(&replica, 10));
+    TEST_CHECK(40 == rollts_replica_lag(&replica));
+    TEST_CHECK(40 == rollts_replicate(&replica, 100));
+    TEST_CHECK(0 == rollts_replica_lag(&replica));
+    TEST_CHECK(test_same(&src, &dst));
+
+    // 4. 持续写入，分批复制，block 封顶后整块拷贝
+    blocks = replica.block_copied;
+    for (int round = 0; round < 100; round++)
+    {
+        for (int k = 0; k < 50; k++, id++)
+        {
+            TEST_CHECK(test_add(&src, id, 8 + id % 90));
+        }
+        TEST_CHECK(rollts_replicate(&replica, 1u << 30) >= 0);
+    }
+    TEST_CHECK(0 == rollts_replica_lag(&replica));
+    TEST_CHECK(test_same(&src, &dst));
+    for (int k = 0; k < 3000; k++, id++)
+    {
+        TEST_CHECK(test_add(&src, id, 8 + id % 90));
+    }
+    blocks = replica.block_copied;
+    TEST_CHECK(rollts_replicate(&replica, 1u << 30) > 0);
+    TEST_CHECK(replica.block_copied > blocks);
+    TEST_CHECK(test_same(&src, &dst));
+
+    // 5. 重启续传：两个实例重新挂载，新的复制状态按 dst 下一个序号继续
+    for (int k = 0; k < 500; k++, id++)
+    {
+        TEST_CHECK(test_add(&src, id, 30));
+    }
+    static rollts_manager_t src2;
+    static rollts_manager_t dst2;
+    TEST_CHECK(TestFlash<0>::mount(&src2));
+    TEST_CHECK(TestFlash<1>::mount(&dst2));
+    rollts_replica_t resume;
+    memset(&resume, 0, sizeof(resume));
+    resume.src      = &src2;
+    resume.dst      = &dst2;
+    resume.buf      = test_copy_buf;
+    resume.buf_size = sizeof(test_copy_buf);
+    TEST_CHECK(500 == rollts_replica_lag(&resume));
+    TEST_CHECK(500 == rollts_replicate(&resume, 1u << 30));
+    TEST_CHECK(0 == rollts_replica_lag(&resume));
+    TEST_CHECK(test_same(&src2, &dst2));
+
+    // 6. 仅 dst 重启(如复制中掉电)后内容不变，可继续复制
+    static rollts_manager_t dst3;
+    TEST_CHECK(TestFlash<1>::mount(&dst3));
+    TEST_CHECK(test_same(&src2, &dst3));
+    resume.dst = &dst3;
+    for (int k = 0; k < 20; k++, id++)
+    {
+        TEST_CHECK(test_add(&src2, id, 30));
+    }
+    TEST_CHECK(20 == rollts_replicate(&resume, 1u << 30));
+    TEST_CHECK(test_same(&src2, &dst3));
+    fprintf(test_out, "total: %u blocks copied, %u records streamed, resync %u\n",
+            replica.block_copied + resume.block_copied, replica.record_copied + resume.record_copied,
+            replica.resync + resume.resync);
+    return true;
+}
+
+int main(void)
+{
+    // 结果写到原 stdout，rollDB 日志丢弃
+    test_out = fdopen(dup(STDOUT_FILENO), "w");
+    if (NULL == test_out || NULL == freopen("/dev/null", "w", stdout))
+    {
+        return 1;
+    }
+    bool ok = test_replica();
+    fprintf(test_out, "%s\n", ok ? "PASS" : "FAIL");
+    fclose(test_out);
+    return ok ? 0 : 1;
+}